@@ -0,0 +1,572 @@
+#include "archive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <print>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../fd/fd.h"
+#include "../itch/parser.h"
+#include "../replay/itch_file.h"
+#include "../util/binary_io.h"
+#include "varint.h"
+
+namespace
+{
+
+using archive::Column;
+
+constexpr std::size_t header_fields{10};
+
+// body length (after the type byte) of the messages stored as columns, 0 for the rest
+std::size_t columnar_length(itch::MessageType type)
+{
+    switch (type)
+    {
+    case itch::MessageType::AddOrder:
+        return 35;
+    case itch::MessageType::AddOrderMPID:
+        return 39;
+    case itch::MessageType::OrderExecuted:
+        return 30;
+    case itch::MessageType::OrderExecutedWithPrice:
+        return 35;
+    case itch::MessageType::OrderCancel:
+        return 22;
+    case itch::MessageType::OrderDelete:
+        return 18;
+    case itch::MessageType::OrderReplace:
+        return 34;
+    case itch::MessageType::Trade:
+        return 43;
+    default:
+        return 0;
+    }
+}
+
+bool write_all(int fd, std::span<const std::byte> bytes)
+{
+    while (!bytes.empty())
+    {
+        const auto written{::write(fd, bytes.data(), bytes.size())};
+        if (written < 0)
+        {
+            std::perror("write archive");
+            return false;
+        }
+        bytes = bytes.subspan(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+template <typename T>
+std::span<const std::byte> as_bytes(const T& value)
+{
+    return std::as_bytes(std::span{&value, 1});
+}
+
+template <typename T>
+void put_be(std::byte* out, std::size_t& pos, T value, std::size_t width = sizeof(T))
+{
+    for (std::size_t i = width; i-- > 0;)
+    {
+        out[pos++] = static_cast<std::byte>(value >> (8 * i));
+    }
+}
+
+class ChunkEncoder
+{
+  public:
+    void add(itch::MessageType type, std::span<const std::byte> body)
+    {
+        if (messages_++ == 0)
+        {
+            first_timestamp_ = body.size() >= header_fields ? read_timestamp(body) : 0;
+        }
+
+        const auto length{columnar_length(type)};
+        if (length == 0 || body.size() != length)
+        {
+            column(Column::Types).push_back(std::byte{0});
+            auto& raw{column(Column::Raw)};
+            archive::put_varint(raw, body.size() + 1);
+            raw.push_back(static_cast<std::byte>(type));
+            raw.insert(raw.end(), body.begin(), body.end());
+            return;
+        }
+
+        column(Column::Types).push_back(static_cast<std::byte>(type));
+        std::size_t pos{0};
+        const auto locate{util::extract_be<std::uint16_t>(body, pos)};
+        archive::put_varint(column(Column::Locates), locate);
+        archive::put_varint(column(Column::Tracking), util::extract_be<std::uint16_t>(body, pos));
+        const auto timestamp{read_timestamp(body)};
+        pos = header_fields;
+        archive::put_varint(column(Column::Timestamps), archive::zigzag(static_cast<std::int64_t>(timestamp - timestamp_)));
+        timestamp_ = timestamp;
+
+        switch (type)
+        {
+        case itch::MessageType::AddOrder:
+        case itch::MessageType::AddOrderMPID:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            column(Column::Flags).push_back(body[pos++]);
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            put_symbol(locate, body, pos);
+            archive::put_varint(column(Column::Prices), util::extract_be<std::uint32_t>(body, pos));
+            if (type == itch::MessageType::AddOrderMPID)
+            {
+                auto& attributions{column(Column::Attributions)};
+                attributions.insert(attributions.end(), body.begin() + static_cast<std::ptrdiff_t>(pos), body.end());
+            }
+            break;
+        case itch::MessageType::OrderExecuted:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            put_match(util::extract_be<std::uint64_t>(body, pos));
+            break;
+        case itch::MessageType::OrderExecutedWithPrice:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            put_match(util::extract_be<std::uint64_t>(body, pos));
+            column(Column::Flags).push_back(body[pos++]);
+            archive::put_varint(column(Column::Prices), util::extract_be<std::uint32_t>(body, pos));
+            break;
+        case itch::MessageType::OrderCancel:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            break;
+        case itch::MessageType::OrderDelete:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            break;
+        case itch::MessageType::OrderReplace:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            archive::put_varint(column(Column::Prices), util::extract_be<std::uint32_t>(body, pos));
+            break;
+        case itch::MessageType::Trade:
+            put_ref(util::extract_be<std::uint64_t>(body, pos));
+            column(Column::Flags).push_back(body[pos++]);
+            archive::put_varint(column(Column::Shares), util::extract_be<std::uint32_t>(body, pos));
+            put_symbol(locate, body, pos);
+            archive::put_varint(column(Column::Prices), util::extract_be<std::uint32_t>(body, pos));
+            put_match(util::extract_be<std::uint64_t>(body, pos));
+            break;
+        default:
+            break;
+        }
+    }
+
+    [[nodiscard]]
+    std::uint32_t messages() const noexcept
+    {
+        return messages_;
+    }
+
+    [[nodiscard]]
+    std::uint64_t first_timestamp() const noexcept
+    {
+        return first_timestamp_;
+    }
+
+    // header then columns in order, leaves the encoder ready for the next chunk
+    void finish(std::vector<std::byte>& out)
+    {
+        archive::ChunkHeader header{.messages = messages_, .column_bytes = {}};
+        for (std::size_t i = 0; i < archive::column_count; ++i)
+        {
+            header.column_bytes[i] = static_cast<std::uint32_t>(columns_[i].size());
+        }
+        const auto header_bytes{as_bytes(header)};
+        out.assign(header_bytes.begin(), header_bytes.end());
+        for (auto& column : columns_)
+        {
+            out.insert(out.end(), column.begin(), column.end());
+            column.clear();
+        }
+
+        messages_ = 0;
+        timestamp_ = 0;
+        ref_ = 0;
+        match_ = 0;
+        symbols_.clear();
+    }
+
+  private:
+    static std::uint64_t read_timestamp(std::span<const std::byte> body)
+    {
+        return itch::parse_message_header(body).timestamp;
+    }
+
+    std::vector<std::byte>& column(Column column)
+    {
+        return columns_[static_cast<std::size_t>(column)];
+    }
+
+    // refs and match numbers climb through the day, neighbours are close
+    void put_ref(std::uint64_t ref)
+    {
+        archive::put_varint(column(Column::Refs), archive::zigzag(static_cast<std::int64_t>(ref - ref_)));
+        ref_ = ref;
+    }
+
+    void put_match(std::uint64_t match)
+    {
+        archive::put_varint(column(Column::Matches), archive::zigzag(static_cast<std::int64_t>(match - match_)));
+        match_ = match;
+    }
+
+    // a locate's symbol goes out once per chunk, a 0 marker afterwards
+    void put_symbol(std::uint16_t locate, std::span<const std::byte> body, std::size_t& pos)
+    {
+        const auto symbol{util::extract<itch::Symbol>(body, pos)};
+        auto& symbols{column(Column::Symbols)};
+        const auto [it, inserted]{symbols_.try_emplace(locate, symbol)};
+        if (!inserted && it->second == symbol)
+        {
+            symbols.push_back(std::byte{0});
+            return;
+        }
+        it->second = symbol;
+        symbols.push_back(std::byte{1});
+        const auto bytes{as_bytes(symbol)};
+        symbols.insert(symbols.end(), bytes.begin(), bytes.end());
+    }
+
+    std::array<std::vector<std::byte>, archive::column_count> columns_;
+    std::uint32_t messages_{0};
+    std::uint64_t first_timestamp_{0};
+    std::uint64_t timestamp_{0};
+    std::uint64_t ref_{0};
+    std::uint64_t match_{0};
+    std::unordered_map<std::uint16_t, itch::Symbol> symbols_;
+};
+
+}
+
+namespace archive
+{
+
+std::string archive_path(const std::string& raw_path)
+{
+    return raw_path + ".l3a";
+}
+
+std::optional<Summary> compress(std::span<const std::byte> raw, const std::string& path, std::uint32_t chunk_messages)
+{
+    const int fd{::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+    if (fd < 0)
+    {
+        std::perror("open archive");
+        return std::nullopt;
+    }
+    const FD file{fd};
+
+    if (!write_all(file.fd(), as_bytes(magic)))
+    {
+        return std::nullopt;
+    }
+
+    Summary summary{};
+    summary.bytes = sizeof(magic);
+    std::vector<ChunkEntry> directory{};
+    std::vector<std::byte> buffer{};
+    ChunkEncoder encoder{};
+    bool ok{true};
+
+    const auto flush{[&] {
+        ChunkEntry entry{.offset = summary.bytes, .first_timestamp = encoder.first_timestamp(), .messages = encoder.messages(), .bytes = 0};
+        encoder.finish(buffer);
+        entry.bytes = static_cast<std::uint32_t>(buffer.size());
+        ok = ok && write_all(file.fd(), buffer);
+        summary.bytes += buffer.size();
+        directory.push_back(entry);
+    }};
+
+    replay::for_each_message(raw, [&](std::uint64_t offset, itch::MessageType type, std::span<const std::byte> body) {
+        encoder.add(type, body);
+        ++summary.messages;
+        summary.raw_bytes = offset + body.size() + 3;
+        if (encoder.messages() == chunk_messages)
+        {
+            flush();
+        }
+    });
+    if (encoder.messages() != 0)
+    {
+        flush();
+    }
+
+    // directory entries are read in place
+    const std::array<std::byte, alignof(ChunkEntry)> padding{};
+    const auto pad{(alignof(ChunkEntry) - summary.bytes % alignof(ChunkEntry)) % alignof(ChunkEntry)};
+    ok = ok && write_all(file.fd(), std::span{padding}.first(pad));
+    summary.bytes += pad;
+
+    const Footer footer{.directory_offset = summary.bytes,
+                        .chunk_count = directory.size(),
+                        .message_count = summary.messages,
+                        .raw_bytes = summary.raw_bytes,
+                        .magic = magic};
+    ok = ok && write_all(file.fd(), std::as_bytes(std::span{directory})) && write_all(file.fd(), as_bytes(footer));
+    if (!ok)
+    {
+        return std::nullopt;
+    }
+
+    summary.chunks = directory.size();
+    summary.bytes += directory.size() * sizeof(ChunkEntry) + sizeof(Footer);
+    return summary;
+}
+
+ChunkDecoder::ChunkDecoder(std::span<const std::byte> chunk)
+{
+    ChunkHeader header{};
+    if (chunk.size() < sizeof(header))
+    {
+        std::println(std::cerr, "archive chunk shorter than its header");
+        return;
+    }
+    std::memcpy(&header, chunk.data(), sizeof(header));
+
+    // the columns have to fit in the chunk, a corrupt one decodes as empty
+    std::size_t pos{sizeof(header)};
+    for (std::size_t i = 0; i < column_count; ++i)
+    {
+        if (header.column_bytes[i] > chunk.size() - pos)
+        {
+            std::println(std::cerr, "archive chunk columns overrun it");
+            columns_ = {};
+            return;
+        }
+        columns_[i] = chunk.subspan(pos, header.column_bytes[i]);
+        pos += header.column_bytes[i];
+    }
+    remaining_ = header.messages;
+}
+
+bool ChunkDecoder::next(itch::MessageType& type, std::span<const std::byte>& body)
+{
+    if (remaining_ == 0)
+    {
+        return false;
+    }
+    --remaining_;
+
+    // a read past a column's end leaves its cursor beyond it and the chunk is given up
+    bool overran{false};
+    const auto column{[&](Column c) -> std::span<const std::byte> { return columns_[static_cast<std::size_t>(c)]; }};
+    const auto cursor{[&](Column c) -> std::size_t& { return pos_[static_cast<std::size_t>(c)]; }};
+    const auto varint{[&](Column c) { return get_varint(column(c), cursor(c)); }};
+    const auto take{[&](Column c, std::size_t n) -> std::span<const std::byte> {
+        const auto from{column(c)};
+        auto& at{cursor(c)};
+        if (at > from.size() || n > from.size() - at)
+        {
+            at = from.size() + 1;
+            overran = true;
+            return {};
+        }
+        at += n;
+        return from.subspan(at - n, n);
+    }};
+    const auto byte{[&](Column c) {
+        const auto taken{take(c, 1)};
+        return taken.empty() ? std::byte{0} : taken[0];
+    }};
+    const auto corrupt{[&] {
+        std::println(std::cerr, "corrupt archive chunk, {} messages left undecoded", remaining_ + 1);
+        remaining_ = 0;
+        return false;
+    }};
+
+    const auto raw_type{byte(Column::Types)};
+    if (overran)
+    {
+        return corrupt();
+    }
+    if (raw_type == std::byte{0})
+    {
+        const auto length{static_cast<std::size_t>(varint(Column::Raw))};
+        const auto record{take(Column::Raw, length)};
+        if (record.empty())
+        {
+            return corrupt();
+        }
+        type = static_cast<itch::MessageType>(record[0]);
+        body = record.subspan(1);
+        return true;
+    }
+
+    type = static_cast<itch::MessageType>(raw_type);
+    auto* out{message_.data()};
+    std::size_t pos{0};
+
+    const auto locate{static_cast<std::uint16_t>(varint(Column::Locates))};
+    put_be(out, pos, locate);
+    put_be(out, pos, static_cast<std::uint16_t>(varint(Column::Tracking)));
+    timestamp_ += static_cast<std::uint64_t>(unzigzag(varint(Column::Timestamps)));
+    put_be(out, pos, timestamp_, 6);
+
+    const auto ref{[&] {
+        ref_ += static_cast<std::uint64_t>(unzigzag(varint(Column::Refs)));
+        put_be(out, pos, ref_);
+    }};
+    const auto match{[&] {
+        match_ += static_cast<std::uint64_t>(unzigzag(varint(Column::Matches)));
+        put_be(out, pos, match_);
+    }};
+    const auto u32{[&](Column c) { put_be(out, pos, static_cast<std::uint32_t>(varint(c))); }};
+    const auto flag{[&] { out[pos++] = byte(Column::Flags); }};
+    const auto symbol{[&] {
+        if (byte(Column::Symbols) != std::byte{0})
+        {
+            auto& cached{symbols_[locate]};
+            if (const auto fresh{take(Column::Symbols, cached.size())}; !fresh.empty())
+            {
+                std::memcpy(cached.data(), fresh.data(), cached.size());
+            }
+        }
+        std::memcpy(out + pos, symbols_[locate].data(), sizeof(itch::Symbol));
+        pos += sizeof(itch::Symbol);
+    }};
+
+    switch (type)
+    {
+    case itch::MessageType::AddOrder:
+    case itch::MessageType::AddOrderMPID:
+        ref();
+        flag();
+        u32(Column::Shares);
+        symbol();
+        u32(Column::Prices);
+        if (type == itch::MessageType::AddOrderMPID)
+        {
+            if (const auto mpid{take(Column::Attributions, sizeof(itch::MPID))}; !mpid.empty())
+            {
+                std::memcpy(out + pos, mpid.data(), mpid.size());
+            }
+            pos += sizeof(itch::MPID);
+        }
+        break;
+    case itch::MessageType::OrderExecuted:
+        ref();
+        u32(Column::Shares);
+        match();
+        break;
+    case itch::MessageType::OrderExecutedWithPrice:
+        ref();
+        u32(Column::Shares);
+        match();
+        flag();
+        u32(Column::Prices);
+        break;
+    case itch::MessageType::OrderCancel:
+        ref();
+        u32(Column::Shares);
+        break;
+    case itch::MessageType::OrderDelete:
+        ref();
+        break;
+    case itch::MessageType::OrderReplace:
+        ref();
+        ref();
+        u32(Column::Shares);
+        u32(Column::Prices);
+        break;
+    case itch::MessageType::Trade:
+        ref();
+        flag();
+        u32(Column::Shares);
+        symbol();
+        u32(Column::Prices);
+        match();
+        break;
+    default:
+        // only the types above are stored as columns
+        return corrupt();
+    }
+
+    for (std::size_t i = 0; i < column_count; ++i)
+    {
+        overran = overran || pos_[i] > columns_[i].size();
+    }
+    if (overran)
+    {
+        return corrupt();
+    }
+    body = std::span{message_}.first(pos);
+    return true;
+}
+
+bool Reader::is_archive(std::span<const std::byte> bytes)
+{
+    return bytes.size() >= sizeof(magic) + sizeof(Footer) && std::memcmp(bytes.data(), magic.data(), magic.size()) == 0;
+}
+
+std::optional<Reader> Reader::open(replay::MappedFile file)
+{
+    const auto bytes{file.bytes()};
+    Footer footer{};
+    if (is_archive(bytes))
+    {
+        std::memcpy(&footer, bytes.data() + bytes.size() - sizeof(Footer), sizeof(Footer));
+    }
+    if (footer.magic != magic || footer.directory_offset % alignof(ChunkEntry) != 0 || footer.directory_offset < sizeof(magic) ||
+        footer.chunk_count > bytes.size() / sizeof(ChunkEntry) ||
+        footer.directory_offset + footer.chunk_count * sizeof(ChunkEntry) + sizeof(Footer) != bytes.size())
+    {
+        std::println(std::cerr, "not a complete archive");
+        return std::nullopt;
+    }
+
+    // every chunk has to lie between the magic and the directory
+    const std::span directory{reinterpret_cast<const ChunkEntry*>(bytes.data() + footer.directory_offset), footer.chunk_count};
+    for (const auto& entry : directory)
+    {
+        if (entry.offset < sizeof(magic) || entry.offset > footer.directory_offset || entry.bytes < sizeof(ChunkHeader) ||
+            entry.bytes > footer.directory_offset - entry.offset)
+        {
+            std::println(std::cerr, "archive chunk {} lies outside the chunks", &entry - directory.data());
+            return std::nullopt;
+        }
+    }
+    return Reader{std::move(file), footer};
+}
+
+Reader::Reader(replay::MappedFile file, const Footer& footer)
+    : file_{std::move(file)},
+      footer_{footer},
+      directory_{reinterpret_cast<const ChunkEntry*>(file_.bytes().data() + footer.directory_offset), footer.chunk_count}
+{
+}
+
+const Footer& Reader::footer() const noexcept
+{
+    return footer_;
+}
+
+std::size_t Reader::chunk_count() const noexcept
+{
+    return directory_.size();
+}
+
+std::size_t Reader::chunk_at(std::uint64_t ns) const
+{
+    const auto first{std::ranges::lower_bound(directory_, ns, {}, &ChunkEntry::first_timestamp)};
+    return first == directory_.begin() ? 0 : static_cast<std::size_t>(first - directory_.begin() - 1);
+}
+
+ChunkDecoder Reader::chunk(std::size_t index) const
+{
+    const auto& entry{directory_[index]};
+    return ChunkDecoder{file_.bytes().subspan(entry.offset, entry.bytes)};
+}
+
+}
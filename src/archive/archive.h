@@ -0,0 +1,143 @@
+#ifndef ARCHIVE_ARCHIVE_H_
+#define ARCHIVE_ARCHIVE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "../itch/types.h"
+#include "../replay/mapped_file.h"
+
+namespace archive
+{
+
+inline constexpr std::array<char, 8> magic{'L', '3', 'A', 'R', 'C', '0', '0', '1'};
+
+// per-chunk streams, book and trade messages are split field by field
+enum class Column : std::uint8_t
+{
+    Types,
+    Locates,
+    Tracking,
+    Timestamps,
+    Refs,
+    Shares,
+    Prices,
+    Matches,
+    Flags,
+    Symbols,
+    Attributions,
+    // anything else, length prefixed and verbatim
+    Raw,
+    Count
+};
+
+inline constexpr std::size_t column_count{static_cast<std::size_t>(Column::Count)};
+
+struct ChunkHeader
+{
+    std::uint32_t messages;
+    std::array<std::uint32_t, column_count> column_bytes;
+};
+
+struct ChunkEntry
+{
+    std::uint64_t offset;
+    std::uint64_t first_timestamp;
+    std::uint32_t messages;
+    std::uint32_t bytes;
+};
+
+// at the very end, a torn file has none
+struct Footer
+{
+    std::uint64_t directory_offset;
+    std::uint64_t chunk_count;
+    std::uint64_t message_count;
+    std::uint64_t raw_bytes;
+    std::array<char, 8> magic;
+};
+
+struct Summary
+{
+    std::uint64_t messages;
+    std::size_t chunks;
+    std::size_t raw_bytes;
+    std::size_t bytes;
+};
+
+// <file>.l3a
+std::string archive_path(const std::string& raw_path);
+
+// BinaryFILE -> archive, chunk_messages per independently decodable chunk
+std::optional<Summary> compress(std::span<const std::byte> raw, const std::string& path, std::uint32_t chunk_messages = 65536);
+
+// rebuilds one chunk's messages byte for byte, as for_each_message would hand them out
+class ChunkDecoder
+{
+  public:
+    // a chunk whose columns do not fit in it decodes as empty
+    explicit ChunkDecoder(std::span<const std::byte> chunk);
+
+    // false once the chunk is exhausted or turns out corrupt, body stays valid until the next call
+    bool next(itch::MessageType& type, std::span<const std::byte>& body);
+
+  private:
+    std::array<std::span<const std::byte>, column_count> columns_;
+    std::array<std::size_t, column_count> pos_{};
+    std::uint32_t remaining_{0};
+    std::uint64_t timestamp_{0};
+    std::uint64_t ref_{0};
+    std::uint64_t match_{0};
+    std::unordered_map<std::uint16_t, itch::Symbol> symbols_;
+    std::array<std::byte, 64> message_{};
+};
+
+class Reader
+{
+  public:
+    [[nodiscard]]
+    static bool is_archive(std::span<const std::byte> bytes);
+    static std::optional<Reader> open(replay::MappedFile file);
+
+    [[nodiscard]]
+    const Footer& footer() const noexcept;
+    [[nodiscard]]
+    std::size_t chunk_count() const noexcept;
+    // a replay of everything stamped from ns on starts here, chunks can split equal stamps
+    [[nodiscard]]
+    std::size_t chunk_at(std::uint64_t ns) const;
+    [[nodiscard]]
+    ChunkDecoder chunk(std::size_t index) const;
+
+    // fn(type, body) for every message from first_chunk on
+    template <typename Fn>
+    void for_each(Fn&& fn, std::size_t first_chunk = 0) const
+    {
+        itch::MessageType type{};
+        std::span<const std::byte> body{};
+        for (auto i = first_chunk; i < chunk_count(); ++i)
+        {
+            auto decoder{chunk(i)};
+            while (decoder.next(type, body))
+            {
+                fn(type, body);
+            }
+        }
+    }
+
+  private:
+    Reader(replay::MappedFile file, const Footer& footer);
+
+    replay::MappedFile file_;
+    Footer footer_;
+    std::span<const ChunkEntry> directory_;
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef ARCHIVE_VARINT_H_
+#define ARCHIVE_VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace archive
+{
+
+inline constexpr std::size_t max_varint_bytes{10};
+
+// little-endian base 128, 7 bits per byte, high bit set on all but the last
+inline void put_varint(std::vector<std::byte>& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::byte>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(value));
+}
+
+// 0 with pos past the end of in if the varint runs off it or over 64 bits
+inline std::uint64_t get_varint(std::span<const std::byte> in, std::size_t& pos)
+{
+    std::uint64_t value{0};
+    // room for the longest varint, no need to look at the end
+    if (pos <= in.size() && in.size() - pos >= max_varint_bytes)
+    {
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            const auto byte{std::to_integer<std::uint64_t>(in[pos++])};
+            value |= (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        pos = in.size() + 1;
+        return 0;
+    }
+    for (unsigned shift = 0; pos < in.size() && shift < 64; shift += 7)
+    {
+        const auto byte{std::to_integer<std::uint64_t>(in[pos++])};
+        value |= (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+    pos = in.size() + 1;
+    return 0;
+}
+
+// small magnitudes of either sign stay small
+constexpr std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "auction.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+constexpr std::size_t locates{std::numeric_limits<std::uint16_t>::max() + 1UL};
+
+bool has_imbalance(itch::ImbalanceDirection direction)
+{
+    return direction == itch::ImbalanceDirection::BuyImbalance || direction == itch::ImbalanceDirection::SellImbalance;
+}
+
+}
+
+namespace book
+{
+
+const Indication& Auction::indication(std::size_t back) const noexcept
+{
+    return history[(indications - 1 - back) % history_size];
+}
+
+AuctionTable::AuctionTable()
+    : auctions_{std::make_unique_for_overwrite<Auction[]>(locates)},
+      tracked_(locates, 0),
+      imbalance_shares_(locates, 0),
+      directions_(locates, itch::ImbalanceDirection::NoImbalance),
+      cross_types_(locates, itch::CrossType::Opening)
+{
+}
+
+Auction& AuctionTable::slot(std::uint16_t locate)
+{
+    auto& auction{auctions_[locate]};
+    if (tracked_[locate] == 0)
+    {
+        auction = Auction{.locate = locate,
+                          .timestamp = 0,
+                          .paired_shares = 0,
+                          .imbalance_shares = 0,
+                          .direction = itch::ImbalanceDirection::NoImbalance,
+                          .cross_type = itch::CrossType::Opening,
+                          .price_variation = itch::PriceVariationIndicator::CannotCalculate,
+                          .history = {},
+                          .indications = 0,
+                          .cross_price = 0,
+                          .cross_shares = 0,
+                          .crossed = itch::CrossType::Opening,
+                          .near_execution_price = 0,
+                          .near_execution_time = 0,
+                          .min_allowed_price = 0,
+                          .max_allowed_price = 0,
+                          .lower_collar = 0,
+                          .upper_collar = 0,
+                          .open_eligibility = itch::OpenEligibility::NotEligible};
+        tracked_[locate] = 1;
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return auction;
+}
+
+void AuctionTable::on_noii(const itch::NOIIMessage& msg)
+{
+    auto& auction{slot(msg.header.stock_locate)};
+    auction.timestamp = msg.header.timestamp;
+    auction.paired_shares = msg.paired_shares;
+    auction.imbalance_shares = msg.imbalance_shares;
+    auction.direction = msg.imbalance_direction;
+    auction.cross_type = msg.cross_type;
+    auction.price_variation = msg.price_variation_indicator;
+    auction.history[auction.indications % Auction::history_size] = Indication{.timestamp = msg.header.timestamp,
+                                                                              .far_price = msg.far_price,
+                                                                              .near_price = msg.near_price,
+                                                                              .reference_price = msg.current_reference_price};
+    ++auction.indications;
+
+    const auto locate{msg.header.stock_locate};
+    imbalance_shares_[locate] = msg.imbalance_shares;
+    directions_[locate] = msg.imbalance_direction;
+    cross_types_[locate] = msg.cross_type;
+}
+
+void AuctionTable::on_cross_trade(const itch::CrossTradeMessage& msg)
+{
+    auto& auction{slot(msg.header.stock_locate)};
+    auction.cross_price = msg.cross_price;
+    auction.cross_shares = msg.shares;
+    auction.crossed = msg.type;
+}
+
+void AuctionTable::on_direct_listing(const itch::DirectListingPriceDiscoveryMessage& msg)
+{
+    auto& auction{slot(msg.header.stock_locate)};
+    auction.near_execution_price = msg.near_execution_price;
+    auction.near_execution_time = msg.near_execution_time;
+    auction.min_allowed_price = msg.min_allowed_price;
+    auction.max_allowed_price = msg.max_allowed_price;
+    auction.lower_collar = msg.lower_price_range_collar;
+    auction.upper_collar = msg.upper_price_range_collar;
+    auction.open_eligibility = msg.open_eligibility;
+}
+
+const Auction* AuctionTable::find(std::uint16_t locate) const noexcept
+{
+    return tracked_[locate] == 0 ? nullptr : &auctions_[locate];
+}
+
+std::size_t AuctionTable::size() const noexcept
+{
+    return size_.load(std::memory_order_relaxed);
+}
+
+std::size_t AuctionTable::imbalanced(itch::CrossType cross, std::uint64_t min_shares, std::span<std::uint16_t> out) const
+{
+    std::size_t count{0};
+    for (std::size_t i = 0; i < imbalance_shares_.size() && count < out.size(); ++i)
+    {
+        if (cross_types_[i] == cross && has_imbalance(directions_[i]) && imbalance_shares_[i] >= min_shares)
+        {
+            out[count++] = static_cast<std::uint16_t>(i);
+        }
+    }
+    return count;
+}
+
+std::size_t AuctionTable::largest_imbalances(itch::CrossType cross, std::span<std::uint16_t> out) const
+{
+    if (out.empty())
+    {
+        return 0;
+    }
+
+    // min-heap on imbalance, ties to the higher locate so the lower one survives
+    const auto larger{[&](std::uint16_t a, std::uint16_t b) {
+        return imbalance_shares_[a] > imbalance_shares_[b] || (imbalance_shares_[a] == imbalance_shares_[b] && a < b);
+    }};
+
+    std::size_t count{0};
+    for (std::size_t i = 0; i < imbalance_shares_.size(); ++i)
+    {
+        if (cross_types_[i] != cross || !has_imbalance(directions_[i]))
+        {
+            continue;
+        }
+        const auto index{static_cast<std::uint16_t>(i)};
+        if (count < out.size())
+        {
+            out[count++] = index;
+            std::ranges::push_heap(out.first(count), larger);
+        }
+        else if (larger(index, out.front()))
+        {
+            std::ranges::pop_heap(out, larger);
+            out.back() = index;
+            std::ranges::push_heap(out, larger);
+        }
+    }
+
+    std::ranges::sort_heap(out.first(count), larger);
+    return count;
+}
+
+}
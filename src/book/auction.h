@@ -0,0 +1,100 @@
+#ifndef BOOK_AUCTION_H_
+#define BOOK_AUCTION_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "../itch/messages_auction.h"
+#include "../itch/messages_trade.h"
+
+namespace book
+{
+
+// one net order imbalance indication's prices
+struct Indication
+{
+    std::uint64_t timestamp;
+    std::uint32_t far_price;
+    std::uint32_t near_price;
+    std::uint32_t reference_price;
+};
+
+struct Auction
+{
+    std::uint16_t locate;
+    // latest noii
+    std::uint64_t timestamp;
+    std::uint64_t paired_shares;
+    std::uint64_t imbalance_shares;
+    itch::ImbalanceDirection direction;
+    itch::CrossType cross_type;
+    itch::PriceVariationIndicator price_variation;
+    // the last history_size indications as a ring, indications counts every one seen
+    static constexpr std::size_t history_size{8};
+    std::array<Indication, history_size> history;
+    std::uint32_t indications;
+    // set by the cross trade, cross_price 0 until then
+    std::uint32_t cross_price;
+    std::uint64_t cross_shares;
+    itch::CrossType crossed;
+    // direct listing price discovery, near_execution_price 0 until one arrives
+    std::uint32_t near_execution_price;
+    std::uint64_t near_execution_time;
+    std::uint32_t min_allowed_price;
+    std::uint32_t max_allowed_price;
+    std::uint32_t lower_collar;
+    std::uint32_t upper_collar;
+    itch::OpenEligibility open_eligibility;
+
+    // newest first, back = 0 .. min(indications, history_size) - 1
+    [[nodiscard]]
+    const Indication& indication(std::size_t back) const noexcept;
+};
+
+// per-locate auction state, every locate has its slot and its place in the scan columns from the
+// start, so a noii burst never allocates and receivers on different channels never resize anything
+// they share; a slot's pages are only touched once its locate sees an auction message
+class AuctionTable
+{
+  public:
+    AuctionTable();
+
+    void on_noii(const itch::NOIIMessage& msg);
+    void on_cross_trade(const itch::CrossTradeMessage& msg);
+    void on_direct_listing(const itch::DirectListingPriceDiscoveryMessage& msg);
+
+    // nullptr until the locate sees an auction message
+    [[nodiscard]]
+    const Auction* find(std::uint16_t locate) const noexcept;
+    // locates tracked so far
+    [[nodiscard]]
+    std::size_t size() const noexcept;
+
+    // scans run over the columns and fill out in locate order, stopping once out is full
+
+    // latest noii for cross has a buy or sell imbalance of at least min_shares
+    std::size_t imbalanced(itch::CrossType cross, std::uint64_t min_shares, std::span<std::uint16_t> out) const;
+    // the out.size() largest buy or sell imbalances for cross, largest first
+    std::size_t largest_imbalances(itch::CrossType cross, std::span<std::uint16_t> out) const;
+
+  private:
+    Auction& slot(std::uint16_t locate);
+
+    // by locate; each is only written by the receiver whose channel carries the locate
+    std::unique_ptr<Auction[]> auctions_;
+    std::vector<std::uint8_t> tracked_;
+    // scan columns by locate, mirrored from the latest noii
+    std::vector<std::uint64_t> imbalance_shares_;
+    std::vector<itch::ImbalanceDirection> directions_;
+    std::vector<itch::CrossType> cross_types_;
+    std::atomic<std::size_t> size_{0};
+};
+
+}
+
+#endif
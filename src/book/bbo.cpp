@@ -0,0 +1,261 @@
+#include "bbo.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+#if defined(__AVX512F__)
+constexpr std::size_t lanes{16};
+#elif defined(__AVX2__)
+constexpr std::size_t lanes{8};
+#else
+constexpr std::size_t lanes{1};
+#endif
+
+static_assert(book::BboTable::size % lanes == 0);
+
+std::uint32_t saturate(std::uint64_t shares)
+{
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(shares, std::numeric_limits<std::uint32_t>::max()));
+}
+
+// appends base + each set bit of mask, false once out is full
+bool emit(std::uint32_t mask, std::size_t base, std::span<std::uint16_t> out, std::size_t& count)
+{
+    for (; mask != 0; mask &= mask - 1)
+    {
+        if (count == out.size())
+        {
+            return false;
+        }
+        out[count++] = static_cast<std::uint16_t>(base + static_cast<std::size_t>(std::countr_zero(mask)));
+    }
+    return true;
+}
+
+#if defined(__AVX512F__)
+
+__m512i load(const std::uint32_t* p)
+{
+    return _mm512_load_si512(p);
+}
+
+// bit per lane, where both sides are present
+std::uint32_t two_sided(__m512i bid, __m512i ask)
+{
+    const auto zero{_mm512_setzero_si512()};
+    return _mm512_cmpneq_epu32_mask(bid, zero) & _mm512_cmpneq_epu32_mask(ask, zero);
+}
+
+#elif defined(__AVX2__)
+
+__m256i load(const std::uint32_t* p)
+{
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+std::uint32_t lane_mask(__m256i v)
+{
+    return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+}
+
+std::uint32_t two_sided(__m256i bid, __m256i ask)
+{
+    const auto zero{_mm256_setzero_si256()};
+    const auto empty{_mm256_or_si256(_mm256_cmpeq_epi32(bid, zero), _mm256_cmpeq_epi32(ask, zero))};
+    return ~lane_mask(empty) & 0xffU;
+}
+
+#endif
+
+// bit per lane with a two-sided, uncrossed spread of at least min_spread
+std::uint32_t wide_mask(const book::BboTable& table, std::size_t i, std::uint32_t min_spread)
+{
+#if defined(__AVX512F__)
+    const auto bid{load(&table.bid_price[i])};
+    const auto ask{load(&table.ask_price[i])};
+    const auto spread{_mm512_sub_epi32(ask, bid)};
+    return two_sided(bid, ask) & _mm512_cmpgt_epi32_mask(ask, bid) &
+           _mm512_cmpge_epu32_mask(spread, _mm512_set1_epi32(static_cast<int>(min_spread)));
+#elif defined(__AVX2__)
+    const auto bid{load(&table.bid_price[i])};
+    const auto ask{load(&table.ask_price[i])};
+    const auto spread{_mm256_sub_epi32(ask, bid)};
+    // spread >= min as max(spread, min) == spread, unsigned
+    const auto wide{_mm256_cmpeq_epi32(_mm256_max_epu32(spread, _mm256_set1_epi32(static_cast<int>(min_spread))), spread)};
+    return two_sided(bid, ask) & lane_mask(_mm256_cmpgt_epi32(ask, bid)) & lane_mask(wide);
+#else
+    const auto bid{table.bid_price[i]};
+    const auto ask{table.ask_price[i]};
+    return bid != 0 && ask > bid && ask - bid >= min_spread ? 1U : 0U;
+#endif
+}
+
+}
+
+namespace book
+{
+
+void BboTable::update(std::uint16_t locate, const std::optional<Level>& bid, const std::optional<Level>& ask) noexcept
+{
+    bid_price[locate] = bid ? bid->price : 0;
+    bid_shares[locate] = bid ? saturate(bid->shares) : 0;
+    ask_price[locate] = ask ? ask->price : 0;
+    ask_shares[locate] = ask ? saturate(ask->shares) : 0;
+}
+
+std::size_t crossed_or_locked(const BboTable& table, std::span<std::uint16_t> out)
+{
+    std::size_t count{0};
+    for (std::size_t i = 0; i < BboTable::size; i += lanes)
+    {
+#if defined(__AVX512F__)
+        const auto bid{load(&table.bid_price[i])};
+        const auto ask{load(&table.ask_price[i])};
+        const std::uint32_t mask{two_sided(bid, ask) & _mm512_cmpge_epu32_mask(bid, ask)};
+#elif defined(__AVX2__)
+        const auto bid{load(&table.bid_price[i])};
+        const auto ask{load(&table.ask_price[i])};
+        const std::uint32_t mask{two_sided(bid, ask) & ~lane_mask(_mm256_cmpgt_epi32(ask, bid))};
+#else
+        const auto bid{table.bid_price[i]};
+        const auto ask{table.ask_price[i]};
+        const std::uint32_t mask{bid != 0 && ask != 0 && bid >= ask ? 1U : 0U};
+#endif
+        if (mask != 0 && !emit(mask, i, out, count))
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+std::size_t bids_above(const BboTable& table, std::uint32_t price, std::span<std::uint16_t> out)
+{
+    std::size_t count{0};
+    for (std::size_t i = 0; i < BboTable::size; i += lanes)
+    {
+#if defined(__AVX512F__)
+        const std::uint32_t mask{_mm512_cmpgt_epu32_mask(load(&table.bid_price[i]), _mm512_set1_epi32(static_cast<int>(price)))};
+#elif defined(__AVX2__)
+        const auto bid{load(&table.bid_price[i])};
+        const auto bound{_mm256_set1_epi32(static_cast<int>(price))};
+        // bid > price as max(bid, price) == bid and bid != price, unsigned
+        const auto at_least{_mm256_cmpeq_epi32(_mm256_max_epu32(bid, bound), bid)};
+        const std::uint32_t mask{lane_mask(at_least) & ~lane_mask(_mm256_cmpeq_epi32(bid, bound))};
+#else
+        const std::uint32_t mask{table.bid_price[i] > price ? 1U : 0U};
+#endif
+        if (mask != 0 && !emit(mask, i, out, count))
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+std::size_t spreads_at_least(const BboTable& table, std::uint32_t min_spread, std::span<std::uint16_t> out)
+{
+    std::size_t count{0};
+    for (std::size_t i = 0; i < BboTable::size; i += lanes)
+    {
+        const auto mask{wide_mask(table, i, min_spread)};
+        if (mask != 0 && !emit(mask, i, out, count))
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+std::size_t widest_spreads(const BboTable& table, std::span<std::uint16_t> out)
+{
+    if (out.empty())
+    {
+        return 0;
+    }
+
+    const auto spread{[&](std::uint16_t locate) { return table.ask_price[locate] - table.bid_price[locate]; }};
+    // min-heap on spread, ties to the higher locate so the lower one survives
+    const auto wider{[&](std::uint16_t a, std::uint16_t b) { return spread(a) > spread(b) || (spread(a) == spread(b) && a < b); }};
+
+    std::size_t count{0};
+    std::uint32_t floor{1};
+    for (std::size_t i = 0; i < BboTable::size; i += lanes)
+    {
+        // whole blocks narrower than the current floor never touch the heap
+        for (auto mask{wide_mask(table, i, floor)}; mask != 0; mask &= mask - 1)
+        {
+            const auto locate{static_cast<std::uint16_t>(i + static_cast<std::size_t>(std::countr_zero(mask)))};
+            if (count < out.size())
+            {
+                out[count++] = locate;
+                std::ranges::push_heap(out.first(count), wider);
+            }
+            else if (wider(locate, out.front()))
+            {
+                std::ranges::pop_heap(out, wider);
+                out.back() = locate;
+                std::ranges::push_heap(out, wider);
+            }
+            if (count == out.size())
+            {
+                floor = spread(out.front());
+            }
+        }
+    }
+
+    std::ranges::sort_heap(out.first(count), wider);
+    return count;
+}
+
+std::uint64_t resting_notional(const BboTable& table)
+{
+#if defined(__AVX512F__) || defined(__AVX2__)
+    // even and odd lanes widened to 64 bit products separately
+#if defined(__AVX512F__)
+    auto sum{_mm512_setzero_si512()};
+    const auto product{[](__m512i price, __m512i shares) {
+        return _mm512_add_epi64(_mm512_mul_epu32(price, shares),
+                                _mm512_mul_epu32(_mm512_srli_epi64(price, 32), _mm512_srli_epi64(shares, 32)));
+    }};
+    const auto add{[](__m512i a, __m512i b) { return _mm512_add_epi64(a, b); }};
+#else
+    auto sum{_mm256_setzero_si256()};
+    const auto product{[](__m256i price, __m256i shares) {
+        return _mm256_add_epi64(_mm256_mul_epu32(price, shares),
+                                _mm256_mul_epu32(_mm256_srli_epi64(price, 32), _mm256_srli_epi64(shares, 32)));
+    }};
+    const auto add{[](__m256i a, __m256i b) { return _mm256_add_epi64(a, b); }};
+#endif
+    for (std::size_t i = 0; i < BboTable::size; i += lanes)
+    {
+        sum = add(sum, product(load(&table.bid_price[i]), load(&table.bid_shares[i])));
+        sum = add(sum, product(load(&table.ask_price[i]), load(&table.ask_shares[i])));
+    }
+    alignas(64) std::array<std::uint64_t, lanes / 2> parts{};
+    std::memcpy(parts.data(), &sum, sizeof(sum));
+    std::uint64_t total{0};
+    for (const auto part : parts)
+    {
+        total += part;
+    }
+    return total;
+#else
+    std::uint64_t total{0};
+    for (std::size_t i = 0; i < BboTable::size; ++i)
+    {
+        total += std::uint64_t{table.bid_price[i]} * table.bid_shares[i] + std::uint64_t{table.ask_price[i]} * table.ask_shares[i];
+    }
+    return total;
+#endif
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef BOOK_BBO_H_
+#define BOOK_BBO_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+
+#include "book.h"
+
+namespace book
+{
+
+// per-locate best bid/ask as parallel arrays for market-wide scans
+// price 0 means the side is empty, shares saturate at u32 max, prices stay below 2^31
+struct BboTable
+{
+    static constexpr std::size_t size{std::numeric_limits<std::uint16_t>::max() + 1UL};
+
+    alignas(64) std::array<std::uint32_t, size> bid_price{};
+    alignas(64) std::array<std::uint32_t, size> bid_shares{};
+    alignas(64) std::array<std::uint32_t, size> ask_price{};
+    alignas(64) std::array<std::uint32_t, size> ask_shares{};
+
+    void update(std::uint16_t locate, const std::optional<Level>& bid, const std::optional<Level>& ask) noexcept;
+};
+
+// scans fill out with matching locates in ascending order and return how many matched,
+// stopping once out is full; read on the thread that applies the books
+
+// bid >= ask with both sides present
+std::size_t crossed_or_locked(const BboTable& table, std::span<std::uint16_t> out);
+// best bid strictly above price
+std::size_t bids_above(const BboTable& table, std::uint32_t price, std::span<std::uint16_t> out);
+// ask - bid >= min_spread with both sides present and not crossed
+std::size_t spreads_at_least(const BboTable& table, std::uint32_t min_spread, std::span<std::uint16_t> out);
+// the out.size() widest two-sided spreads, widest first
+std::size_t widest_spreads(const BboTable& table, std::span<std::uint16_t> out);
+// sum of price * shares over both top levels, in price ticks
+std::uint64_t resting_notional(const BboTable& table);
+
+}
+
+#endif
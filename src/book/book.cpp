@@ -1,40 +1,311 @@
 #include "book.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+// level is the aggregate after a change at its price, orders == 0 once it is gone
+template <typename Levels>
+void update_depth(const Levels& levels, std::pmr::vector<book::Level>& depth, const book::Level& level)
+{
+    if (depth.capacity() < book::max_depth)
+    {
+        depth.reserve(book::max_depth);
+    }
+
+    const auto it{std::ranges::lower_bound(depth, level.price, levels.key_comp(), &book::Level::price)};
+    if (it != depth.end() && it->price == level.price)
+    {
+        if (level.orders != 0)
+        {
+            *it = level;
+            return;
+        }
+        depth.erase(it);
+        // the first level past the cached ones moves up
+        if (levels.size() > depth.size())
+        {
+            depth.push_back(*(depth.empty() ? levels.best() : levels.next_worse(depth.back().price)));
+        }
+        return;
+    }
+
+    if (level.orders == 0 || (it == depth.end() && depth.size() == book::max_depth))
+    {
+        return;
+    }
+    // pop_back invalidates it when it is the last slot
+    const auto at{it - depth.begin()};
+    if (depth.size() == book::max_depth)
+    {
+        depth.pop_back();
+    }
+    depth.insert(depth.begin() + at, level);
+}
+
+std::uint64_t queue_key(itch::Side side, std::uint32_t price)
+{
+    return (std::uint64_t{side == itch::Side::Sell} << 32) | price;
+}
+
+}
+
 namespace book
 {
-void Book::add(std::uint64_t ref_num, std::uint32_t shares, std::uint32_t price, itch::Side side)
+
+template <DepthPolicy Policy>
+BasicBook<Policy>::BasicBook(const allocator_type& alloc)
+    : orders_{alloc},
+      attributions_{alloc},
+      bids_{alloc},
+      asks_{alloc},
+      bid_depth_{alloc},
+      ask_depth_{alloc},
+      queues_{alloc}
 {
-    orders_.insert({ref_num, Order{.shares = shares, .price = price, .side = side}});
 }
 
-void Book::reduce(std::uint64_t ref_num, std::uint32_t shares)
+template <DepthPolicy Policy>
+std::optional<Change> BasicBook<Policy>::add(std::uint64_t ref_num,
+                                             std::uint32_t shares,
+                                             std::uint32_t price,
+                                             itch::Side side,
+                                             std::optional<itch::MPID> attribution)
 {
-    if (const auto it{orders_.find(ref_num)}; it != orders_.end())
-    {
-        if (it->second.shares <= shares)
+    const auto order{[&] {
+        if constexpr (Policy::priority)
         {
-            orders_.erase(it);
+            return order_type{.shares = shares, .price_side = pack_price(price, side), .seq = next_seq_};
         }
         else
         {
-            it->second.shares -= shares;
+            return order_type{.shares = shares, .price_side = pack_price(price, side)};
         }
+    }()};
+    if (!orders_.insert(ref_num, order))
+    {
+        return std::nullopt;
     }
+    if (attribution)
+    {
+        attributions_.insert_or_assign(ref_num, *attribution);
+    }
+
+    if constexpr (Policy::priority)
+    {
+        ++next_seq_;
+    }
+    if constexpr (Policy::queues)
+    {
+        queues_.try_emplace(queue_key(side, price)).first->second.push(order.seq, shares);
+    }
+
+    bool top{false};
+    Level level{};
+    if (side == itch::Side::Buy)
+    {
+        level = bids_.add(price, shares, top);
+        if constexpr (Policy::depth)
+        {
+            update_depth(bids_, bid_depth_, level);
+        }
+    }
+    else
+    {
+        level = asks_.add(price, shares, top);
+        if constexpr (Policy::depth)
+        {
+            update_depth(asks_, ask_depth_, level);
+        }
+    }
+    return Change{.side = side, .shares = shares, .order_shares = shares, .level = level, .top = top};
 }
 
-void Book::remove(std::uint64_t ref_num)
+template <DepthPolicy Policy>
+std::optional<Change> BasicBook<Policy>::reduce(std::uint64_t ref_num, std::uint32_t shares)
 {
-    orders_.erase(ref_num);
+    auto* const resting{orders_.find(ref_num)};
+    if (resting == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    const auto order{*resting};
+    const auto removed{std::min(order.shares, shares)};
+    const bool gone{removed == order.shares};
+    if (gone)
+    {
+        orders_.erase(ref_num);
+        if (!attributions_.empty())
+        {
+            attributions_.erase(ref_num);
+        }
+    }
+    else
+    {
+        resting->shares -= removed;
+    }
+
+    bool top{false};
+    Level level{};
+    if (order.side() == itch::Side::Buy)
+    {
+        level = bids_.take(order.price(), removed, gone, top);
+        if constexpr (Policy::depth)
+        {
+            update_depth(bids_, bid_depth_, level);
+        }
+    }
+    else
+    {
+        level = asks_.take(order.price(), removed, gone, top);
+        if constexpr (Policy::depth)
+        {
+            update_depth(asks_, ask_depth_, level);
+        }
+    }
+
+    if constexpr (Policy::queues)
+    {
+        if (const auto queue{queues_.find(queue_key(order.side(), order.price()))}; queue != queues_.end())
+        {
+            if (level.orders == 0)
+            {
+                queues_.erase(queue);
+            }
+            else
+            {
+                queue->second.take(order.seq, removed, gone);
+            }
+        }
+    }
+    return Change{.side = order.side(), .shares = removed, .order_shares = order.shares - removed, .level = level, .top = top};
+}
+
+template <DepthPolicy Policy>
+std::optional<Change> BasicBook<Policy>::remove(std::uint64_t ref_num)
+{
+    return reduce(ref_num, std::numeric_limits<std::uint32_t>::max());
+}
+
+template <DepthPolicy Policy>
+std::optional<ReplaceChange> BasicBook<Policy>::replace(const itch::OrderReplaceMessage& msg)
+{
+    const auto attributed{attribution(msg.original_order_reference_number)};
+    const auto removed{remove(msg.original_order_reference_number)};
+    if (!removed)
+    {
+        return std::nullopt;
+    }
+    return ReplaceChange{.removed = *removed,
+                         .added = add(msg.new_order_reference_number, msg.shares, msg.price, removed->side, attributed)};
+}
+
+template <DepthPolicy Policy>
+std::size_t BasicBook<Policy>::depth(itch::Side side, std::span<Level> out) const
+    requires Policy::depth
+{
+    const auto& levels{side == itch::Side::Buy ? bid_depth_ : ask_depth_};
+    const auto count{std::min(out.size(), levels.size())};
+    std::copy_n(levels.begin(), count, out.begin());
+    return count;
+}
+
+template <DepthPolicy Policy>
+std::optional<QueuePosition> BasicBook<Policy>::queue_position(std::uint64_t ref_num) const
+    requires Policy::queues
+{
+    const auto* const resting{orders_.find(ref_num)};
+    if (resting == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    const auto order{*resting};
+    const auto ahead{queues_.at(queue_key(order.side(), order.price())).ahead_of(order.seq)};
+    const auto level{order.side() == itch::Side::Buy ? *bids_.find(order.price()) : *asks_.find(order.price())};
+    return QueuePosition{.level = level, .orders_ahead = ahead.orders, .shares_ahead = ahead.shares};
+}
+
+template <DepthPolicy Policy>
+std::optional<Level> BasicBook<Policy>::best_bid() const
+{
+    return bids_.best();
+}
+
+template <DepthPolicy Policy>
+std::optional<Level> BasicBook<Policy>::best_ask() const
+{
+    return asks_.best();
+}
+
+template <DepthPolicy Policy>
+void BasicBook<Policy>::set_ladder(LadderProfile profile)
+{
+    bids_.set_profile(profile);
+    asks_.set_profile(profile);
+}
+
+template <DepthPolicy Policy>
+LadderProfile BasicBook<Policy>::ladder() const noexcept
+{
+    return bids_.profile();
+}
+
+template <DepthPolicy Policy>
+std::size_t BasicBook<Policy>::order_count() const noexcept
+{
+    return orders_.size();
 }
 
-void Book::replace(const itch::OrderReplaceMessage& msg)
+template <DepthPolicy Policy>
+std::size_t BasicBook<Policy>::level_count() const noexcept
 {
-    if (const auto it{orders_.find(msg.original_order_reference_number)}; it != orders_.end())
+    return bids_.size() + asks_.size();
+}
+
+template <DepthPolicy Policy>
+std::optional<itch::MPID> BasicBook<Policy>::attribution(std::uint64_t ref_num) const
+{
+    if (attributions_.empty())
+    {
+        return std::nullopt;
+    }
+    const auto it{attributions_.find(ref_num)};
+    if (it == attributions_.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+template <DepthPolicy Policy>
+std::size_t BasicBook<Policy>::order_bytes() const noexcept
+{
+    return orders_.memory_bytes() + hash_bytes(attributions_);
+}
+
+template <DepthPolicy Policy>
+bool BasicBook<Policy>::operator==(const BasicBook& other) const
+{
+    if (bids_ != other.bids_ || asks_ != other.asks_ || orders_.size() != other.orders_.size())
     {
-        itch::Side old_side = it->second.side;
-        orders_.erase(it);
-        add(msg.new_order_reference_number, msg.shares, msg.price, old_side);
+        return false;
     }
+    bool same{true};
+    orders_.for_each([&](std::uint64_t ref_num, const order_type& order) {
+        const auto* const theirs{other.orders_.find(ref_num)};
+        same = same && theirs != nullptr && theirs->shares == order.shares && theirs->price_side == order.price_side;
+    });
+    return same;
 }
 
+template class BasicBook<Bbo>;
+template class BasicBook<L2>;
+template class BasicBook<L3>;
+template class BasicBook<L3Queues>;
+
 }
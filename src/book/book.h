@@ -3,27 +3,242 @@
 
 #include "../itch/types.h"
 #include "../itch/messages_orders.h"
+#include "ladder.h"
+#include "order_window.h"
+#include "queue_index.h"
+#include <concepts>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <type_traits>
+#include <span>
 #include <unordered_map>
+#include <vector>
 namespace book
 {
+// levels per side kept ready for depth reads
+inline constexpr std::size_t max_depth{20};
+
+// what a book keeps past order lookup and the price levels, chosen at compile time
+// Bbo: best bid/ask off the ladders, enough for executes and cancels. it keeps every order (an
+//   execute or cancel names only the ref) and every level (the next best once the top empties), so
+//   next to L2 it saves only the depth copies: the same memory, less time per update
+// L2: plus the best max_depth levels per side kept contiguous for depth reads
+// L3: plus each order's enqueue stamp, so snapshots and checkpoints keep time priority
+// L3Queues: plus a per-level queue index for queue positions, paid on every add and reduce
+struct Bbo
+{
+    static constexpr bool depth{false};
+    static constexpr bool priority{false};
+    static constexpr bool queues{false};
+};
+
+struct L2
+{
+    static constexpr bool depth{true};
+    static constexpr bool priority{false};
+    static constexpr bool queues{false};
+};
+
+struct L3
+{
+    static constexpr bool depth{true};
+    static constexpr bool priority{true};
+    static constexpr bool queues{false};
+};
+
+struct L3Queues
+{
+    static constexpr bool depth{true};
+    static constexpr bool priority{true};
+    static constexpr bool queues{true};
+};
+
+// a queue index orders by enqueue stamp, so it needs them
+template <typename Policy>
+concept DepthPolicy = requires {
+    { Policy::depth } -> std::convertible_to<bool>;
+    { Policy::priority } -> std::convertible_to<bool>;
+    { Policy::queues } -> std::convertible_to<bool>;
+} && (Policy::priority || !Policy::queues);
+
+// itch prices stay below 2^31, the side rides in the top bit
+inline constexpr std::uint32_t sell_bit{1U << 31};
+
+[[nodiscard]]
+constexpr std::uint32_t pack_price(std::uint32_t price, itch::Side side) noexcept
+{
+    return price | (side == itch::Side::Sell ? sell_bit : 0);
+}
+
+// the hot record, 8 bytes; anything only some orders have (attribution) lives apart from it
 struct Order
 {
     std::uint32_t shares;
-    std::uint32_t price;
+    std::uint32_t price_side;
+
+    [[nodiscard]]
+    constexpr std::uint32_t price() const noexcept
+    {
+        return price_side & ~sell_bit;
+    }
+    [[nodiscard]]
+    constexpr itch::Side side() const noexcept
+    {
+        return (price_side & sell_bit) != 0 ? itch::Side::Sell : itch::Side::Buy;
+    }
+
+    bool operator==(const Order&) const = default;
+};
+
+// L3 orders also carry their enqueue stamp, time priority within the level; 12 bytes
+struct QueuedOrder
+{
+    std::uint32_t shares;
+    std::uint32_t price_side;
+    std::uint32_t seq;
+
+    [[nodiscard]]
+    constexpr std::uint32_t price() const noexcept
+    {
+        return price_side & ~sell_bit;
+    }
+    [[nodiscard]]
+    constexpr itch::Side side() const noexcept
+    {
+        return (price_side & sell_bit) != 0 ? itch::Side::Sell : itch::Side::Buy;
+    }
+
+    bool operator==(const QueuedOrder&) const = default;
+};
+
+static_assert(sizeof(Order) == 8);
+static_assert(sizeof(QueuedOrder) == 12);
+
+extern template class OrderWindow<Order>;
+extern template class OrderWindow<QueuedOrder>;
+
+// what an operation did to the order and its price level
+struct Change
+{
     itch::Side side;
+    // added or taken by the operation
+    std::uint32_t shares;
+    // left on the order afterwards, 0 once it is gone
+    std::uint32_t order_shares;
+    // aggregate afterwards, orders == 0 once the level is gone
+    Level level;
+    // level is (or was, for a removal) the best on its side
+    bool top;
 };
 
-class Book
+struct ReplaceChange
+{
+    Change removed;
+    std::optional<Change> added;
+};
+
+struct QueuePosition
+{
+    Level level;
+    // live orders and their shares queued before this one at its price
+    std::uint32_t orders_ahead;
+    std::uint64_t shares_ahead;
+};
+
+template <DepthPolicy Policy>
+class BasicBook
 {
   public:
-    void add(std::uint64_t ref_num, std::uint32_t shares, std::uint32_t price, itch::Side side);
-    void reduce(std::uint64_t ref_num, std::uint32_t shares);
-    void remove(std::uint64_t ref_num);
-    void replace(const itch::OrderReplaceMessage& msg);
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    using order_type = std::conditional_t<Policy::priority, QueuedOrder, Order>;
+
+    BasicBook() = default;
+    explicit BasicBook(const allocator_type& alloc);
+
+    // nullopt when the ref is unknown (or already live, for add)
+    std::optional<Change> add(std::uint64_t ref_num, std::uint32_t shares, std::uint32_t price, itch::Side side,
+                              std::optional<itch::MPID> attribution = std::nullopt);
+    std::optional<Change> reduce(std::uint64_t ref_num, std::uint32_t shares);
+    std::optional<Change> remove(std::uint64_t ref_num);
+    // the replacement keeps the original's attribution
+    std::optional<ReplaceChange> replace(const itch::OrderReplaceMessage& msg);
+
+    [[nodiscard]]
+    std::optional<Level> best_bid() const;
+    [[nodiscard]]
+    std::optional<Level> best_ask() const;
+
+    // both sides' level store, sparse (the default) or a dense ladder around the touch; levels move over
+    void set_ladder(LadderProfile profile);
+    [[nodiscard]]
+    LadderProfile ladder() const noexcept;
+
+    // copies the best min(out.size(), max_depth) levels of a side, best first, returns how many
+    std::size_t depth(itch::Side side, std::span<Level> out) const
+        requires Policy::depth;
+
+    // every level keeps its queue index from its first order, O(log n) per add, reduce and query
+    std::optional<QueuePosition> queue_position(std::uint64_t ref_num) const
+        requires Policy::queues;
+
+    [[nodiscard]]
+    std::size_t order_count() const noexcept;
+    [[nodiscard]]
+    std::size_t level_count() const noexcept;
+    // the mpid a live order was added with, nullopt for anonymous (A) orders
+    [[nodiscard]]
+    std::optional<itch::MPID> attribution(std::uint64_t ref_num) const;
+    // what the live orders cost, hot records plus the cold attribution table, node overheads estimated
+    [[nodiscard]]
+    std::size_t order_bytes() const noexcept;
+
+    // fn(ref_num, order) for every live order, in no particular order (seq gives time priority)
+    template <typename Fn>
+    void for_each_order(Fn&& fn) const
+    {
+        orders_.for_each(fn);
+    }
+
+    // same live orders and levels, regardless of allocator or where the enqueue stamps started;
+    // attribution is left out, checkpoints don't carry it
+    bool operator==(const BasicBook& other) const;
 
   private:
-    std::unordered_map<std::uint64_t, Order> orders_;
+    // stands in for state the policy leaves out
+    struct Unused
+    {
+        Unused() = default;
+        explicit Unused(const allocator_type&)
+        {
+        }
+    };
+
+    template <bool Keep, typename T>
+    using Kept = std::conditional_t<Keep, T, Unused>;
+
+    // refs rise through the day, so a sliding window instead of a hash map
+    OrderWindow<order_type> orders_;
+    // cold, by ref, only orders that came with an mpid
+    std::pmr::unordered_map<std::uint64_t, itch::MPID> attributions_;
+    Ladder<std::greater<>> bids_;
+    Ladder<std::less<>> asks_;
+    // the first max_depth entries of bids_/asks_, kept in step on every change
+    [[no_unique_address]] Kept<Policy::depth, std::pmr::vector<Level>> bid_depth_;
+    [[no_unique_address]] Kept<Policy::depth, std::pmr::vector<Level>> ask_depth_;
+    [[no_unique_address]] Kept<Policy::priority, std::uint32_t> next_seq_{};
+    // by queue_key(side, price), one per live level
+    [[no_unique_address]] Kept<Policy::queues, std::pmr::unordered_map<std::uint64_t, QueueIndex>> queues_;
 };
+
+extern template class BasicBook<Bbo>;
+extern template class BasicBook<L2>;
+extern template class BasicBook<L3>;
+extern template class BasicBook<L3Queues>;
+
+// full depth, what the feed handler and replay build; fill simulators that track queue positions
+// take BasicBook<L3Queues>
+using Book = BasicBook<L3>;
 }
 
 #endif
@@ -0,0 +1,90 @@
+#include "executions.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+
+constexpr std::uint8_t busted_bit{0x80};
+
+}
+
+namespace book
+{
+
+// at least one whole line
+ExecutionIndex::ExecutionIndex(std::size_t capacity, const allocator_type& alloc)
+    : lines_(std::bit_ceil(std::max(capacity, slots_per_line)) / slots_per_line, alloc),
+      mask_{lines_.size() * slots_per_line - 1},
+      shift_{static_cast<unsigned>(std::countr_zero(mask_ + 1))}
+{
+}
+
+std::uint32_t ExecutionIndex::tag(std::uint64_t match_number) const noexcept
+{
+    return static_cast<std::uint32_t>(match_number >> shift_) + 1;
+}
+
+ExecutionIndex::Slot& ExecutionIndex::slot(std::uint64_t match_number) noexcept
+{
+    const auto i{match_number & mask_};
+    return lines_[i / slots_per_line].slots[i % slots_per_line];
+}
+
+const ExecutionIndex::Slot& ExecutionIndex::slot(std::uint64_t match_number) const noexcept
+{
+    const auto i{match_number & mask_};
+    return lines_[i / slots_per_line].slots[i % slots_per_line];
+}
+
+void ExecutionIndex::record(const Execution& execution) noexcept
+{
+    const auto flags{static_cast<std::uint8_t>(static_cast<std::uint8_t>(execution.kind) | (execution.busted ? busted_bit : 0))};
+    slot(execution.match_number) = Slot{.tag = tag(execution.match_number),
+                                        .price = execution.price,
+                                        .shares = execution.shares,
+                                        .stock_locate = execution.stock_locate,
+                                        .side = execution.side,
+                                        .flags = flags};
+}
+
+std::optional<Execution> ExecutionIndex::find(std::uint64_t match_number) const noexcept
+{
+    const auto& found{slot(match_number)};
+    if (found.tag != tag(match_number))
+    {
+        return std::nullopt;
+    }
+    return Execution{.match_number = match_number,
+                     .price = found.price,
+                     .shares = found.shares,
+                     .stock_locate = found.stock_locate,
+                     .side = found.side,
+                     .kind = static_cast<ExecutionKind>(found.flags & ~busted_bit),
+                     .busted = (found.flags & busted_bit) != 0};
+}
+
+std::optional<Execution> ExecutionIndex::bust(std::uint64_t match_number) noexcept
+{
+    auto execution{find(match_number)};
+    if (!execution || execution->busted)
+    {
+        return std::nullopt;
+    }
+    slot(match_number).flags |= busted_bit;
+    execution->busted = true;
+    return execution;
+}
+
+std::size_t ExecutionIndex::capacity() const noexcept
+{
+    return mask_ + 1;
+}
+
+std::size_t ExecutionIndex::bytes() const noexcept
+{
+    return lines_.size() * sizeof(Line);
+}
+
+}
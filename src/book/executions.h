@@ -0,0 +1,100 @@
+#ifndef BOOK_EXECUTIONS_H_
+#define BOOK_EXECUTIONS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+#include "../itch/types.h"
+#include "../util/cache.h"
+
+namespace book
+{
+
+enum class ExecutionKind : std::uint8_t
+{
+    // E, at the resting order's price
+    Executed,
+    // C
+    ExecutedWithPrice,
+    // P, non-displayed
+    Trade,
+    // Q, shares saturate at u32 max
+    Cross
+};
+
+struct Execution
+{
+    std::uint64_t match_number;
+    std::uint32_t price;
+    std::uint32_t shares;
+    std::uint16_t stock_locate;
+    itch::Side side;
+    ExecutionKind kind;
+    bool busted;
+
+    bool operator==(const Execution&) const = default;
+};
+
+// match number -> execution, direct indexed into a power-of-two ring of 16 byte slots
+// match numbers are dense and close to increasing, so the ring holds the latest capacity()
+// of them; sized once up front, recording never allocates or rehashes. single writer: a
+// partitioned feed gives each channel its own, the ring starts on a cache line of its own
+class ExecutionIndex
+{
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit ExecutionIndex(std::size_t capacity, const allocator_type& alloc = {});
+
+    void record(const Execution& execution) noexcept;
+    // nullopt once the slot was reused by a later match, or never recorded
+    [[nodiscard]]
+    std::optional<Execution> find(std::uint64_t match_number) const noexcept;
+    // marks it busted and returns it, nullopt if unknown or already busted
+    std::optional<Execution> bust(std::uint64_t match_number) noexcept;
+
+    [[nodiscard]]
+    std::size_t capacity() const noexcept;
+    // the ring, all of it allocated and zeroed at construction
+    [[nodiscard]]
+    std::size_t bytes() const noexcept;
+
+  private:
+    struct Slot
+    {
+        // match_number >> shift_ plus one, 0 while empty
+        std::uint32_t tag;
+        std::uint32_t price;
+        std::uint32_t shares;
+        std::uint16_t stock_locate;
+        itch::Side side;
+        // ExecutionKind in the low bits, busted_bit on top
+        std::uint8_t flags;
+    };
+    static_assert(sizeof(Slot) == 16);
+
+    static constexpr std::size_t slots_per_line{util::cache_line_size / sizeof(Slot)};
+    struct alignas(util::cache_line_size) Line
+    {
+        std::array<Slot, slots_per_line> slots;
+    };
+
+    [[nodiscard]]
+    std::uint32_t tag(std::uint64_t match_number) const noexcept;
+    [[nodiscard]]
+    Slot& slot(std::uint64_t match_number) noexcept;
+    [[nodiscard]]
+    const Slot& slot(std::uint64_t match_number) const noexcept;
+
+    std::pmr::vector<Line> lines_;
+    std::uint64_t mask_;
+    unsigned shift_;
+};
+
+}
+
+#endif
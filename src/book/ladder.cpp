@@ -0,0 +1,340 @@
+#include "ladder.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace book
+{
+
+template <typename Better>
+Ladder<Better>::Ladder(const allocator_type& alloc)
+    : tree_{alloc},
+      slots_{alloc},
+      occupied_{alloc}
+{
+}
+
+template <typename Better>
+void Ladder<Better>::set_profile(LadderProfile profile)
+{
+    spill();
+    anchor_ = 0;
+    if (profile.tick == 0 || profile.ticks == 0)
+    {
+        tick_ = 0;
+        slots_ = std::pmr::vector<Level>{slots_.get_allocator()};
+        occupied_ = std::pmr::vector<std::uint64_t>{occupied_.get_allocator()};
+        return;
+    }
+
+    tick_ = profile.tick;
+    const auto ticks{(std::min(profile.ticks, max_ticks) + 63) / 64 * 64};
+    slots_.assign(ticks, Level{});
+    occupied_.assign(ticks / 64, 0);
+    follow();
+}
+
+template <typename Better>
+LadderProfile Ladder<Better>::profile() const noexcept
+{
+    return {.tick = tick_, .ticks = static_cast<std::uint32_t>(slots_.size())};
+}
+
+template <typename Better>
+Level Ladder<Better>::add(std::uint32_t price, std::uint32_t shares, bool& top)
+{
+    const auto slot{slot_of(price)};
+    if (slot == npos)
+    {
+        const auto [it, inserted]{tree_.try_emplace(price, Level{.price = price, .orders = 0, .shares = 0})};
+        ++it->second.orders;
+        it->second.shares += shares;
+        const auto level{it->second};
+        top = it == tree_.begin() && (dense_levels_ == 0 || key_comp()(price, slots_[best_slot_].price));
+        if (top)
+        {
+            follow();
+        }
+        return level;
+    }
+
+    auto& level{slots_[slot]};
+    if (!occupied(slot))
+    {
+        level = Level{.price = price, .orders = 0, .shares = 0};
+        occupied_[slot / 64] |= std::uint64_t{1} << (slot % 64);
+        if (dense_levels_++ == 0 || (up_is_better ? slot > best_slot_ : slot < best_slot_))
+        {
+            best_slot_ = slot;
+        }
+    }
+    ++level.orders;
+    level.shares += shares;
+    top = slot == best_slot_ && (tree_.empty() || !key_comp()(tree_.begin()->first, price));
+    return level;
+}
+
+template <typename Better>
+Level Ladder<Better>::take(std::uint32_t price, std::uint32_t shares, bool order_gone, bool& top)
+{
+    const auto slot{slot_of(price)};
+    if (slot == npos)
+    {
+        const auto it{tree_.find(price)};
+        top = it == tree_.begin() && (dense_levels_ == 0 || key_comp()(price, slots_[best_slot_].price));
+        it->second.shares -= shares;
+        if (order_gone)
+        {
+            --it->second.orders;
+        }
+
+        const auto level{it->second};
+        if (level.orders == 0)
+        {
+            tree_.erase(it);
+            if (top && !slots_.empty())
+            {
+                follow();
+            }
+        }
+        return level;
+    }
+
+    auto& resting{slots_[slot]};
+    top = slot == best_slot_ && (tree_.empty() || !key_comp()(tree_.begin()->first, price));
+    resting.shares -= shares;
+    if (order_gone)
+    {
+        --resting.orders;
+    }
+
+    const auto level{resting};
+    if (level.orders == 0)
+    {
+        occupied_[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+        if (--dense_levels_ != 0 && slot == best_slot_)
+        {
+            best_slot_ = scan_worse(slot);
+        }
+        if (top)
+        {
+            follow();
+        }
+    }
+    return level;
+}
+
+template <typename Better>
+const Level* Ladder<Better>::find(std::uint32_t price) const
+{
+    if (const auto slot{slot_of(price)}; slot != npos)
+    {
+        return occupied(slot) ? &slots_[slot] : nullptr;
+    }
+    const auto it{tree_.find(price)};
+    return it == tree_.end() ? nullptr : &it->second;
+}
+
+template <typename Better>
+std::optional<Level> Ladder<Better>::best() const noexcept
+{
+    if (dense_levels_ == 0)
+    {
+        if (tree_.empty())
+        {
+            return std::nullopt;
+        }
+        return tree_.begin()->second;
+    }
+    const auto& dense{slots_[best_slot_]};
+    if (!tree_.empty() && key_comp()(tree_.begin()->first, dense.price))
+    {
+        return tree_.begin()->second;
+    }
+    return dense;
+}
+
+template <typename Better>
+std::optional<Level> Ladder<Better>::next_worse(std::uint32_t price) const
+{
+    std::optional<Level> worse{};
+    if (const auto it{tree_.upper_bound(price)}; it != tree_.end())
+    {
+        worse = it->second;
+    }
+    if (dense_levels_ == 0)
+    {
+        return worse;
+    }
+
+    // the slot nearest price that is strictly worse than it
+    auto from{npos};
+    if constexpr (up_is_better)
+    {
+        if (price > anchor_)
+        {
+            from = std::min(static_cast<std::size_t>((price - anchor_ - 1) / tick_), slots_.size() - 1);
+        }
+    }
+    else if (price < anchor_)
+    {
+        from = 0;
+    }
+    else if (const auto next{static_cast<std::size_t>((price - anchor_) / tick_) + 1}; next < slots_.size())
+    {
+        from = next;
+    }
+
+    if (from != npos)
+    {
+        if (const auto slot{scan_worse(from)}; slot != npos && (!worse || key_comp()(slots_[slot].price, worse->price)))
+        {
+            worse = slots_[slot];
+        }
+    }
+    return worse;
+}
+
+template <typename Better>
+std::size_t Ladder<Better>::size() const noexcept
+{
+    return dense_levels_ + tree_.size();
+}
+
+template <typename Better>
+bool Ladder<Better>::empty() const noexcept
+{
+    return size() == 0;
+}
+
+template <typename Better>
+std::size_t Ladder<Better>::dense_size() const noexcept
+{
+    return dense_levels_;
+}
+
+template <typename Better>
+bool Ladder<Better>::operator==(const Ladder& other) const
+{
+    if (size() != other.size())
+    {
+        return false;
+    }
+    bool same{true};
+    for_each([&](const Level& level) {
+        const auto* const theirs{other.find(level.price)};
+        same = same && theirs != nullptr && *theirs == level;
+    });
+    return same;
+}
+
+template <typename Better>
+std::size_t Ladder<Better>::slot_of(std::uint32_t price) const noexcept
+{
+    if (slots_.empty() || price < anchor_)
+    {
+        return npos;
+    }
+    const auto offset{price - anchor_};
+    const auto slot{offset / tick_};
+    if (slot * tick_ != offset || slot >= slots_.size())
+    {
+        return npos;
+    }
+    return slot;
+}
+
+template <typename Better>
+std::size_t Ladder<Better>::scan_worse(std::size_t from) const noexcept
+{
+    auto word{from / 64};
+    if constexpr (up_is_better)
+    {
+        auto bits{occupied_[word] & (~std::uint64_t{0} >> (63 - from % 64))};
+        while (bits == 0)
+        {
+            if (word == 0)
+            {
+                return npos;
+            }
+            bits = occupied_[--word];
+        }
+        return word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(bits));
+    }
+    else
+    {
+        auto bits{occupied_[word] & (~std::uint64_t{0} << (from % 64))};
+        while (bits == 0)
+        {
+            if (++word == occupied_.size())
+            {
+                return npos;
+            }
+            bits = occupied_[word];
+        }
+        return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+    }
+}
+
+template <typename Better>
+void Ladder<Better>::follow()
+{
+    if (tree_.empty() || slots_.empty())
+    {
+        return;
+    }
+    const auto price{tree_.begin()->first};
+    if (price % tick_ == 0 && (dense_levels_ == 0 || key_comp()(price, slots_[best_slot_].price)))
+    {
+        recenter(price);
+    }
+}
+
+template <typename Better>
+void Ladder<Better>::recenter(std::uint32_t price)
+{
+    spill();
+    const auto half{slots_.size() / 2 * tick_};
+    anchor_ = static_cast<std::uint32_t>(price > half ? price - half : 0);
+
+    const auto last{static_cast<std::uint32_t>(std::min<std::size_t>(anchor_ + (slots_.size() - 1) * tick_, std::numeric_limits<std::uint32_t>::max()))};
+    const auto [from, to]{up_is_better ? std::pair{last, anchor_} : std::pair{anchor_, last}};
+    for (auto it{tree_.lower_bound(from)}; it != tree_.end() && !key_comp()(to, it->first);)
+    {
+        const auto slot{slot_of(it->first)};
+        if (slot == npos)
+        {
+            ++it;
+            continue;
+        }
+        slots_[slot] = it->second;
+        occupied_[slot / 64] |= std::uint64_t{1} << (slot % 64);
+        ++dense_levels_;
+        it = tree_.erase(it);
+    }
+    if (dense_levels_ != 0)
+    {
+        best_slot_ = scan_worse(up_is_better ? slots_.size() - 1 : 0);
+    }
+}
+
+template <typename Better>
+void Ladder<Better>::spill()
+{
+    for (std::size_t word = 0; word < occupied_.size(); ++word)
+    {
+        for (auto bits{occupied_[word]}; bits != 0; bits &= bits - 1)
+        {
+            const auto& level{slots_[word * 64 + static_cast<std::size_t>(std::countr_zero(bits))]};
+            tree_.try_emplace(level.price, level);
+        }
+        occupied_[word] = 0;
+    }
+    dense_levels_ = 0;
+}
+
+template class Ladder<std::greater<>>;
+template class Ladder<std::less<>>;
+
+}
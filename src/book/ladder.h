@@ -0,0 +1,146 @@
+#ifndef BOOK_LADDER_H_
+#define BOOK_LADDER_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace book
+{
+
+struct Level
+{
+    std::uint32_t price;
+    std::uint32_t orders;
+    std::uint64_t shares;
+
+    bool operator==(const Level&) const = default;
+};
+
+// a dense ladder's shape: ticks slots, tick apart in price; zero ticks keeps a side sparse
+struct LadderProfile
+{
+    std::uint32_t tick;
+    std::uint32_t ticks;
+
+    bool operator==(const LadderProfile&) const = default;
+};
+
+// penny ticks (prices carry 4 decimals) about $5 either side of the touch
+inline constexpr LadderProfile liquid_ladder{.tick = 100, .ticks = 1024};
+
+// one side's price levels, best first by Better (std::greater<> for bids, std::less<> for asks)
+// sparse by default, an ordered tree. with a profile, levels on the tick grid within the array
+// sit in the slot (price - anchor) / tick and a bitmap of occupied slots finds the best and the
+// next one behind it; off-grid and far levels stay in the tree. once the best is on the grid
+// but beyond the array, the array recentres on it and levels move across
+template <typename Better>
+class Ladder
+{
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    using key_compare = Better;
+
+    // bitmap words are whole
+    static constexpr std::uint32_t max_ticks{std::uint32_t{1} << 16};
+
+    Ladder() = default;
+    explicit Ladder(const allocator_type& alloc);
+
+    // levels already held move to wherever the new profile puts them
+    void set_profile(LadderProfile profile);
+    [[nodiscard]]
+    LadderProfile profile() const noexcept;
+
+    // a new order's shares onto its level, created if need be; top if the level is then the best
+    Level add(std::uint32_t price, std::uint32_t shares, bool& top);
+    // the level must exist, it goes once its last order does; top if it was the best
+    Level take(std::uint32_t price, std::uint32_t shares, bool order_gone, bool& top);
+
+    [[nodiscard]]
+    const Level* find(std::uint32_t price) const;
+    [[nodiscard]]
+    std::optional<Level> best() const noexcept;
+    // the best level strictly worse than price
+    [[nodiscard]]
+    std::optional<Level> next_worse(std::uint32_t price) const;
+
+    [[nodiscard]]
+    std::size_t size() const noexcept;
+    [[nodiscard]]
+    bool empty() const noexcept;
+    // levels in the array rather than the tree
+    [[nodiscard]]
+    std::size_t dense_size() const noexcept;
+    [[nodiscard]]
+    static constexpr key_compare key_comp() noexcept
+    {
+        return {};
+    }
+
+    // fn(level) for every level, array first, then tree
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (std::size_t word = 0; word < occupied_.size(); ++word)
+        {
+            for (auto bits{occupied_[word]}; bits != 0; bits &= bits - 1)
+            {
+                fn(slots_[word * 64 + static_cast<std::size_t>(std::countr_zero(bits))]);
+            }
+        }
+        for (const auto& [price, level] : tree_)
+        {
+            fn(level);
+        }
+    }
+
+    // same levels, however each side stores them
+    bool operator==(const Ladder& other) const;
+
+  private:
+    static constexpr std::size_t npos{~std::size_t{0}};
+    // bids get better up the array, asks down it
+    static constexpr bool up_is_better{Better{}(1U, 0U)};
+
+    // npos for prices that belong in the tree
+    [[nodiscard]]
+    std::size_t slot_of(std::uint32_t price) const noexcept;
+    [[nodiscard]]
+    bool occupied(std::size_t slot) const noexcept
+    {
+        return ((occupied_[slot / 64] >> (slot % 64)) & 1) != 0;
+    }
+    // the best occupied slot no better than from, npos if none
+    [[nodiscard]]
+    std::size_t scan_worse(std::size_t from) const noexcept;
+
+    // once the tree holds the best and it is on the grid, the array moves to it
+    void follow();
+    // the array shifts to put price mid-way, everything it no longer covers goes to the tree
+    void recenter(std::uint32_t price);
+    void spill();
+
+    std::pmr::map<std::uint32_t, Level, Better> tree_;
+    std::pmr::vector<Level> slots_;
+    // one bit per slot
+    std::pmr::vector<std::uint64_t> occupied_;
+    // price of slot 0, a multiple of tick_
+    std::uint32_t anchor_{0};
+    std::uint32_t tick_{0};
+    std::size_t dense_levels_{0};
+    // meaningful while dense_levels_ != 0
+    std::size_t best_slot_{0};
+};
+
+extern template class Ladder<std::greater<>>;
+extern template class Ladder<std::less<>>;
+
+}
+
+#endif
@@ -1,15 +1,164 @@
 #include "market.h"
 
+#include <algorithm>
+
 namespace book
 {
-Market::Market()
-    : books_(std::numeric_limits<std::uint16_t>::max())
+template <DepthPolicy Policy>
+BasicMarket<Policy>::BasicMarket(std::pmr::memory_resource* resource)
+    : books_(std::numeric_limits<std::uint16_t>::max(), resource),
+      bbo_{std::make_unique<BboTable>()},
+      auctions_{std::make_unique<AuctionTable>()}
+{
+}
+
+template <DepthPolicy Policy>
+BasicMarket<Policy>::book_type& BasicMarket<Policy>::get_book(std::uint16_t stock_locate)
 {
+    return books_[stock_locate];
 }
 
-Book& Market::get_book(std::uint16_t stock_locate)
+template <DepthPolicy Policy>
+const BasicMarket<Policy>::book_type& BasicMarket<Policy>::get_book(std::uint16_t stock_locate) const
 {
     return books_[stock_locate];
 }
 
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::refresh_top(std::uint16_t stock_locate)
+{
+    const auto& book{books_[stock_locate]};
+    bbo_->update(stock_locate, book.best_bid(), book.best_ask());
+}
+
+template <DepthPolicy Policy>
+const BboTable& BasicMarket<Policy>::bbo() const noexcept
+{
+    return *bbo_;
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::select_ladder(const itch::Symbol& symbol, LadderProfile profile)
+{
+    const auto it{std::ranges::find(ladders_, symbol, &std::pair<itch::Symbol, LadderProfile>::first)};
+    if (it != ladders_.end())
+    {
+        it->second = profile;
+        return;
+    }
+    ladders_.emplace_back(symbol, profile);
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::on_stock_directory(const itch::StockDirectoryMessage& msg)
+{
+    name_locate(msg.header.stock_locate, msg.symbol);
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::name_locate(std::uint16_t stock_locate, const itch::Symbol& symbol)
+{
+    symbols_.insert_or_assign(stock_locate, symbol);
+    const auto it{std::ranges::find(ladders_, symbol, &std::pair<itch::Symbol, LadderProfile>::first)};
+    if (it != ladders_.end())
+    {
+        books_[stock_locate].set_ladder(it->second);
+    }
+}
+
+template <DepthPolicy Policy>
+std::optional<itch::Symbol> BasicMarket<Policy>::symbol(std::uint16_t stock_locate) const
+{
+    const auto it{symbols_.find(stock_locate)};
+    return it != symbols_.end() ? std::optional{it->second} : std::nullopt;
+}
+
+template <DepthPolicy Policy>
+AuctionTable& BasicMarket<Policy>::auctions() noexcept
+{
+    return *auctions_;
+}
+
+template <DepthPolicy Policy>
+const AuctionTable& BasicMarket<Policy>::auctions() const noexcept
+{
+    return *auctions_;
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::enable_executions(std::size_t capacity, std::size_t channels)
+{
+    executions_.clear();
+    executions_.reserve(channels);
+    for (std::size_t i = 0; i < channels; ++i)
+    {
+        executions_.emplace_back(capacity, books_.get_allocator());
+    }
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::record_execution(std::size_t channel, const Execution& execution) noexcept
+{
+    if (channel < executions_.size())
+    {
+        executions_[channel].record(execution);
+    }
+}
+
+template <DepthPolicy Policy>
+std::optional<Execution> BasicMarket<Policy>::bust(std::size_t channel, std::uint64_t match_number) noexcept
+{
+    return channel < executions_.size() ? executions_[channel].bust(match_number) : std::nullopt;
+}
+
+template <DepthPolicy Policy>
+const ExecutionIndex* BasicMarket<Policy>::executions(std::size_t channel) const noexcept
+{
+    return channel < executions_.size() ? &executions_[channel] : nullptr;
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::enable_signals()
+{
+    if (!signals_)
+    {
+        signals_ = std::make_unique<signals::Stage>();
+    }
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::refresh_signals(std::uint16_t stock_locate)
+{
+    if (signals_)
+    {
+        signals_->on_book(stock_locate, books_[stock_locate]);
+    }
+}
+
+template <DepthPolicy Policy>
+void BasicMarket<Policy>::record_trade(std::uint16_t stock_locate, std::uint32_t price, std::uint32_t shares)
+{
+    if (signals_)
+    {
+        signals_->on_trade(stock_locate, price, shares);
+    }
+}
+
+template <DepthPolicy Policy>
+const signals::Stage* BasicMarket<Policy>::signals() const noexcept
+{
+    return signals_.get();
+}
+
+template <DepthPolicy Policy>
+bool BasicMarket<Policy>::operator==(const BasicMarket& other) const
+{
+    return books_ == other.books_;
+}
+
+template class BasicMarket<Bbo>;
+template class BasicMarket<L2>;
+template class BasicMarket<L3>;
+template class BasicMarket<L3Queues>;
+
 }
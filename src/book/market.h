@@ -1,19 +1,92 @@
 #ifndef MARKET_H_
 #define MARKET_H_
 
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "../itch/messages_stock.h"
+#include "auction.h"
+#include "bbo.h"
+#include "executions.h"
 #include "book.h"
+#include "../signals/signals.h"
 namespace book
 {
-class Market
+// every locate's book at one depth policy, plus the market-wide tables fed alongside them
+template <DepthPolicy Policy>
+class BasicMarket
 {
   public:
-    Market();
-    Book& get_book(std::uint16_t stock_locate);
+    using book_type = BasicBook<Policy>;
+
+    explicit BasicMarket(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    book_type& get_book(std::uint16_t stock_locate);
+    const book_type& get_book(std::uint16_t stock_locate) const;
+
+    // re-reads the book's best levels into the bbo table, after any change that reports top
+    void refresh_top(std::uint16_t stock_locate);
+    [[nodiscard]]
+    const BboTable& bbo() const noexcept;
+
+    // books for symbol get profile's dense ladder once the stock directory names their locate
+    void select_ladder(const itch::Symbol& symbol, LadderProfile profile);
+    void on_stock_directory(const itch::StockDirectoryMessage& msg);
+    // what a directory message does for the locate, for books rebuilt without one
+    void name_locate(std::uint16_t stock_locate, const itch::Symbol& symbol);
+    // nullopt until the directory names the locate
+    [[nodiscard]]
+    std::optional<itch::Symbol> symbol(std::uint16_t stock_locate) const;
+
+    // noii, cross and direct listing state per locate
+    [[nodiscard]]
+    AuctionTable& auctions() noexcept;
+    [[nodiscard]]
+    const AuctionTable& auctions() const noexcept;
+
+    // match number indexes, off until enabled, one per feed channel so receivers never write the
+    // same ring; a bust comes on the channel that carried the trade. capacity is how many of the
+    // latest market-wide match numbers each keeps
+    void enable_executions(std::size_t capacity, std::size_t channels = 1);
+    void record_execution(std::size_t channel, const Execution& execution) noexcept;
+    // marks the match busted and returns the original, nullopt while off, unknown or already busted
+    std::optional<Execution> bust(std::size_t channel, std::uint64_t match_number) noexcept;
+    // nullptr while off
+    [[nodiscard]]
+    const ExecutionIndex* executions(std::size_t channel = 0) const noexcept;
+
+    // off until enabled, the hooks below are then a null check
+    void enable_signals();
+    // after any change to the locate's book
+    void refresh_signals(std::uint16_t stock_locate);
+    // printed executions and non-displayed trades
+    void record_trade(std::uint16_t stock_locate, std::uint32_t price, std::uint32_t shares);
+    // nullptr while off
+    [[nodiscard]]
+    const signals::Stage* signals() const noexcept;
+
+    // books only, the table follows from them
+    bool operator==(const BasicMarket& other) const;
 
   private:
-    std::vector<Book> books_;
+    std::pmr::vector<book_type> books_;
+    // a handful of liquid names, looked up once per directory message
+    std::vector<std::pair<itch::Symbol, LadderProfile>> ladders_;
+    std::unordered_map<std::uint16_t, itch::Symbol> symbols_;
+    std::unique_ptr<BboTable> bbo_;
+    std::unique_ptr<AuctionTable> auctions_;
+    std::vector<ExecutionIndex> executions_;
+    std::unique_ptr<signals::Stage> signals_;
 };
+
+extern template class BasicMarket<Bbo>;
+extern template class BasicMarket<L2>;
+extern template class BasicMarket<L3>;
+extern template class BasicMarket<L3Queues>;
+
+using Market = BasicMarket<L3>;
 }
 
 #endif // MARKET_H_
@@ -0,0 +1,180 @@
+#include "order_window.h"
+
+#include "book.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace book
+{
+
+template <typename T>
+OrderWindow<T>::OrderWindow(const allocator_type& alloc)
+    : slots_{alloc},
+      live_{alloc},
+      overflow_{alloc}
+{
+}
+
+template <typename T>
+bool OrderWindow<T>::insert(std::uint64_t ref_num, const T& order)
+{
+    if (slots_.empty())
+    {
+        slots_.resize(min_capacity);
+        live_.resize(min_capacity / 64);
+        mask_ = min_capacity - 1;
+        base_ = ref_num;
+    }
+    if (ref_num < base_)
+    {
+        return overflow_.try_emplace(ref_num, order).second;
+    }
+    if (ref_num - base_ >= slots_.size())
+    {
+        advance(ref_num);
+    }
+
+    const auto slot{ref_num & mask_};
+    if (live(slot))
+    {
+        return false;
+    }
+    live_[slot / 64] |= std::uint64_t{1} << (slot % 64);
+    slots_[slot] = order;
+    ++window_live_;
+    return true;
+}
+
+template <typename T>
+const T* OrderWindow<T>::find(std::uint64_t ref_num) const noexcept
+{
+    if (ref_num - base_ < slots_.size())
+    {
+        const auto slot{ref_num & mask_};
+        return live(slot) ? &slots_[slot] : nullptr;
+    }
+    // nothing is ever live ahead of the window
+    if (ref_num >= base_ || overflow_.empty())
+    {
+        return nullptr;
+    }
+    const auto it{overflow_.find(ref_num)};
+    return it == overflow_.end() ? nullptr : &it->second;
+}
+
+template <typename T>
+T* OrderWindow<T>::find(std::uint64_t ref_num) noexcept
+{
+    return const_cast<T*>(std::as_const(*this).find(ref_num));
+}
+
+template <typename T>
+void OrderWindow<T>::erase(std::uint64_t ref_num)
+{
+    if (ref_num - base_ < slots_.size())
+    {
+        const auto slot{ref_num & mask_};
+        live_[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+        --window_live_;
+        return;
+    }
+    overflow_.erase(ref_num);
+}
+
+template <typename T>
+std::size_t OrderWindow<T>::size() const noexcept
+{
+    return window_live_ + overflow_.size();
+}
+
+template <typename T>
+std::size_t OrderWindow<T>::capacity() const noexcept
+{
+    return slots_.size();
+}
+
+template <typename T>
+std::size_t OrderWindow<T>::overflow() const noexcept
+{
+    return overflow_.size();
+}
+
+template <typename T>
+std::size_t OrderWindow<T>::memory_bytes() const noexcept
+{
+    return slots_.capacity() * sizeof(T) + live_.capacity() * sizeof(std::uint64_t) + hash_bytes(overflow_);
+}
+
+template <typename T>
+std::uint64_t OrderWindow<T>::first_live(std::uint64_t from, std::uint64_t to) const noexcept
+{
+    while (from < to)
+    {
+        const auto slot{from & mask_};
+        const auto bits{live_[slot / 64] >> (slot % 64)};
+        if (bits != 0)
+        {
+            return std::min(from + static_cast<std::uint64_t>(std::countr_zero(bits)), to);
+        }
+        from += 64 - slot % 64;
+    }
+    return to;
+}
+
+template <typename T>
+void OrderWindow<T>::advance(std::uint64_t ref_num)
+{
+    // drained slots at the front go first, the window then starts at its oldest live order
+    base_ = window_live_ == 0 ? ref_num : first_live(base_, base_ + slots_.size());
+    while (ref_num - base_ >= slots_.size() && slots_.size() < max_capacity && window_live_ * 64 > slots_.size())
+    {
+        grow();
+    }
+    if (ref_num - base_ < slots_.size())
+    {
+        return;
+    }
+
+    const auto keep_from{ref_num - slots_.size() + 1};
+    spill(base_, std::min(keep_from, base_ + slots_.size()));
+    base_ = window_live_ == 0 ? ref_num : first_live(keep_from, base_ + slots_.size());
+}
+
+template <typename T>
+void OrderWindow<T>::grow()
+{
+    std::pmr::vector<T> slots(slots_.size() * 2, slots_.get_allocator());
+    std::pmr::vector<std::uint64_t> live(live_.size() * 2, live_.get_allocator());
+    const auto mask{slots.size() - 1};
+    for (std::size_t word = 0; word < live_.size(); ++word)
+    {
+        for (auto bits{live_[word]}; bits != 0; bits &= bits - 1)
+        {
+            const auto slot{word * 64 + static_cast<std::size_t>(std::countr_zero(bits))};
+            const auto moved{ref_at(slot) & mask};
+            slots[moved] = slots_[slot];
+            live[moved / 64] |= std::uint64_t{1} << (moved % 64);
+        }
+    }
+    slots_ = std::move(slots);
+    live_ = std::move(live);
+    mask_ = mask;
+}
+
+template <typename T>
+void OrderWindow<T>::spill(std::uint64_t from, std::uint64_t to)
+{
+    for (auto ref_num{first_live(from, to)}; ref_num < to; ref_num = first_live(ref_num + 1, to))
+    {
+        const auto slot{ref_num & mask_};
+        overflow_.try_emplace(ref_num, slots_[slot]);
+        live_[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+        --window_live_;
+    }
+}
+
+template class OrderWindow<Order>;
+template class OrderWindow<QueuedOrder>;
+
+}
@@ -0,0 +1,111 @@
+#ifndef BOOK_ORDER_WINDOW_H_
+#define BOOK_ORDER_WINDOW_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace book
+{
+
+// what a node based hash map holds: buckets plus one node per entry, each the value and a next link
+template <typename Map>
+std::size_t hash_bytes(const Map& map) noexcept
+{
+    return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + sizeof(void*));
+}
+
+// ref -> order, for refs that mostly arrive in increasing order and mostly die young
+// recent refs live in a power-of-two ring covering [base, base + capacity), found with a
+// subtraction and a load; orders still live when the window slides past them move to an
+// overflow hash map. the window starts small and doubles while sliding would spill a window
+// more than 1/64 full, so books whose refs are too sparse for it degrade to plain hashing
+template <typename T>
+class OrderWindow
+{
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    static constexpr std::size_t min_capacity{64};
+    static constexpr std::size_t max_capacity{std::size_t{1} << 15};
+
+    OrderWindow() = default;
+    explicit OrderWindow(const allocator_type& alloc);
+
+    // false if ref_num is already live
+    bool insert(std::uint64_t ref_num, const T& order);
+    [[nodiscard]]
+    T* find(std::uint64_t ref_num) noexcept;
+    [[nodiscard]]
+    const T* find(std::uint64_t ref_num) const noexcept;
+    // ref_num must be live
+    void erase(std::uint64_t ref_num);
+
+    [[nodiscard]]
+    std::size_t size() const noexcept;
+    // slots in the window and orders that fell behind it
+    [[nodiscard]]
+    std::size_t capacity() const noexcept;
+    [[nodiscard]]
+    std::size_t overflow() const noexcept;
+    // slots, bitmap and overflow
+    [[nodiscard]]
+    std::size_t memory_bytes() const noexcept;
+
+    // fn(ref_num, order) for every live order, window first, then overflow
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (std::size_t word = 0; word < live_.size(); ++word)
+        {
+            for (auto bits{live_[word]}; bits != 0; bits &= bits - 1)
+            {
+                const auto slot{word * 64 + static_cast<std::size_t>(std::countr_zero(bits))};
+                fn(ref_at(slot), slots_[slot]);
+            }
+        }
+        for (const auto& [ref_num, order] : overflow_)
+        {
+            fn(ref_num, order);
+        }
+    }
+
+  private:
+    [[nodiscard]]
+    bool live(std::size_t slot) const noexcept
+    {
+        return ((live_[slot / 64] >> (slot % 64)) & 1) != 0;
+    }
+
+    // the ref a slot holds within the current window
+    [[nodiscard]]
+    std::uint64_t ref_at(std::size_t slot) const noexcept
+    {
+        return base_ + ((slot - base_) & mask_);
+    }
+
+    // the first live ref in [from, to), to if none
+    [[nodiscard]]
+    std::uint64_t first_live(std::uint64_t from, std::uint64_t to) const noexcept;
+
+    void advance(std::uint64_t ref_num);
+    void grow();
+    // live orders in [from, to) out of the window into overflow_
+    void spill(std::uint64_t from, std::uint64_t to);
+
+    std::pmr::vector<T> slots_;
+    // one bit per slot
+    std::pmr::vector<std::uint64_t> live_;
+    std::pmr::unordered_map<std::uint64_t, T> overflow_;
+    // oldest ref the window covers, every ref in overflow_ is below it
+    std::uint64_t base_{0};
+    std::uint64_t mask_{0};
+    std::size_t window_live_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "queue_index.h"
+
+#include <algorithm>
+
+namespace
+{
+
+std::size_t lowbit(std::size_t i)
+{
+    return i & (~i + 1);
+}
+
+}
+
+namespace book
+{
+
+QueueIndex::QueueIndex(const allocator_type& alloc)
+    : seqs_{alloc},
+      orders_{alloc},
+      shares_{alloc}
+{
+}
+
+void QueueIndex::push(std::uint32_t seq, std::uint32_t shares)
+{
+    if (orders_.empty())
+    {
+        orders_.push_back(0);
+        shares_.push_back(0);
+    }
+    seqs_.push_back(seq);
+    const auto i{seqs_.size()};
+    // a new node covers (i - lowbit(i), i], everything but itself is already in the tree
+    const auto covered{prefix(i - 1)};
+    const auto uncovered{prefix(i - lowbit(i))};
+    orders_.push_back(1 + covered.orders - uncovered.orders);
+    shares_.push_back(shares + covered.shares - uncovered.shares);
+    ++live_;
+}
+
+void QueueIndex::take(std::uint32_t seq, std::uint32_t shares, bool gone)
+{
+    for (auto i{slot(seq) + 1}; i < orders_.size(); i += lowbit(i))
+    {
+        shares_[i] -= shares;
+        orders_[i] -= gone ? 1 : 0;
+    }
+    live_ -= gone ? 1 : 0;
+    if (seqs_.size() > 2 * live_ + 64)
+    {
+        compact();
+    }
+}
+
+QueueIndex::Ahead QueueIndex::ahead_of(std::uint32_t seq) const
+{
+    return prefix(slot(seq));
+}
+
+std::size_t QueueIndex::slots() const noexcept
+{
+    return seqs_.size();
+}
+
+std::size_t QueueIndex::live() const noexcept
+{
+    return live_;
+}
+
+std::size_t QueueIndex::slot(std::uint32_t seq) const
+{
+    return static_cast<std::size_t>(std::ranges::lower_bound(seqs_, seq) - seqs_.begin());
+}
+
+// sums over the first end slots
+QueueIndex::Ahead QueueIndex::prefix(std::size_t end) const
+{
+    Ahead sum{.orders = 0, .shares = 0};
+    for (auto i{end}; i > 0; i -= lowbit(i))
+    {
+        sum.orders += orders_[i];
+        sum.shares += shares_[i];
+    }
+    return sum;
+}
+
+// O(slots): trees back to per-slot counts, drop the dead slots, then the trees again
+void QueueIndex::compact()
+{
+    const auto slots{seqs_.size()};
+    for (auto i{slots}; i > 0; --i)
+    {
+        if (const auto parent{i + lowbit(i)}; parent <= slots)
+        {
+            orders_[parent] -= orders_[i];
+            shares_[parent] -= shares_[i];
+        }
+    }
+
+    std::size_t kept{0};
+    for (std::size_t i = 1; i <= slots; ++i)
+    {
+        if (orders_[i] != 0)
+        {
+            seqs_[kept] = seqs_[i - 1];
+            ++kept;
+            orders_[kept] = orders_[i];
+            shares_[kept] = shares_[i];
+        }
+    }
+    seqs_.resize(kept);
+    orders_.resize(kept + 1);
+    shares_.resize(kept + 1);
+
+    for (std::size_t i = 1; i <= kept; ++i)
+    {
+        if (const auto parent{i + lowbit(i)}; parent <= kept)
+        {
+            orders_[parent] += orders_[i];
+            shares_[parent] += shares_[i];
+        }
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef BOOK_QUEUE_INDEX_H_
+#define BOOK_QUEUE_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace book
+{
+
+// one price level's queue in time priority, Fenwick trees over order count and shares
+// entries only ever append (enqueue stamps rise), removed ones stay as zeros until they outnumber
+// the live ones, then the index compacts in place
+class QueueIndex
+{
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    QueueIndex() = default;
+    explicit QueueIndex(const allocator_type& alloc);
+
+    void push(std::uint32_t seq, std::uint32_t shares);
+    // shares taken off the order at seq, gone if it left the queue
+    void take(std::uint32_t seq, std::uint32_t shares, bool gone);
+
+    struct Ahead
+    {
+        std::uint32_t orders;
+        std::uint64_t shares;
+    };
+
+    // everything queued before seq, which must be live
+    [[nodiscard]]
+    Ahead ahead_of(std::uint32_t seq) const;
+
+    [[nodiscard]]
+    std::size_t slots() const noexcept;
+    [[nodiscard]]
+    std::size_t live() const noexcept;
+
+  private:
+    std::size_t slot(std::uint32_t seq) const;
+    Ahead prefix(std::size_t end) const;
+    void compact();
+
+    std::pmr::vector<std::uint32_t> seqs_;
+    // 1-based Fenwick nodes, index 0 unused and only there once the first order is
+    std::pmr::vector<std::uint32_t> orders_;
+    std::pmr::vector<std::uint64_t> shares_;
+    std::size_t live_{0};
+};
+
+}
+
+#endif
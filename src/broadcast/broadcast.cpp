@@ -0,0 +1,394 @@
+#include "broadcast.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <print>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../rt/tuning.h"
+
+namespace
+{
+
+constexpr std::size_t header_size{sizeof(broadcast::Header)};
+
+// shm_open wants a leading slash
+std::string shm_name(const std::string& name)
+{
+    return name.starts_with('/') ? name : "/" + name;
+}
+
+std::byte* map_segment(int fd, std::size_t bytes)
+{
+    void* ptr{mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0)};
+    return ptr == MAP_FAILED ? nullptr : static_cast<std::byte*>(ptr);
+}
+
+// free, or held by a process that is gone without giving it back
+bool take_cursor(broadcast::Cursor& cursor, std::int32_t pid)
+{
+    auto holder{cursor.pid.load(std::memory_order_relaxed)};
+    if (holder != 0 && (kill(holder, 0) == 0 || errno != ESRCH))
+    {
+        return false;
+    }
+    return cursor.pid.compare_exchange_strong(holder, pid, std::memory_order_acq_rel);
+}
+
+void watch(const broadcast::Publisher& ring, std::ostream& out, std::chrono::milliseconds period, const std::stop_token& stop)
+{
+    // created after the receivers are pinned, the scans and the printing go elsewhere
+    if (!rt::leave_rx_cpus())
+    {
+        std::perror("sched_setaffinity broadcast monitor");
+    }
+
+    // what was last said about each reader, by pid; a new reader starts caught up with nothing lost
+    std::unordered_map<std::int32_t, broadcast::ConsumerStatus> reported{};
+    auto next_scan{std::chrono::steady_clock::now() + period};
+    while (!stop.stop_requested())
+    {
+        std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(period, std::chrono::milliseconds{100}));
+        if (std::chrono::steady_clock::now() < next_scan)
+        {
+            continue;
+        }
+        next_scan += period;
+
+        std::unordered_map<std::int32_t, broadcast::ConsumerStatus> current{};
+        for (const auto& consumer : ring.consumers())
+        {
+            const auto it{reported.find(consumer.pid)};
+            const auto lost_before{it == reported.end() ? 0 : it->second.lost};
+            const auto slow_before{it != reported.end() && it->second.slow};
+            if (consumer.lost > lost_before || consumer.slow != slow_before)
+            {
+                std::println(out, "broadcast consumer pid {}: {} behind, {} lost{}", consumer.pid, consumer.behind, consumer.lost, consumer.slow ? ", slow" : "");
+            }
+            current.emplace(consumer.pid, consumer);
+        }
+        reported = std::move(current);
+    }
+}
+
+}
+
+namespace broadcast
+{
+
+std::optional<Publisher> Publisher::create(const std::string& name, std::size_t records)
+{
+    if (!std::has_single_bit(records))
+    {
+        std::println(std::cerr, "broadcast ring of {} events is not a power of two", records);
+        return std::nullopt;
+    }
+
+    // a fresh segment, readers still mapping an old one must not see it truncated under them
+    const auto path{shm_name(name)};
+    shm_unlink(path.c_str());
+    const int fd{shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660)};
+    if (fd < 0)
+    {
+        std::perror("shm_open broadcast");
+        return std::nullopt;
+    }
+    FD file{fd};
+
+    const auto bytes{header_size + records * sizeof(journal::Event)};
+    if (const auto err{posix_fallocate(file.fd(), 0, static_cast<off_t>(bytes))}; err != 0)
+    {
+        std::println(std::cerr, "posix_fallocate broadcast: {}", std::strerror(err));
+        shm_unlink(path.c_str());
+        return std::nullopt;
+    }
+
+    auto* map{map_segment(file.fd(), bytes)};
+    if (map == nullptr)
+    {
+        std::perror("mmap broadcast");
+        shm_unlink(path.c_str());
+        return std::nullopt;
+    }
+
+    // take the write faults up front
+    const auto page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto* volatile_map{static_cast<volatile std::byte*>(map)};
+    for (std::size_t offset = 0; offset < bytes; offset += page)
+    {
+        volatile_map[offset] = std::byte{0};
+    }
+
+    return Publisher{path, std::move(file), map, bytes};
+}
+
+Publisher::Publisher(std::string name, FD file, std::byte* map, std::size_t map_bytes)
+    : name_{std::move(name)},
+      file_{std::move(file)},
+      map_{map},
+      map_bytes_{map_bytes},
+      header_{new (map) Header{.magic = broadcast::magic,
+                               .record_size = sizeof(journal::Event),
+                               .header_size = header_size,
+                               .capacity = (map_bytes - header_size) / sizeof(journal::Event),
+                               .claimed = 0,
+                               .published = 0,
+                               .consumers = {}}},
+      records_{reinterpret_cast<journal::Event*>(map + header_size), (map_bytes - header_size) / sizeof(journal::Event)}
+{
+}
+
+Publisher::Publisher(Publisher&& other) noexcept
+    : name_{std::move(other.name_)},
+      file_{std::move(other.file_)},
+      map_{std::exchange(other.map_, nullptr)},
+      map_bytes_{std::exchange(other.map_bytes_, 0)},
+      header_{std::exchange(other.header_, nullptr)},
+      records_{std::exchange(other.records_, {})},
+      next_{other.next_}
+{
+}
+
+Publisher& Publisher::operator=(Publisher&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (map_ != nullptr)
+        {
+            munmap(map_, map_bytes_);
+            shm_unlink(name_.c_str());
+        }
+        name_ = std::move(other.name_);
+        file_ = std::move(other.file_);
+        map_ = std::exchange(other.map_, nullptr);
+        map_bytes_ = std::exchange(other.map_bytes_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        records_ = std::exchange(other.records_, {});
+        next_ = other.next_;
+    }
+    return *this;
+}
+
+Publisher::~Publisher()
+{
+    if (map_ != nullptr)
+    {
+        commit();
+        munmap(map_, map_bytes_);
+        shm_unlink(name_.c_str());
+    }
+}
+
+void Publisher::commit() noexcept
+{
+    header_->published.store(next_, std::memory_order_release);
+}
+
+std::uint64_t Publisher::written() const noexcept
+{
+    return next_;
+}
+
+std::vector<ConsumerStatus> Publisher::consumers() const
+{
+    std::vector<ConsumerStatus> out{};
+    const auto published{header_->published.load(std::memory_order_acquire)};
+    for (const auto& cursor : header_->consumers)
+    {
+        const auto pid{cursor.pid.load(std::memory_order_acquire)};
+        if (pid == 0)
+        {
+            continue;
+        }
+        const auto next{cursor.next.load(std::memory_order_relaxed)};
+        const auto behind{published > next ? published - next : 0};
+        out.push_back({.pid = pid,
+                       .behind = behind,
+                       .lost = cursor.lost.load(std::memory_order_relaxed),
+                       .slow = behind > records_.size() / 2});
+    }
+    return out;
+}
+
+ConsumerMonitor::ConsumerMonitor(const Publisher& ring, std::ostream& out, std::chrono::milliseconds period)
+    : thread_{[&ring, &out, period](const std::stop_token& stop) { watch(ring, out, period, stop); }}
+{
+}
+
+journal::Event* Publisher::next(const itch::MessageHeader& header, journal::EventType type) noexcept
+{
+    // readers must be able to tell the slot is being reused before any of it changes
+    header_->claimed.store(next_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto& event{records_[next_ & (records_.size() - 1)]};
+    event.sequence = next_;
+    event.timestamp = header.timestamp;
+    event.stock_locate = header.stock_locate;
+    event.type = type;
+    ++next_;
+    return &event;
+}
+
+std::optional<Subscriber> Subscriber::attach(const std::string& name)
+{
+    const auto path{shm_name(name)};
+    const int fd{shm_open(path.c_str(), O_RDWR, 0)};
+    if (fd < 0)
+    {
+        std::perror("shm_open broadcast");
+        return std::nullopt;
+    }
+    FD file{fd};
+
+    struct stat st{};
+    if (fstat(file.fd(), &st) < 0 || static_cast<std::size_t>(st.st_size) < header_size)
+    {
+        std::println(std::cerr, "broadcast ring {} is truncated", name);
+        return std::nullopt;
+    }
+
+    const auto bytes{static_cast<std::size_t>(st.st_size)};
+    auto* map{map_segment(file.fd(), bytes)};
+    if (map == nullptr)
+    {
+        std::perror("mmap broadcast");
+        return std::nullopt;
+    }
+
+    auto* header{reinterpret_cast<Header*>(map)};
+    if (header->magic != broadcast::magic || header->record_size != sizeof(journal::Event) || header->header_size != header_size ||
+        !std::has_single_bit(header->capacity) || header_size + header->capacity * sizeof(journal::Event) != bytes)
+    {
+        std::println(std::cerr, "{} is not a broadcast ring this build can read", name);
+        munmap(map, bytes);
+        return std::nullopt;
+    }
+
+    const auto pid{static_cast<std::int32_t>(getpid())};
+    const auto cursor{std::ranges::find_if(header->consumers, [&](Cursor& candidate) { return take_cursor(candidate, pid); })};
+    if (cursor == header->consumers.end())
+    {
+        std::println(std::cerr, "broadcast ring {} has no free cursor", name);
+        munmap(map, bytes);
+        return std::nullopt;
+    }
+
+    return Subscriber{std::move(file), map, bytes, &*cursor};
+}
+
+Subscriber::Subscriber(FD file, std::byte* map, std::size_t map_bytes, Cursor* cursor)
+    : file_{std::move(file)},
+      map_{map},
+      map_bytes_{map_bytes},
+      header_{reinterpret_cast<const Header*>(map)},
+      records_{reinterpret_cast<const journal::Event*>(map + header_size), header_->capacity},
+      cursor_{cursor},
+      next_{header_->published.load(std::memory_order_acquire)}
+{
+    cursor_->lost.store(0, std::memory_order_relaxed);
+    cursor_->next.store(next_, std::memory_order_release);
+}
+
+Subscriber::Subscriber(Subscriber&& other) noexcept
+    : file_{std::move(other.file_)},
+      map_{std::exchange(other.map_, nullptr)},
+      map_bytes_{std::exchange(other.map_bytes_, 0)},
+      header_{std::exchange(other.header_, nullptr)},
+      records_{std::exchange(other.records_, {})},
+      cursor_{std::exchange(other.cursor_, nullptr)},
+      next_{other.next_},
+      lost_{other.lost_}
+{
+}
+
+Subscriber& Subscriber::operator=(Subscriber&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (map_ != nullptr)
+        {
+            cursor_->pid.store(0, std::memory_order_release);
+            munmap(map_, map_bytes_);
+        }
+        file_ = std::move(other.file_);
+        map_ = std::exchange(other.map_, nullptr);
+        map_bytes_ = std::exchange(other.map_bytes_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        records_ = std::exchange(other.records_, {});
+        cursor_ = std::exchange(other.cursor_, nullptr);
+        next_ = other.next_;
+        lost_ = other.lost_;
+    }
+    return *this;
+}
+
+Subscriber::~Subscriber()
+{
+    if (map_ != nullptr)
+    {
+        cursor_->pid.store(0, std::memory_order_release);
+        munmap(map_, map_bytes_);
+    }
+}
+
+std::span<const journal::Event> Subscriber::poll(std::span<journal::Event> out) noexcept
+{
+    const auto capacity{records_.size()};
+    const auto published{header_->published.load(std::memory_order_acquire)};
+    // lapped since the last poll, start again from the newest
+    if (published - next_ > capacity)
+    {
+        skip_to(published);
+        return {};
+    }
+
+    const auto count{std::min<std::uint64_t>(published - next_, out.size())};
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        out[i] = records_[(next_ + i) & (capacity - 1)];
+    }
+
+    // whatever the writer had started reusing by the time the copy finished may be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto claimed{header_->claimed.load(std::memory_order_relaxed)};
+    const auto torn{claimed > next_ + capacity ? std::min(count, claimed - capacity - next_) : 0};
+
+    next_ += count;
+    lost_ += torn;
+    cursor_->lost.store(lost_, std::memory_order_relaxed);
+    cursor_->next.store(next_, std::memory_order_release);
+    return std::span<const journal::Event>{out}.subspan(torn, count - torn);
+}
+
+std::uint64_t Subscriber::position() const noexcept
+{
+    return next_;
+}
+
+std::uint64_t Subscriber::lost() const noexcept
+{
+    return lost_;
+}
+
+void Subscriber::skip_to(std::uint64_t sequence) noexcept
+{
+    lost_ += sequence - next_;
+    next_ = sequence;
+    cursor_->lost.store(lost_, std::memory_order_relaxed);
+    cursor_->next.store(next_, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef BROADCAST_BROADCAST_H_
+#define BROADCAST_BROADCAST_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "format.h"
+#include "../fd/fd.h"
+#include "../journal/events.h"
+
+namespace broadcast
+{
+
+struct ConsumerStatus
+{
+    std::int32_t pid;
+    // published events it has yet to read
+    std::uint64_t behind;
+    std::uint64_t lost;
+    // more than half a ring behind, one more stall and it is lapped
+    bool slow;
+};
+
+// the one writer of a shared-memory ring of book events, any number of local processes read it
+// it never waits on a reader: the oldest events are overwritten and a reader that falls a ring
+// behind finds out from its own cursor
+class Publisher : public journal::EventWriter<Publisher>
+{
+  public:
+    // replaces any ring already under name; records must be a power of two
+    static std::optional<Publisher> create(const std::string& name, std::size_t records);
+
+    Publisher(const Publisher&) = delete;
+    Publisher& operator=(const Publisher&) = delete;
+    Publisher(Publisher&& other) noexcept;
+    Publisher& operator=(Publisher&& other) noexcept;
+    // unlinks the name, readers already attached keep their mapping
+    ~Publisher();
+
+    // make everything written so far visible to readers
+    void commit() noexcept;
+
+    [[nodiscard]]
+    std::uint64_t written() const noexcept;
+    // every attached reader and how far behind the last commit it is
+    [[nodiscard]]
+    std::vector<ConsumerStatus> consumers() const;
+
+  private:
+    friend class journal::EventWriter<Publisher>;
+
+    Publisher(std::string name, FD file, std::byte* map, std::size_t map_bytes);
+
+    journal::Event* next(const itch::MessageHeader& header, journal::EventType type) noexcept;
+
+    std::string name_;
+    FD file_;
+    std::byte* map_;
+    std::size_t map_bytes_;
+    Header* header_;
+    std::span<journal::Event> records_;
+    std::uint64_t next_{0};
+};
+
+// looks at the ring's readers every period from its own thread, off the receivers' cores, and
+// writes a reader's status to out whenever it turns slow, loses events or catches up again
+class ConsumerMonitor
+{
+  public:
+    ConsumerMonitor(const Publisher& ring, std::ostream& out, std::chrono::milliseconds period = std::chrono::seconds{1});
+
+    ConsumerMonitor(const ConsumerMonitor&) = delete;
+    ConsumerMonitor& operator=(const ConsumerMonitor&) = delete;
+    ConsumerMonitor(ConsumerMonitor&&) = delete;
+    ConsumerMonitor& operator=(ConsumerMonitor&&) = delete;
+    // stops within 100ms
+    ~ConsumerMonitor() = default;
+
+  private:
+    std::jthread thread_;
+};
+
+// one reader of a ring, attached at the newest event, with its own cursor in the ring's header
+class Subscriber
+{
+  public:
+    // nullopt if there is no ring under name or every cursor is taken by a live process
+    static std::optional<Subscriber> attach(const std::string& name);
+
+    Subscriber(const Subscriber&) = delete;
+    Subscriber& operator=(const Subscriber&) = delete;
+    Subscriber(Subscriber&& other) noexcept;
+    Subscriber& operator=(Subscriber&& other) noexcept;
+    // gives the cursor back
+    ~Subscriber();
+
+    // copies up to out.size() published events into out and returns those that are whole; events
+    // the writer reused before they were read are skipped and counted in lost()
+    std::span<const journal::Event> poll(std::span<journal::Event> out) noexcept;
+
+    // sequence of the next event poll returns
+    [[nodiscard]]
+    std::uint64_t position() const noexcept;
+    [[nodiscard]]
+    std::uint64_t lost() const noexcept;
+
+  private:
+    Subscriber(FD file, std::byte* map, std::size_t map_bytes, Cursor* cursor);
+
+    void skip_to(std::uint64_t sequence) noexcept;
+
+    FD file_;
+    std::byte* map_;
+    std::size_t map_bytes_;
+    const Header* header_;
+    std::span<const journal::Event> records_;
+    Cursor* cursor_;
+    std::uint64_t next_;
+    std::uint64_t lost_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef BROADCAST_FORMAT_H_
+#define BROADCAST_FORMAT_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../journal/format.h"
+#include "../util/cache.h"
+
+// shared-memory layout of the broadcast ring: a header, then a power of two of journal::Event
+namespace broadcast
+{
+
+inline constexpr std::array<char, 8> magic{'L', '3', 'B', 'C', 'A', 'S', 'T', '1'};
+
+inline constexpr std::size_t max_consumers{32};
+
+// one attached consumer, written only by it; the writer reads them to report who is behind
+struct alignas(util::cache_line_size) Cursor
+{
+    // 0 while the slot is free
+    std::atomic<std::int32_t> pid;
+    // the next sequence it will read
+    std::atomic<std::uint64_t> next;
+    // events it lost to the writer lapping it
+    std::atomic<std::uint64_t> lost;
+};
+
+// the writer moves claimed past a sequence before reusing its slot, and published once every
+// record below it is complete; a reader that copied a slot and then sees claimed more than a
+// ring's length past it read a slot that was being overwritten
+struct alignas(util::cache_line_size) Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t record_size;
+    std::uint32_t header_size;
+    // records, a power of two
+    std::uint64_t capacity;
+    alignas(util::cache_line_size) std::atomic<std::uint64_t> claimed;
+    alignas(util::cache_line_size) std::atomic<std::uint64_t> published;
+    std::array<Cursor, max_consumers> consumers;
+};
+
+static_assert(std::atomic<std::int32_t>::is_always_lock_free);
+static_assert(sizeof(Header) % sizeof(journal::Event) == 0);
+
+}
+
+#endif
@@ -0,0 +1,323 @@
+#include "options.h"
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <print>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+void print_usage(std::string_view program)
+{
+    std::println(std::cerr,
+                 "usage: {} [--hugepages=explicit|transparent|off] [--arena-mib=<n>] [--rx-cpu=<n>]\n"
+                 "       [--low-latency] [--busy-poll-us=<n>] [--rcvbuf-kib=<n>] [--latency] [--signals]\n"
+                 "       [--journal=<path>] [--journal-mib=<n>] [--metrics-socket=<path>] [--match-capacity=<n>]\n"
+                 "       [--broadcast=<shm name>] [--broadcast-events=<n>] [--dense-ladder=<symbol>[,<symbol>...]]\n"
+                 "       [--snapshot=<path>|tcp://<ipv4>:<port>] [--late-join-mib=<n>] [--save-snapshot=<path>]\n"
+                 "       <multicast_group> <port> | --channels=<file of \"<multicast_group> <port> [<cpu>]\" lines>\n"
+                 "         with several channels each journals to <path>.<n> and broadcasts on <shm name>.<n>, n its\n"
+                 "         place in the list from 0; --snapshot and --save-snapshot take a single channel\n"
+                 "       {} [--hugepages=explicit|transparent|off] [--arena-mib=<n>] --replay=<itch file> [--replay-threads=<n>]\n"
+                 "       [--dense-ladder=<symbol>[,<symbol>...]]\n"
+                 "       {} --replay=<itch file> --locate=<n> --at=<ns since midnight>\n"
+                 "       {} --index=<itch file> [--checkpoint-secs=<n>] [--replay-threads=<n>]\n"
+                 "       {} --compress=<itch file>",
+                 program,
+                 program,
+                 program,
+                 program,
+                 program);
+}
+
+template <typename T>
+std::optional<T> parse_number(std::string_view text)
+{
+    T value{};
+    const auto [end, ec]{std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (ec != std::errc{} || end != text.data() + text.size())
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// "--name=value" -> value if the flag matches
+std::optional<std::string_view> flag_value(std::string_view arg, std::string_view name)
+{
+    if (!arg.starts_with(name) || arg.size() <= name.size() || arg[name.size()] != '=')
+    {
+        return std::nullopt;
+    }
+    return arg.substr(name.size() + 1);
+}
+
+// true if arg is "--name=<n>" with a valid n, stored scaled by unit
+template <typename T>
+bool parse_number_flag(std::string_view arg, std::string_view name, T& out, T unit = 1)
+{
+    const auto value{flag_value(arg, name)};
+    if (!value)
+    {
+        return false;
+    }
+    const auto number{parse_number<T>(*value)};
+    if (!number || std::cmp_less(*number, 0) || *number > std::numeric_limits<T>::max() / unit)
+    {
+        return false;
+    }
+    out = static_cast<T>(*number * unit);
+    return true;
+}
+
+// "<multicast_group> <port>" with port in range
+std::optional<cli::Channel> parse_channel(std::string_view group, std::string_view port_text)
+{
+    const auto port{parse_number<int>(port_text).value_or(0)};
+    if (port <= 0 || port > 65535)
+    {
+        std::println(std::cerr, "invalid port number {}", port_text);
+        return std::nullopt;
+    }
+    return cli::Channel{.mcast_group = std::string{group}, .port = port, .cpu = std::nullopt};
+}
+
+// one "<multicast_group> <port> [<cpu>]" per line, # starts a comment
+std::optional<std::vector<cli::Channel>> read_channels(const std::string& path)
+{
+    std::ifstream in{path};
+    if (!in)
+    {
+        std::println(std::cerr, "can't read channels from {}", path);
+        return std::nullopt;
+    }
+
+    std::vector<cli::Channel> channels{};
+    for (std::string line{}; std::getline(in, line);)
+    {
+        std::istringstream fields{line.substr(0, line.find('#'))};
+        std::string group{};
+        std::string port{};
+        std::string cpu{};
+        if (!(fields >> group))
+        {
+            continue;
+        }
+        fields >> port >> cpu;
+
+        auto channel{parse_channel(group, port)};
+        if (!channel)
+        {
+            return std::nullopt;
+        }
+        if (!cpu.empty())
+        {
+            channel->cpu = parse_number<int>(cpu);
+            if (!channel->cpu || *channel->cpu < 0)
+            {
+                std::println(std::cerr, "invalid cpu {} for {}:{}", cpu, group, port);
+                return std::nullopt;
+            }
+        }
+        channels.push_back(std::move(*channel));
+    }
+    if (channels.empty())
+    {
+        std::println(std::cerr, "no channels in {}", path);
+        return std::nullopt;
+    }
+    return channels;
+}
+
+template <typename T>
+bool parse_number_flag(std::string_view arg, std::string_view name, std::optional<T>& out)
+{
+    T value{};
+    if (!parse_number_flag(arg, name, value))
+    {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+}
+
+namespace cli
+{
+
+std::optional<Options> parse_options(int argc, char** argv)
+{
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    Options options{};
+    std::vector<std::string_view> positional{};
+
+    for (std::string_view arg : args.subspan(1))
+    {
+        if (!arg.starts_with("--"))
+        {
+            positional.push_back(arg);
+        }
+        else if (const auto value{flag_value(arg, "--hugepages")})
+        {
+            options.arena_pages = mem::parse_page_mode(*value);
+            if (!options.arena_pages)
+            {
+                std::println(std::cerr, "invalid --hugepages mode {}", *value);
+                print_usage(args[0]);
+                return std::nullopt;
+            }
+        }
+        else if (const auto mib{flag_value(arg, "--arena-mib")})
+        {
+            // an empty arena would spill every allocation to the heap without a word
+            if (!parse_number_flag(arg, "--arena-mib", options.arena_bytes, 1024UL * 1024) || options.arena_bytes == 0)
+            {
+                std::println(std::cerr, "invalid --arena-mib {}", *mib);
+                print_usage(args[0]);
+                return std::nullopt;
+            }
+        }
+        else if (const auto path{flag_value(arg, "--journal")})
+        {
+            options.journal_path = *path;
+        }
+        else if (const auto name{flag_value(arg, "--broadcast")})
+        {
+            options.broadcast_name = *name;
+        }
+        else if (const auto source{flag_value(arg, "--snapshot")})
+        {
+            options.snapshot_source = *source;
+        }
+        else if (const auto snapshot_path{flag_value(arg, "--save-snapshot")})
+        {
+            options.save_snapshot_path = *snapshot_path;
+        }
+        else if (const auto symbols{flag_value(arg, "--dense-ladder")})
+        {
+            for (const auto symbol : std::views::split(*symbols, ','))
+            {
+                if (!symbol.empty())
+                {
+                    options.dense_symbols.emplace_back(std::string_view{symbol});
+                }
+            }
+        }
+        else if (const auto channels_path{flag_value(arg, "--channels")})
+        {
+            auto channels{read_channels(std::string{*channels_path})};
+            if (!channels)
+            {
+                return std::nullopt;
+            }
+            options.channels = std::move(*channels);
+        }
+        else if (const auto socket_path{flag_value(arg, "--metrics-socket")})
+        {
+            options.metrics_socket = *socket_path;
+        }
+        else if (const auto replay_path{flag_value(arg, "--replay")})
+        {
+            options.replay_path = *replay_path;
+        }
+        else if (const auto compress_path{flag_value(arg, "--compress")})
+        {
+            options.compress_path = *compress_path;
+        }
+        else if (const auto index_archive{flag_value(arg, "--index")})
+        {
+            options.index_archive = *index_archive;
+        }
+        else if (arg == "--low-latency")
+        {
+            options.low_latency = true;
+        }
+        else if (arg == "--latency")
+        {
+            options.latency = true;
+        }
+        else if (arg == "--signals")
+        {
+            options.signals = true;
+        }
+        else if (!parse_number_flag(arg, "--rx-cpu", options.rx_cpu) &&
+                 !parse_number_flag(arg, "--busy-poll-us", options.busy_poll_us) &&
+                 !parse_number_flag(arg, "--rcvbuf-kib", options.rcvbuf_bytes, 1024) &&
+                 !parse_number_flag(arg, "--journal-mib", options.journal_bytes, 1024UL * 1024) &&
+                 !parse_number_flag(arg, "--broadcast-events", options.broadcast_events) &&
+                 !parse_number_flag(arg, "--late-join-mib", options.late_join_bytes, 1024UL * 1024) &&
+                 !parse_number_flag(arg, "--match-capacity", options.match_capacity) &&
+                 !parse_number_flag(arg, "--replay-threads", options.replay_threads) &&
+                 !parse_number_flag(arg, "--checkpoint-secs", options.checkpoint_secs) &&
+                 !parse_number_flag(arg, "--locate", options.query_locate) &&
+                 !parse_number_flag(arg, "--at", options.query_at_ns))
+        {
+            std::println(std::cerr, "invalid option {}", arg);
+            print_usage(args[0]);
+            return std::nullopt;
+        }
+    }
+
+    if (options.replay_path || options.index_archive || options.compress_path)
+    {
+        if (!positional.empty() || options.query_locate.has_value() != options.query_at_ns.has_value())
+        {
+            print_usage(args[0]);
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    if (options.channels.empty() && positional.size() == 2)
+    {
+        auto channel{parse_channel(positional[0], positional[1])};
+        if (!channel)
+        {
+            return std::nullopt;
+        }
+        options.channels.push_back(std::move(*channel));
+    }
+    else if (options.channels.empty() || !positional.empty())
+    {
+        print_usage(args[0]);
+        return std::nullopt;
+    }
+
+    // a snapshot is as of one session's sequence
+    if ((options.snapshot_source || options.save_snapshot_path) && options.channels.size() > 1)
+    {
+        std::println(std::cerr, "--snapshot and --save-snapshot take a single channel");
+        return std::nullopt;
+    }
+
+    if (options.rx_cpu)
+    {
+        for (std::size_t i = 0; i < options.channels.size(); ++i)
+        {
+            auto& cpu{options.channels[i].cpu};
+            if (!cpu)
+            {
+                cpu = *options.rx_cpu + static_cast<int>(i);
+            }
+        }
+    }
+
+    return options;
+}
+
+std::string channel_path(const std::string& name, std::size_t channel, std::size_t channels)
+{
+    return channels > 1 ? std::format("{}.{}", name, channel) : name;
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef CLI_OPTIONS_H_
+#define CLI_OPTIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../mem/arena.h"
+
+namespace cli
+{
+
+// one MoldUDP64 session on its own multicast group and port
+struct Channel
+{
+    std::string mcast_group;
+    int port;
+    // its receive thread, which also applies the locates the channel carries
+    std::optional<int> cpu;
+};
+
+struct Options
+{
+    // one from the command line, or any number from --channels
+    std::vector<Channel> channels;
+    // unset keeps book storage on the default heap
+    std::optional<mem::PageMode> arena_pages;
+    std::size_t arena_bytes{1024UL * 1024 * 1024};
+    // first receive thread, channels without their own cpu take the ones after it
+    std::optional<int> rx_cpu;
+    // mlockall, busy poll + big rcvbuf on the socket, spin on a non-blocking receive
+    bool low_latency{false};
+    int busy_poll_us{50};
+    int rcvbuf_bytes{16 * 1024 * 1024};
+    // kernel rx timestamps, wire-to-book and feed transit histograms printed on exit
+    bool latency{false};
+    // per-locate microstructure signals kept on the market as the book updates
+    bool signals{false};
+    // latest match numbers kept for broken trades, off at 0; 16 bytes each per channel, rounded up
+    // to a power of two and zeroed up front
+    std::size_t match_capacity{0};
+    // liquid names whose books keep a dense price ladder around the touch
+    std::vector<std::string> dense_symbols;
+    // normalized book events, preallocated to journal_bytes; each channel writes its own, see channel_path
+    std::optional<std::string> journal_path;
+    std::size_t journal_bytes{1024UL * 1024 * 1024};
+    // the same events in a shared-memory ring local processes read instead of building books, one
+    // per channel like the journal
+    std::optional<std::string> broadcast_name;
+    // a power of two, 64 bytes each
+    std::size_t broadcast_events{1UL << 20};
+    // late join: load the books from a snapshot (a path or tcp://<ipv4>:<port>) and replay the
+    // packets held meanwhile from its sequence, holding at most late_join_bytes of them
+    std::optional<std::string> snapshot_source;
+    std::size_t late_join_bytes{256UL * 1024 * 1024};
+    // a snapshot of the books on the way out, for a later late join
+    std::optional<std::string> save_snapshot_path;
+    // unix socket serving counter snapshots
+    std::optional<std::string> metrics_socket;
+    // offline: rebuild books from a BinaryFILE instead of joining the feed, 0 threads = one per cpu
+    std::optional<std::string> replay_path;
+    std::size_t replay_threads{0};
+    // offline: write a compressed archive of a BinaryFILE and exit, --replay takes either
+    std::optional<std::string> compress_path;
+    // offline: write the per-locate sidecar index for a BinaryFILE and exit
+    std::optional<std::string> index_archive;
+    // book checkpoints written alongside the index, 0 skips them
+    std::uint64_t checkpoint_secs{60};
+    // with replay: rebuild just this locate as of at_ns (since midnight) from the sidecars
+    std::optional<std::uint16_t> query_locate;
+    std::optional<std::uint64_t> query_at_ns;
+};
+
+// prints usage and returns nullopt on bad input
+std::optional<Options> parse_options(int argc, char** argv);
+
+// a journal path or ring name for one of channels: as given for a single channel, <name>.<channel>
+// with several, so each has the channel's receiver as its one writer
+std::string channel_path(const std::string& name, std::size_t channel, std::size_t channels);
+
+}
+
+#endif
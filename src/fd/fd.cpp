@@ -23,7 +23,7 @@ FD& FD::operator=(FD&& other) noexcept
 {
     if (this != &other)
     {
-        if (fd_ <= 0)
+        if (fd_ >= 0)
         {
             close(fd_);
         }
@@ -35,7 +35,7 @@ FD& FD::operator=(FD&& other) noexcept
 FD::~FD()
 {
 
-    if (fd_ <= 0)
+    if (fd_ >= 0)
     {
         close(fd_);
     }
@@ -0,0 +1,221 @@
+#ifndef FEED_DECODER_H_
+#define FEED_DECODER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "../itch/parser.h"
+#include "../itch/types.h"
+#include "../util/binary_io.h"
+
+namespace feed
+{
+
+using Session = std::array<char, 10>;
+
+struct MoldUDP64Header
+{
+    Session session;
+    std::uint64_t sequence_number;
+    std::uint16_t msg_count;
+};
+
+// a handler takes the messages it has an on(const Message&) for, the decoder never parses the rest
+template <typename Handler, typename Message>
+concept Handles = requires(Handler& handler, const Message& msg) { handler.on(msg); };
+
+// optional packet hooks, each called only if the handler has it:
+//   on_packet(const MoldUDP64Header&)           before the first message
+//   on_type(itch::MessageType)                  every message, handled or not
+//   sheds(itch::MessageType)                    true skips the message unparsed, after on_type
+//   on_malformed(const MoldUDP64Header&, index) the packet ends short or a message is shorter than
+//                                               its type, decoding stops
+//   on_unknown(itch::MessageType)               a type itch 5.0 does not define
+//   on_packet_end()                             after the last message
+
+namespace detail
+{
+
+template <auto Parse, typename Handler>
+void deliver(Handler& handler, std::span<const std::byte> body)
+{
+    using Message = decltype(Parse(body));
+    if constexpr (Handles<Handler, Message>)
+    {
+        handler.on(Parse(body));
+    }
+}
+
+}
+
+// one itch message body (after the type byte) to the handler, all dispatch resolved at compile time;
+// false without parsing it if the body is shorter than its type's wire size
+template <typename Handler>
+bool dispatch(itch::MessageType type, std::span<const std::byte> body, Handler& handler)
+{
+    if (body.size() < itch::body_size(type))
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case itch::MessageType::SystemEvent:
+        detail::deliver<itch::parse_system_event_message>(handler, body);
+        break;
+    case itch::MessageType::StockDirectory:
+        detail::deliver<itch::parse_stock_directory_message>(handler, body);
+        break;
+    case itch::MessageType::StockTradingAction:
+        detail::deliver<itch::parse_stock_trading_action_message>(handler, body);
+        break;
+    case itch::MessageType::RegSHORestriction:
+        detail::deliver<itch::parse_reg_sho_restriction_message>(handler, body);
+        break;
+    case itch::MessageType::MarketParticipantPosition:
+        detail::deliver<itch::parse_market_participant_position_message>(handler, body);
+        break;
+    case itch::MessageType::MWCBDeclineLevel:
+        detail::deliver<itch::parse_mwcb_decline_level_message>(handler, body);
+        break;
+    case itch::MessageType::MWCBStatus:
+        detail::deliver<itch::parse_mwcb_status_message>(handler, body);
+        break;
+    case itch::MessageType::IPOQuotingPeriodUpdate:
+        detail::deliver<itch::parse_ipo_quoting_period_update_message>(handler, body);
+        break;
+    case itch::MessageType::LULDAuctionCollar:
+        detail::deliver<itch::parse_luld_auction_collar_message>(handler, body);
+        break;
+    case itch::MessageType::OperationalHalt:
+        detail::deliver<itch::parse_operational_halt_message>(handler, body);
+        break;
+    case itch::MessageType::AddOrder:
+        detail::deliver<itch::parse_add_order_message>(handler, body);
+        break;
+    case itch::MessageType::AddOrderMPID:
+        detail::deliver<itch::parse_add_order_mpid_message>(handler, body);
+        break;
+    case itch::MessageType::OrderExecuted:
+        detail::deliver<itch::parse_order_executed_message>(handler, body);
+        break;
+    case itch::MessageType::OrderExecutedWithPrice:
+        detail::deliver<itch::parse_order_executed_with_price_message>(handler, body);
+        break;
+    case itch::MessageType::OrderCancel:
+        detail::deliver<itch::parse_order_cancel_message>(handler, body);
+        break;
+    case itch::MessageType::OrderDelete:
+        detail::deliver<itch::parse_order_delete_message>(handler, body);
+        break;
+    case itch::MessageType::OrderReplace:
+        detail::deliver<itch::parse_order_replace_message>(handler, body);
+        break;
+    case itch::MessageType::Trade:
+        detail::deliver<itch::parse_trade_message>(handler, body);
+        break;
+    case itch::MessageType::CrossTrade:
+        detail::deliver<itch::parse_cross_trade_message>(handler, body);
+        break;
+    case itch::MessageType::BrokenTrade:
+        detail::deliver<itch::parse_broken_trade_message>(handler, body);
+        break;
+    case itch::MessageType::NOII:
+        detail::deliver<itch::parse_noii_message>(handler, body);
+        break;
+    case itch::MessageType::RPII:
+        detail::deliver<itch::parse_rpii_message>(handler, body);
+        break;
+    case itch::MessageType::DirectListingPriceDiscovery:
+        detail::deliver<itch::parse_direct_listing_price_discovery_message>(handler, body);
+        break;
+    default:
+        if constexpr (requires { handler.on_unknown(type); })
+        {
+            handler.on_unknown(type);
+        }
+        break;
+    }
+    return true;
+}
+
+// one MoldUDP64 packet, returns the exchange timestamp of its first message if it has one
+template <typename Handler>
+std::optional<std::uint64_t> decode_packet(std::span<const std::byte> buffer, Handler& handler)
+{
+    std::optional<std::uint64_t> exchange_ts{};
+    if (buffer.size() < sizeof(Session) + sizeof(std::uint64_t) + sizeof(std::uint16_t))
+    {
+        return exchange_ts;
+    }
+
+    MoldUDP64Header header{};
+    std::size_t pos{0};
+    header.session = util::extract<Session>(buffer, pos);
+    header.sequence_number = util::extract_be<std::uint64_t>(buffer, pos);
+    header.msg_count = util::extract_be<std::uint16_t>(buffer, pos);
+
+    if constexpr (requires { handler.on_packet(header); })
+    {
+        handler.on_packet(header);
+    }
+
+    for (std::size_t i = 0; i < header.msg_count; ++i)
+    {
+        std::uint16_t msg_len{0};
+        if (pos + 2 <= buffer.size())
+        {
+            msg_len = util::extract_be<std::uint16_t>(buffer, pos);
+        }
+        if (msg_len == 0 || pos + msg_len > buffer.size())
+        {
+            if constexpr (requires { handler.on_malformed(header, i); })
+            {
+                handler.on_malformed(header, i);
+            }
+            break;
+        }
+
+        const auto msg_type{static_cast<itch::MessageType>(buffer[pos++])};
+        if constexpr (requires { handler.on_type(msg_type); })
+        {
+            handler.on_type(msg_type);
+        }
+
+        const auto msg_bytes{buffer.subspan(pos, msg_len - 1U)};
+        pos += msg_len - 1U;
+        // a packet's time is its first message's, when that one is long enough to carry it
+        if (i == 0 && msg_bytes.size() >= itch::message_header_size)
+        {
+            exchange_ts = itch::parse_message_header(msg_bytes).timestamp;
+        }
+        if constexpr (requires { handler.sheds(msg_type); })
+        {
+            if (handler.sheds(msg_type))
+            {
+                continue;
+            }
+        }
+        if (!dispatch(msg_type, msg_bytes, handler))
+        {
+            if constexpr (requires { handler.on_malformed(header, i); })
+            {
+                handler.on_malformed(header, i);
+            }
+            break;
+        }
+    }
+
+    if constexpr (requires { handler.on_packet_end(); })
+    {
+        handler.on_packet_end();
+    }
+    return exchange_ts;
+}
+
+}
+
+#endif
@@ -0,0 +1,626 @@
+#ifndef FEED_HANDLERS_H_
+#define FEED_HANDLERS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "../book/market.h"
+#include "../journal/journal.h"
+#include "../logging/logger.h"
+#include "../metrics/metrics.h"
+#include "pipeline.h"
+
+// the stages main composes: book, metrics, signals, journal, broadcast, in that order; the load
+// shedder ahead of them only decides what is parsed at all
+namespace feed
+{
+
+// applies order messages to the books and feeds the market-wide tables, reports what changed;
+// executions go to the channel's own index
+template <book::DepthPolicy Policy>
+class BookHandler
+{
+  public:
+    explicit BookHandler(book::BasicMarket<Policy>& market, std::size_t channel = 0)
+        : market_{market},
+          channel_{channel}
+    {
+    }
+
+    void on(const itch::AddOrderMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).add(msg.order_reference_number, msg.shares, msg.price, msg.side);
+        refresh_top(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::AddOrderMPIDMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).add(msg.order_reference_number, msg.shares, msg.price, msg.side, msg.attribution);
+        refresh_top(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderExecutedMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).reduce(msg.order_reference_number, msg.executed_shares);
+        refresh_top(msg.header.stock_locate, effects.change);
+        if (effects.change)
+        {
+            market_.record_execution(channel_, {.match_number = msg.match_number,
+                                                .price = effects.change->level.price,
+                                                .shares = effects.change->shares,
+                                                .stock_locate = msg.header.stock_locate,
+                                                .side = effects.change->side,
+                                                .kind = book::ExecutionKind::Executed,
+                                                .busted = false});
+        }
+    }
+
+    void on(const itch::OrderExecutedWithPriceMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).reduce(msg.order_reference_number, msg.executed_shares);
+        refresh_top(msg.header.stock_locate, effects.change);
+        if (effects.change)
+        {
+            market_.record_execution(channel_, {.match_number = msg.match_number,
+                                                .price = msg.execution_price,
+                                                .shares = effects.change->shares,
+                                                .stock_locate = msg.header.stock_locate,
+                                                .side = effects.change->side,
+                                                .kind = book::ExecutionKind::ExecutedWithPrice,
+                                                .busted = false});
+        }
+    }
+
+    void on(const itch::OrderCancelMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).reduce(msg.order_reference_number, msg.canceled_shares);
+        refresh_top(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderDeleteMessage& msg, Effects& effects)
+    {
+        effects.change = market_.get_book(msg.header.stock_locate).remove(msg.order_reference_number);
+        refresh_top(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderReplaceMessage& msg, Effects& effects)
+    {
+        effects.replace = market_.get_book(msg.header.stock_locate).replace(msg);
+        if (effects.replace && (effects.replace->removed.top || (effects.replace->added && effects.replace->added->top)))
+        {
+            market_.refresh_top(msg.header.stock_locate);
+        }
+    }
+
+    void on(const itch::TradeMessage& msg)
+    {
+        market_.record_execution(channel_, {.match_number = msg.match_number,
+                                            .price = msg.price,
+                                            .shares = msg.shares,
+                                            .stock_locate = msg.header.stock_locate,
+                                            .side = msg.side,
+                                            .kind = book::ExecutionKind::Trade,
+                                            .busted = false});
+    }
+
+    void on(const itch::CrossTradeMessage& msg)
+    {
+        market_.auctions().on_cross_trade(msg);
+        // a cross has no side of its own
+        market_.record_execution(channel_, {.match_number = msg.match_number,
+                                            .price = msg.cross_price,
+                                            .shares = static_cast<std::uint32_t>(std::min<std::uint64_t>(msg.shares, std::numeric_limits<std::uint32_t>::max())),
+                                            .stock_locate = msg.header.stock_locate,
+                                            .side = itch::Side::Buy,
+                                            .kind = book::ExecutionKind::Cross,
+                                            .busted = false});
+    }
+
+    void on(const itch::BrokenTradeMessage& msg, Effects& effects)
+    {
+        effects.busted = market_.bust(channel_, msg.match_number);
+    }
+
+    void on(const itch::StockDirectoryMessage& msg)
+    {
+        market_.on_stock_directory(msg);
+    }
+
+    void on(const itch::NOIIMessage& msg)
+    {
+        market_.auctions().on_noii(msg);
+    }
+
+    void on(const itch::DirectListingPriceDiscoveryMessage& msg)
+    {
+        market_.auctions().on_direct_listing(msg);
+    }
+
+  private:
+    void refresh_top(std::uint16_t stock_locate, const std::optional<book::Change>& change)
+    {
+        if (change && change->top)
+        {
+            market_.refresh_top(stock_locate);
+        }
+    }
+
+    book::BasicMarket<Policy>& market_;
+    std::size_t channel_;
+};
+
+// the order messages on one standalone book, for replaying a single locate
+template <book::DepthPolicy Policy>
+class OrderHandler
+{
+  public:
+    explicit OrderHandler(book::BasicBook<Policy>& book)
+        : book_{book}
+    {
+    }
+
+    void on(const itch::AddOrderMessage& msg, Effects& effects)
+    {
+        effects.change = book_.add(msg.order_reference_number, msg.shares, msg.price, msg.side);
+    }
+
+    void on(const itch::AddOrderMPIDMessage& msg, Effects& effects)
+    {
+        effects.change = book_.add(msg.order_reference_number, msg.shares, msg.price, msg.side, msg.attribution);
+    }
+
+    void on(const itch::OrderExecutedMessage& msg, Effects& effects)
+    {
+        effects.change = book_.reduce(msg.order_reference_number, msg.executed_shares);
+    }
+
+    void on(const itch::OrderExecutedWithPriceMessage& msg, Effects& effects)
+    {
+        effects.change = book_.reduce(msg.order_reference_number, msg.executed_shares);
+    }
+
+    void on(const itch::OrderCancelMessage& msg, Effects& effects)
+    {
+        effects.change = book_.reduce(msg.order_reference_number, msg.canceled_shares);
+    }
+
+    void on(const itch::OrderDeleteMessage& msg, Effects& effects)
+    {
+        effects.change = book_.remove(msg.order_reference_number);
+    }
+
+    void on(const itch::OrderReplaceMessage& msg, Effects& effects)
+    {
+        effects.replace = book_.replace(msg);
+    }
+
+  private:
+    book::BasicBook<Policy>& book_;
+};
+
+// thread counters, sequence tracking and the packet-level log events
+template <book::DepthPolicy Policy>
+class MetricsHandler
+{
+  public:
+    MetricsHandler(book::BasicMarket<Policy>& market, metrics::Registry& registry, metrics::ThreadCounters& counters, logging::Logger& logger)
+        : market_{market},
+          registry_{registry},
+          counters_{counters},
+          logger_{logger}
+    {
+    }
+
+    void on_packet(const MoldUDP64Header& header)
+    {
+        counters_.packets.add();
+        if (next_sequence_ != 0 && header.sequence_number > next_sequence_)
+        {
+            counters_.sequence_gaps.add();
+            counters_.missed_messages.add(header.sequence_number - next_sequence_);
+        }
+        next_sequence_ = std::max(next_sequence_, header.sequence_number + header.msg_count);
+        session_ = header.session;
+    }
+
+    // where the session is up to, what a snapshot of the books taken now is as of
+    [[nodiscard]]
+    const Session& session() const noexcept
+    {
+        return session_;
+    }
+    [[nodiscard]]
+    std::uint64_t next_sequence() const noexcept
+    {
+        return next_sequence_;
+    }
+
+    void on_type(itch::MessageType type)
+    {
+        counters_.messages[static_cast<unsigned char>(type)].add();
+    }
+
+    void on_malformed(const MoldUDP64Header& header, std::size_t index)
+    {
+        counters_.malformed_packets.add();
+        logger_.log(logging::Event::MalformedPacket, header.sequence_number, index, header.msg_count);
+    }
+
+    void on_unknown(itch::MessageType type)
+    {
+        counters_.unknown_message_types.add();
+        logger_.log(logging::Event::UnknownMessageType, static_cast<std::uint8_t>(type));
+    }
+
+    void on(const itch::AddOrderMessage& msg, const Effects& effects)
+    {
+        added(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::AddOrderMPIDMessage& msg, const Effects& effects)
+    {
+        added(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderExecutedMessage& msg, const Effects& effects)
+    {
+        removed(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderExecutedWithPriceMessage& msg, const Effects& effects)
+    {
+        removed(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderCancelMessage& msg, const Effects& effects)
+    {
+        removed(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderDeleteMessage& msg, const Effects& effects)
+    {
+        removed(msg.header.stock_locate, effects.change);
+    }
+
+    void on(const itch::OrderReplaceMessage& msg, const Effects& effects)
+    {
+        if (!effects.replace)
+        {
+            return;
+        }
+
+        // counted by hand, the book already holds the replacement when we look
+        const auto& book{market_.get_book(msg.header.stock_locate)};
+        counters_.orders_removed.add();
+        if (effects.replace->added)
+        {
+            counters_.orders_added.add();
+            if (effects.replace->added->level.orders == 1)
+            {
+                registry_.observe_levels(msg.header.stock_locate, book.level_count());
+            }
+        }
+        else if (book.order_count() == 0)
+        {
+            counters_.books_deactivated.add();
+        }
+    }
+
+    void on(const itch::BrokenTradeMessage&, const Effects& effects)
+    {
+        if (market_.executions() == nullptr)
+        {
+            return;
+        }
+        if (effects.busted)
+        {
+            counters_.trades_broken.add();
+        }
+        else
+        {
+            counters_.unmatched_busts.add();
+        }
+    }
+
+  private:
+    void added(std::uint16_t stock_locate, const std::optional<book::Change>& change)
+    {
+        if (!change)
+        {
+            return;
+        }
+        const auto& book{market_.get_book(stock_locate)};
+        counters_.orders_added.add();
+        if (change->level.orders == 1)
+        {
+            registry_.observe_levels(stock_locate, book.level_count());
+        }
+        if (book.order_count() == 1)
+        {
+            counters_.books_activated.add();
+        }
+    }
+
+    void removed(std::uint16_t stock_locate, const std::optional<book::Change>& change)
+    {
+        if (!change || change->order_shares != 0)
+        {
+            return;
+        }
+        counters_.orders_removed.add();
+        if (market_.get_book(stock_locate).order_count() == 0)
+        {
+            counters_.books_deactivated.add();
+        }
+    }
+
+    book::BasicMarket<Policy>& market_;
+    metrics::Registry& registry_;
+    metrics::ThreadCounters& counters_;
+    logging::Logger& logger_;
+    // MoldUDP64 sequence expected next, 0 before the first packet
+    std::uint64_t next_sequence_{0};
+    Session session_{};
+};
+
+// the market's signal stage, a null check inside the market while signals are off
+template <book::DepthPolicy Policy>
+class SignalHandler
+{
+  public:
+    explicit SignalHandler(book::BasicMarket<Policy>& market)
+        : market_{market}
+    {
+    }
+
+    void on(const itch::AddOrderMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+    }
+
+    void on(const itch::AddOrderMPIDMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+    }
+
+    // prints at the resting order's price
+    void on(const itch::OrderExecutedMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+        if (effects.change)
+        {
+            market_.record_trade(msg.header.stock_locate, effects.change->level.price, effects.change->shares);
+        }
+    }
+
+    void on(const itch::OrderExecutedWithPriceMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+        if (effects.change && msg.printable == itch::Printable::Yes)
+        {
+            market_.record_trade(msg.header.stock_locate, msg.execution_price, effects.change->shares);
+        }
+    }
+
+    void on(const itch::OrderCancelMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+    }
+
+    void on(const itch::OrderDeleteMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.change.has_value());
+    }
+
+    void on(const itch::OrderReplaceMessage& msg, const Effects& effects)
+    {
+        refresh(msg.header.stock_locate, effects.replace.has_value());
+    }
+
+    void on(const itch::TradeMessage& msg)
+    {
+        market_.record_trade(msg.header.stock_locate, msg.price, msg.shares);
+    }
+
+  private:
+    void refresh(std::uint16_t stock_locate, bool changed)
+    {
+        if (changed)
+        {
+            market_.refresh_signals(stock_locate);
+        }
+    }
+
+    book::BasicMarket<Policy>& market_;
+};
+
+// book events into a sink, the journal or the broadcast ring, committed once per packet; full
+// depth books only
+template <typename Sink>
+class JournalHandler
+{
+  public:
+    JournalHandler(Sink& journal, book::Market& market)
+        : journal_{journal},
+          market_{market}
+    {
+    }
+
+    void on_packet_end()
+    {
+        journal_.commit();
+    }
+
+    void on(const itch::AddOrderMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_added(msg.header, msg.order_reference_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::AddOrderMPIDMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_added(msg.header, msg.order_reference_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::OrderExecutedMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_executed(msg.header, msg.order_reference_number, msg.match_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::OrderExecutedWithPriceMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_executed(msg.header, msg.order_reference_number, msg.match_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::OrderCancelMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_removed(msg.header, msg.order_reference_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::OrderDeleteMessage& msg, const Effects& effects)
+    {
+        if (effects.change)
+        {
+            journal_.order_removed(msg.header, msg.order_reference_number, *effects.change, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::OrderReplaceMessage& msg, const Effects& effects)
+    {
+        if (effects.replace)
+        {
+            journal_.order_replaced(msg, *effects.replace, market_.get_book(msg.header.stock_locate));
+        }
+    }
+
+    void on(const itch::BrokenTradeMessage& msg, const Effects& effects)
+    {
+        if (effects.busted)
+        {
+            journal_.trade_broken(msg.header, *effects.busted);
+        }
+    }
+
+  private:
+    Sink& journal_;
+    book::Market& market_;
+};
+
+// receive queue fill and kernel drops, sampled by the receiver, move the channel between normal
+// and degraded; degraded, it sheds every message the books can do without before it is parsed
+class LoadShedder
+{
+  public:
+    LoadShedder(metrics::ThreadCounters& counters, logging::Logger& logger)
+        : counters_{counters},
+          logger_{logger}
+    {
+    }
+
+    // drops is the socket's running count; true when the mode changed
+    bool sample(std::uint32_t queued_bytes, std::uint32_t limit_bytes, std::uint32_t drops) noexcept
+    {
+        // the kernel's count is 32 bits and wraps
+        const std::uint32_t dropped{drops - drops_};
+        drops_ = drops;
+        counters_.socket_drops.add(dropped);
+
+        if (!degraded_)
+        {
+            const bool overloaded{dropped != 0 || std::uint64_t{queued_bytes} * 2 >= limit_bytes};
+            streak_ = overloaded ? streak_ + 1 : 0;
+            if (streak_ < enter_after)
+            {
+                return false;
+            }
+            logger_.log(logging::Event::Degraded, queued_bytes, limit_bytes, counters_.socket_drops.get());
+            counters_.overload_periods.add();
+            shed_at_start_ = counters_.shed_messages.get();
+        }
+        else
+        {
+            const bool drained{dropped == 0 && std::uint64_t{queued_bytes} * 8 <= limit_bytes};
+            streak_ = drained ? streak_ + 1 : 0;
+            if (streak_ < leave_after)
+            {
+                return false;
+            }
+            logger_.log(logging::Event::Recovered, queued_bytes, limit_bytes, counters_.shed_messages.get() - shed_at_start_);
+        }
+        degraded_ = !degraded_;
+        streak_ = 0;
+        return true;
+    }
+
+    [[nodiscard]]
+    bool degraded() const noexcept
+    {
+        return degraded_;
+    }
+
+    bool sheds(itch::MessageType type) noexcept
+    {
+        if (!degraded_ || !auxiliary(type))
+        {
+            return false;
+        }
+        counters_.shed_messages.add();
+        return true;
+    }
+
+    // nothing in the books depends on these, and each auction indication is superseded by the
+    // next; orders, trades and crosses (executions for busts, vwap, the cross price), busts, the
+    // directory and system events always go through
+    static constexpr bool auxiliary(itch::MessageType type) noexcept
+    {
+        switch (type)
+        {
+        case itch::MessageType::StockTradingAction:
+        case itch::MessageType::RegSHORestriction:
+        case itch::MessageType::MarketParticipantPosition:
+        case itch::MessageType::MWCBDeclineLevel:
+        case itch::MessageType::MWCBStatus:
+        case itch::MessageType::IPOQuotingPeriodUpdate:
+        case itch::MessageType::LULDAuctionCollar:
+        case itch::MessageType::OperationalHalt:
+        case itch::MessageType::NOII:
+        case itch::MessageType::RPII:
+        case itch::MessageType::DirectListingPriceDiscovery:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // consecutive samples past the high mark to shed, under the low mark to stop
+    static constexpr int enter_after{4};
+    static constexpr int leave_after{16};
+
+  private:
+    metrics::ThreadCounters& counters_;
+    logging::Logger& logger_;
+    std::uint32_t drops_{0};
+    int streak_{0};
+    bool degraded_{false};
+    std::uint64_t shed_at_start_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef FEED_PIPELINE_H_
+#define FEED_PIPELINE_H_
+
+#include <optional>
+#include <tuple>
+
+#include "../book/book.h"
+#include "../book/executions.h"
+#include "decoder.h"
+
+namespace feed
+{
+
+// what the book stage did with one message, read by the stages after it
+struct Effects
+{
+    // add, execute, cancel and delete
+    std::optional<book::Change> change;
+    std::optional<book::ReplaceChange> replace;
+    // the original of a broken trade
+    std::optional<book::Execution> busted;
+};
+
+// a stage takes a message as on(msg, effects) when it needs what earlier stages did, else on(msg)
+template <typename Stage, typename Message>
+concept StageHandles = requires(Stage& stage, const Message& msg, Effects& effects) { stage.on(msg, effects); } ||
+                       requires(Stage& stage, const Message& msg) { stage.on(msg); };
+
+// stages run in order for every message, composed at compile time so decode_packet over a
+// pipeline is one loop with every hook inlined; a message no stage takes is never parsed
+template <typename... Stages>
+class Pipeline
+{
+  public:
+    explicit Pipeline(Stages&... stages)
+        : stages_{stages...}
+    {
+    }
+
+    template <typename Message>
+        requires(StageHandles<Stages, Message> || ...)
+    void on(const Message& msg)
+    {
+        Effects effects{};
+        std::apply([&](auto&... stage) { (deliver(stage, msg, effects), ...); }, stages_);
+    }
+
+    void on_packet(const MoldUDP64Header& header)
+    {
+        std::apply([&](auto&... stage) { (packet(stage, header), ...); }, stages_);
+    }
+
+    void on_type(itch::MessageType type)
+    {
+        std::apply([&](auto&... stage) { (message_type(stage, type), ...); }, stages_);
+    }
+
+    // any one stage shedding the message keeps it from every stage
+    bool sheds(itch::MessageType type)
+    {
+        return std::apply([&](auto&... stage) { return (shed(stage, type) || ...); }, stages_);
+    }
+
+    void on_malformed(const MoldUDP64Header& header, std::size_t index)
+    {
+        std::apply([&](auto&... stage) { (malformed(stage, header, index), ...); }, stages_);
+    }
+
+    void on_unknown(itch::MessageType type)
+    {
+        std::apply([&](auto&... stage) { (unknown(stage, type), ...); }, stages_);
+    }
+
+    void on_packet_end()
+    {
+        std::apply([&](auto&... stage) { (packet_end(stage), ...); }, stages_);
+    }
+
+  private:
+    template <typename Stage, typename Message>
+    static void deliver(Stage& stage, const Message& msg, Effects& effects)
+    {
+        if constexpr (requires { stage.on(msg, effects); })
+        {
+            stage.on(msg, effects);
+        }
+        else if constexpr (requires { stage.on(msg); })
+        {
+            stage.on(msg);
+        }
+    }
+
+    template <typename Stage>
+    static void packet(Stage& stage, const MoldUDP64Header& header)
+    {
+        if constexpr (requires { stage.on_packet(header); })
+        {
+            stage.on_packet(header);
+        }
+    }
+
+    template <typename Stage>
+    static void message_type(Stage& stage, itch::MessageType type)
+    {
+        if constexpr (requires { stage.on_type(type); })
+        {
+            stage.on_type(type);
+        }
+    }
+
+    template <typename Stage>
+    static bool shed(Stage& stage, itch::MessageType type)
+    {
+        if constexpr (requires { stage.sheds(type); })
+        {
+            return stage.sheds(type);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    template <typename Stage>
+    static void malformed(Stage& stage, const MoldUDP64Header& header, std::size_t index)
+    {
+        if constexpr (requires { stage.on_malformed(header, index); })
+        {
+            stage.on_malformed(header, index);
+        }
+    }
+
+    template <typename Stage>
+    static void unknown(Stage& stage, itch::MessageType type)
+    {
+        if constexpr (requires { stage.on_unknown(type); })
+        {
+            stage.on_unknown(type);
+        }
+    }
+
+    template <typename Stage>
+    static void packet_end(Stage& stage)
+    {
+        if constexpr (requires { stage.on_packet_end(); })
+        {
+            stage.on_packet_end();
+        }
+    }
+
+    std::tuple<Stages&...> stages_;
+};
+
+}
+
+#endif
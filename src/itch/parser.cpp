@@ -34,6 +34,12 @@ itch::MessageHeader extract_header(std::span<const std::byte> bytes, std::size_t
 
 namespace itch
 {
+MessageHeader parse_message_header(std::span<const std::byte> bytes)
+{
+    std::size_t pos{0};
+    return extract_header(bytes, pos);
+}
+
 SystemEventMessage parse_system_event_message(std::span<const std::byte> bytes)
 {
     std::size_t pos{0};
@@ -11,6 +11,9 @@
 namespace itch
 {
 
+// just the common header, for callers that only need locate/timestamp
+MessageHeader parse_message_header(std::span<const std::byte> bytes);
+
 SystemEventMessage parse_system_event_message(std::span<const std::byte> bytes);
 
 StockDirectoryMessage parse_stock_directory_message(std::span<const std::byte> bytes);
@@ -1,9 +1,11 @@
 #ifndef ITCH_TYPES_H_
 #define ITCH_TYPES_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <array>
 #include <format>
+#include <string_view>
 
 namespace itch
 {
@@ -42,6 +44,64 @@ struct MessageHeader
     std::uint64_t timestamp;
 };
 
+// on the wire after the type byte: locate, tracking number and a 6 byte timestamp
+inline constexpr std::size_t message_header_size{10};
+
+// whole message on the wire after the type byte, 0 for a type itch 5.0 does not define
+constexpr std::size_t body_size(MessageType type) noexcept
+{
+    switch (type)
+    {
+    case MessageType::SystemEvent:
+        return 11;
+    case MessageType::StockDirectory:
+        return 38;
+    case MessageType::StockTradingAction:
+        return 24;
+    case MessageType::RegSHORestriction:
+        return 19;
+    case MessageType::MarketParticipantPosition:
+        return 25;
+    case MessageType::MWCBDeclineLevel:
+        return 34;
+    case MessageType::MWCBStatus:
+        return 11;
+    case MessageType::IPOQuotingPeriodUpdate:
+        return 27;
+    case MessageType::LULDAuctionCollar:
+        return 34;
+    case MessageType::OperationalHalt:
+        return 20;
+    case MessageType::AddOrder:
+        return 35;
+    case MessageType::AddOrderMPID:
+        return 39;
+    case MessageType::OrderExecuted:
+        return 30;
+    case MessageType::OrderExecutedWithPrice:
+        return 35;
+    case MessageType::OrderCancel:
+        return 22;
+    case MessageType::OrderDelete:
+        return 18;
+    case MessageType::OrderReplace:
+        return 34;
+    case MessageType::Trade:
+        return 43;
+    case MessageType::CrossTrade:
+        return 39;
+    case MessageType::BrokenTrade:
+        return 18;
+    case MessageType::NOII:
+        return 49;
+    case MessageType::RPII:
+        return 19;
+    case MessageType::DirectListingPriceDiscovery:
+        return 47;
+    }
+    return 0;
+}
+
 enum class Side : char
 {
     Buy = 'B',
@@ -59,6 +119,19 @@ enum class CrossType : char
 using Symbol = std::array<char, 8>;
 using MPID = std::array<char, 4>;
 
+// alpha fields are left justified and space padded, longer text is cut at the field width
+[[nodiscard]]
+constexpr Symbol to_symbol(std::string_view text) noexcept
+{
+    Symbol symbol{};
+    symbol.fill(' ');
+    for (std::size_t i = 0; i < symbol.size() && i < text.size(); ++i)
+    {
+        symbol[i] = text[i];
+    }
+    return symbol;
+}
+
 }
 
 // debug print
@@ -0,0 +1,131 @@
+#ifndef JOURNAL_EVENTS_H_
+#define JOURNAL_EVENTS_H_
+
+#include <cstdint>
+
+#include "format.h"
+#include "../book/book.h"
+#include "../book/executions.h"
+#include "../itch/messages_orders.h"
+
+namespace journal
+{
+
+// what a book change becomes as events, for any sink of them: the journal, the broadcast ring
+// Sink provides Event* next(header, type), the record to fill or nullptr to skip it
+template <typename Sink>
+class EventWriter
+{
+  public:
+    void order_added(const itch::MessageHeader& header, std::uint64_t ref_num, const book::Change& change, const book::Book& book) noexcept
+    {
+        order_event(header, EventType::OrderAdded, ref_num, 0, change);
+        level_changed(header, change);
+        if (change.top)
+        {
+            bbo_changed(header, book);
+        }
+    }
+
+    // cancels (partial or full) and deletes
+    void order_removed(const itch::MessageHeader& header, std::uint64_t ref_num, const book::Change& change, const book::Book& book) noexcept
+    {
+        order_event(header, EventType::OrderRemoved, ref_num, 0, change);
+        level_changed(header, change);
+        if (change.top)
+        {
+            bbo_changed(header, book);
+        }
+    }
+
+    void order_executed(const itch::MessageHeader& header, std::uint64_t ref_num, std::uint64_t match_number, const book::Change& change, const book::Book& book) noexcept
+    {
+        order_event(header, EventType::OrderExecuted, ref_num, match_number, change);
+        level_changed(header, change);
+        if (change.top)
+        {
+            bbo_changed(header, book);
+        }
+    }
+
+    void order_replaced(const itch::OrderReplaceMessage& msg, const book::ReplaceChange& change, const book::Book& book) noexcept
+    {
+        const auto& removed{change.removed};
+        order_event(msg.header, EventType::OrderRemoved, msg.original_order_reference_number, 0, removed);
+        level_changed(msg.header, removed);
+
+        bool top{removed.top};
+        if (change.added)
+        {
+            order_event(msg.header, EventType::OrderAdded, msg.new_order_reference_number, 0, *change.added);
+            level_changed(msg.header, *change.added);
+            top = top || change.added->top;
+        }
+
+        // one quote for the whole replace
+        if (top)
+        {
+            bbo_changed(msg.header, book);
+        }
+    }
+
+    void trade_broken(const itch::MessageHeader& header, const book::Execution& execution) noexcept
+    {
+        if (auto* event{sink().next(header, EventType::TradeBroken)})
+        {
+            event->order = {.ref_num = 0,
+                            .match_number = execution.match_number,
+                            .price = execution.price,
+                            .shares = execution.shares,
+                            .remaining = 0,
+                            .side = execution.side};
+        }
+    }
+
+  private:
+    Sink& sink() noexcept
+    {
+        return static_cast<Sink&>(*this);
+    }
+
+    void order_event(const itch::MessageHeader& header, EventType type, std::uint64_t ref_num, std::uint64_t match_number, const book::Change& change) noexcept
+    {
+        if (auto* event{sink().next(header, type)})
+        {
+            event->order = {.ref_num = ref_num,
+                            .match_number = match_number,
+                            .price = change.level.price,
+                            .shares = change.shares,
+                            .remaining = change.order_shares,
+                            .side = change.side};
+        }
+    }
+
+    void level_changed(const itch::MessageHeader& header, const book::Change& change) noexcept
+    {
+        if (auto* event{sink().next(header, EventType::LevelChanged)})
+        {
+            event->level = {.shares = change.level.shares,
+                            .price = change.level.price,
+                            .orders = change.level.orders,
+                            .side = change.side};
+        }
+    }
+
+    void bbo_changed(const itch::MessageHeader& header, const book::Book& book) noexcept
+    {
+        if (auto* event{sink().next(header, EventType::BBOChanged)})
+        {
+            const auto bid{book.best_bid().value_or(book::Level{.price = 0, .orders = 0, .shares = 0})};
+            const auto ask{book.best_ask().value_or(book::Level{.price = 0, .orders = 0, .shares = 0})};
+            event->bbo = {.bid_shares = bid.shares,
+                          .ask_shares = ask.shares,
+                          .bid_price = bid.price,
+                          .ask_price = ask.price};
+        }
+    }
+};
+
+}
+
+#endif
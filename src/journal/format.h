@@ -0,0 +1,92 @@
+#ifndef JOURNAL_FORMAT_H_
+#define JOURNAL_FORMAT_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "../itch/types.h"
+#include "../util/cache.h"
+
+// on-disk layout of the book event journal, shared by the writer and readers
+namespace journal
+{
+
+enum class EventType : std::uint8_t
+{
+    LevelChanged = 1,
+    OrderAdded = 2,
+    OrderRemoved = 3,
+    OrderExecuted = 4,
+    BBOChanged = 5,
+    // correction, the order fields describe the original print
+    TradeBroken = 6
+};
+
+struct OrderEvent
+{
+    std::uint64_t ref_num;
+    // executions only
+    std::uint64_t match_number;
+    std::uint32_t price;
+    // added, removed or executed by this event
+    std::uint32_t shares;
+    // left on the order, 0 once it is gone
+    std::uint32_t remaining;
+    itch::Side side;
+};
+
+struct LevelEvent
+{
+    std::uint64_t shares;
+    std::uint32_t price;
+    // 0 once the level is gone
+    std::uint32_t orders;
+    itch::Side side;
+};
+
+// price 0 / shares 0 for an empty side
+struct BBOEvent
+{
+    std::uint64_t bid_shares;
+    std::uint64_t ask_shares;
+    std::uint32_t bid_price;
+    std::uint32_t ask_price;
+};
+
+struct alignas(util::cache_line_size) Event
+{
+    // dense from 0, a gap means the journal filled up
+    std::uint64_t sequence;
+    // itch ns since midnight of the message that caused it
+    std::uint64_t timestamp;
+    std::uint16_t stock_locate;
+    EventType type;
+    union
+    {
+        OrderEvent order;
+        LevelEvent level;
+        BBOEvent bbo;
+    };
+};
+
+static_assert(sizeof(Event) == util::cache_line_size);
+
+inline constexpr std::array<char, 8> magic{'L', '3', 'J', 'R', 'N', 'L', '0', '1'};
+
+// readers acquire-load committed_offset, every record below it is complete
+struct alignas(util::cache_line_size) Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t record_size;
+    std::uint32_t header_size;
+    // bytes, including the header
+    std::uint64_t file_size;
+    alignas(util::cache_line_size) std::atomic<std::uint64_t> committed_offset;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include "journal.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <print>
+#include <new>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr std::size_t header_size{sizeof(journal::Header)};
+
+std::byte* map_file(int fd, std::size_t bytes, int prot)
+{
+    void* ptr{mmap(nullptr, bytes, prot, MAP_SHARED | MAP_POPULATE, fd, 0)};
+    return ptr == MAP_FAILED ? nullptr : static_cast<std::byte*>(ptr);
+}
+
+}
+
+namespace journal
+{
+
+std::optional<Journal> Journal::create(const std::string& path, std::size_t file_size)
+{
+    if (file_size < header_size + sizeof(Event))
+    {
+        std::println(std::cerr, "journal size {} too small", file_size);
+        return std::nullopt;
+    }
+
+    const int fd{::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)};
+    if (fd < 0)
+    {
+        std::perror("open journal");
+        return std::nullopt;
+    }
+    FD file{fd};
+
+    // allocate blocks now, a full disk must not turn into SIGBUS mid-session
+    if (const auto err{posix_fallocate(file.fd(), 0, static_cast<off_t>(file_size))}; err != 0)
+    {
+        std::println(std::cerr, "posix_fallocate journal: {}", std::strerror(err));
+        return std::nullopt;
+    }
+
+    auto* map{map_file(file.fd(), file_size, PROT_READ | PROT_WRITE)};
+    if (map == nullptr)
+    {
+        std::perror("mmap journal");
+        return std::nullopt;
+    }
+
+    // take the write faults up front
+    const auto page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto* volatile_map{static_cast<volatile std::byte*>(map)};
+    for (std::size_t offset = 0; offset < file_size; offset += page)
+    {
+        volatile_map[offset] = std::byte{0};
+    }
+
+    return Journal{std::move(file), map, file_size};
+}
+
+Journal::Journal(FD file, std::byte* map, std::size_t map_bytes)
+    : file_{std::move(file)},
+      map_{map},
+      map_bytes_{map_bytes},
+      header_{new (map) Header{.magic = journal::magic,
+                               .record_size = sizeof(Event),
+                               .header_size = header_size,
+                               .file_size = map_bytes,
+                               .committed_offset = header_size}},
+      records_{reinterpret_cast<Event*>(map + header_size), (map_bytes - header_size) / sizeof(Event)}
+{
+}
+
+Journal::Journal(Journal&& other) noexcept
+    : file_{std::move(other.file_)},
+      map_{std::exchange(other.map_, nullptr)},
+      map_bytes_{std::exchange(other.map_bytes_, 0)},
+      header_{std::exchange(other.header_, nullptr)},
+      records_{std::exchange(other.records_, {})},
+      next_{other.next_},
+      dropped_{other.dropped_}
+{
+}
+
+Journal& Journal::operator=(Journal&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (map_ != nullptr)
+        {
+            munmap(map_, map_bytes_);
+        }
+        file_ = std::move(other.file_);
+        map_ = std::exchange(other.map_, nullptr);
+        map_bytes_ = std::exchange(other.map_bytes_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        records_ = std::exchange(other.records_, {});
+        next_ = other.next_;
+        dropped_ = other.dropped_;
+    }
+    return *this;
+}
+
+Journal::~Journal()
+{
+    if (map_ != nullptr)
+    {
+        commit();
+        munmap(map_, map_bytes_);
+    }
+}
+
+void Journal::commit() noexcept
+{
+    header_->committed_offset.store(header_size + next_ * sizeof(Event), std::memory_order_release);
+}
+
+std::uint64_t Journal::written() const noexcept
+{
+    return next_;
+}
+
+std::uint64_t Journal::dropped() const noexcept
+{
+    return dropped_;
+}
+
+Event* Journal::next(const itch::MessageHeader& header, EventType type) noexcept
+{
+    if (next_ == records_.size())
+    {
+        ++dropped_;
+        return nullptr;
+    }
+
+    auto& event{records_[next_]};
+    event.sequence = next_ + dropped_;
+    event.timestamp = header.timestamp;
+    event.stock_locate = header.stock_locate;
+    event.type = type;
+    ++next_;
+    return &event;
+}
+
+std::optional<Reader> Reader::open(const std::string& path)
+{
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+    {
+        std::perror("open journal");
+        return std::nullopt;
+    }
+    FD file{fd};
+
+    struct stat st{};
+    if (fstat(file.fd(), &st) < 0 || static_cast<std::size_t>(st.st_size) < header_size)
+    {
+        std::println(std::cerr, "journal {} is truncated", path);
+        return std::nullopt;
+    }
+
+    const auto bytes{static_cast<std::size_t>(st.st_size)};
+    auto* map{map_file(file.fd(), bytes, PROT_READ)};
+    if (map == nullptr)
+    {
+        std::perror("mmap journal");
+        return std::nullopt;
+    }
+
+    const auto* header{reinterpret_cast<const Header*>(map)};
+    if (header->magic != journal::magic || header->record_size != sizeof(Event) || header->header_size != header_size)
+    {
+        std::println(std::cerr, "{} is not a journal this build can read", path);
+        munmap(map, bytes);
+        return std::nullopt;
+    }
+
+    return Reader{std::move(file), map, bytes};
+}
+
+Reader::Reader(FD file, std::byte* map, std::size_t map_bytes)
+    : file_{std::move(file)},
+      map_{map},
+      map_bytes_{map_bytes},
+      header_{reinterpret_cast<const Header*>(map)},
+      offset_{header_size}
+{
+}
+
+Reader::Reader(Reader&& other) noexcept
+    : file_{std::move(other.file_)},
+      map_{std::exchange(other.map_, nullptr)},
+      map_bytes_{std::exchange(other.map_bytes_, 0)},
+      header_{std::exchange(other.header_, nullptr)},
+      offset_{other.offset_}
+{
+}
+
+Reader& Reader::operator=(Reader&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (map_ != nullptr)
+        {
+            munmap(map_, map_bytes_);
+        }
+        file_ = std::move(other.file_);
+        map_ = std::exchange(other.map_, nullptr);
+        map_bytes_ = std::exchange(other.map_bytes_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        offset_ = other.offset_;
+    }
+    return *this;
+}
+
+Reader::~Reader()
+{
+    if (map_ != nullptr)
+    {
+        munmap(map_, map_bytes_);
+    }
+}
+
+std::span<const Event> Reader::poll() noexcept
+{
+    const auto committed{header_->committed_offset.load(std::memory_order_acquire)};
+    const auto* first{reinterpret_cast<const Event*>(map_ + offset_)};
+    const auto count{(committed - offset_) / sizeof(Event)};
+    offset_ = committed;
+    return {first, count};
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef JOURNAL_JOURNAL_H_
+#define JOURNAL_JOURNAL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "events.h"
+#include "format.h"
+#include "../fd/fd.h"
+
+namespace journal
+{
+
+// append-only writer over a preallocated, prefaulted shared mapping
+// the hot path only stores to memory, the kernel writes pages back on its own
+class Journal : public EventWriter<Journal>
+{
+  public:
+    static std::optional<Journal> create(const std::string& path, std::size_t file_size);
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    Journal(Journal&& other) noexcept;
+    Journal& operator=(Journal&& other) noexcept;
+    ~Journal();
+
+    // publish everything appended so far to readers
+    void commit() noexcept;
+
+    [[nodiscard]]
+    std::uint64_t written() const noexcept;
+    // events that found the journal full, the receiver stops on the first
+    [[nodiscard]]
+    std::uint64_t dropped() const noexcept;
+
+  private:
+    friend class EventWriter<Journal>;
+
+    Journal(FD file, std::byte* map, std::size_t map_bytes);
+
+    // nullptr once full
+    Event* next(const itch::MessageHeader& header, EventType type) noexcept;
+
+    FD file_;
+    std::byte* map_;
+    std::size_t map_bytes_;
+    Header* header_;
+    std::span<Event> records_;
+    std::uint64_t next_{0};
+    std::uint64_t dropped_{0};
+};
+
+// tails a journal that may still be being written
+class Reader
+{
+  public:
+    static std::optional<Reader> open(const std::string& path);
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    Reader(Reader&& other) noexcept;
+    Reader& operator=(Reader&& other) noexcept;
+    ~Reader();
+
+    // events committed since the last call
+    std::span<const Event> poll() noexcept;
+
+  private:
+    Reader(FD file, std::byte* map, std::size_t map_bytes);
+
+    FD file_;
+    std::byte* map_;
+    std::size_t map_bytes_;
+    const Header* header_;
+    std::uint64_t offset_;
+};
+
+}
+
+#endif
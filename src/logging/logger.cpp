@@ -0,0 +1,109 @@
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <print>
+
+#include "../rt/tuning.h"
+
+namespace
+{
+
+void write_record(std::ostream& out, const logging::Record& record)
+{
+    switch (record.event)
+    {
+    case logging::Event::MalformedPacket:
+        std::println(out,
+                     "Malformed packet (missing len but should have more messages) seq {} message {} of {}",
+                     record.args[0],
+                     record.args[1],
+                     record.args[2]);
+        break;
+    case logging::Event::UnknownMessageType:
+        std::println(out, "Unknown message type: {}", static_cast<char>(record.args[0]));
+        break;
+    case logging::Event::Degraded:
+        std::println(out,
+                     "Overloaded (receive queue {} of {} bytes, {} datagrams dropped so far), skipping non-book messages",
+                     record.args[0],
+                     record.args[1],
+                     record.args[2]);
+        break;
+    case logging::Event::Recovered:
+        std::println(out,
+                     "Caught up (receive queue {} of {} bytes), {} non-book messages were skipped",
+                     record.args[0],
+                     record.args[1],
+                     record.args[2]);
+        break;
+    }
+}
+
+}
+
+namespace logging
+{
+
+Logger::Logger(std::ostream& out)
+    : out_{out},
+      thread_{[this](const std::stop_token& stop) { run(stop); }}
+{
+}
+
+Logger::~Logger()
+{
+    thread_.request_stop();
+    thread_.join();
+}
+
+std::uint64_t Logger::dropped() const noexcept
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void Logger::run(const std::stop_token& stop)
+{
+    using namespace std::chrono_literals;
+
+    // started from a pinned receiver, whose core the 1ms wakeups below would preempt
+    if (!rt::leave_rx_cpus())
+    {
+        std::perror("sched_setaffinity logger");
+    }
+
+    while (!stop.stop_requested())
+    {
+        if (!drain())
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    drain();
+}
+
+bool Logger::drain()
+{
+    Record record{};
+    bool wrote{false};
+    while (ring_.try_pop(record))
+    {
+        write_record(out_, record);
+        wrote = true;
+    }
+
+    if (const auto dropped{dropped_.load(std::memory_order_relaxed)}; dropped != reported_dropped_)
+    {
+        std::println(out_, "logger dropped {} records ({} total)", dropped - reported_dropped_, dropped);
+        reported_dropped_ = dropped;
+        wrote = true;
+    }
+
+    if (wrote)
+    {
+        out_.flush();
+    }
+    return wrote;
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef LOGGING_LOGGER_H_
+#define LOGGING_LOGGER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+#include "../util/spsc_ring.h"
+
+namespace logging
+{
+
+// the format lives in logger.cpp, the hot path only ships the id and raw args
+enum class Event : std::uint8_t
+{
+    MalformedPacket,
+    UnknownMessageType,
+    Degraded,
+    Recovered,
+};
+
+struct Record
+{
+    Event event;
+    std::array<std::uint64_t, 3> args;
+};
+
+// single producer: log() from one thread, formatting and writes happen on the logger thread
+class Logger
+{
+  public:
+    explicit Logger(std::ostream& out);
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    Logger(Logger&&) = delete;
+    Logger& operator=(Logger&&) = delete;
+
+    // drains what is queued, reports drops
+    ~Logger();
+
+    // never blocks, a full ring drops the record and counts it
+    void log(Event event, std::uint64_t arg0 = 0, std::uint64_t arg1 = 0, std::uint64_t arg2 = 0) noexcept
+    {
+        if (!ring_.try_push({.event = event, .args = {arg0, arg1, arg2}}))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]]
+    std::uint64_t dropped() const noexcept;
+
+  private:
+    void run(const std::stop_token& stop);
+    bool drain();
+
+    util::SpscRing<Record, 4096> ring_{};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::uint64_t reported_dropped_{0};
+    std::ostream& out_;
+    std::jthread thread_;
+};
+
+}
+
+#endif
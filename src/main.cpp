@@ -2,227 +2,761 @@
 #include <print>
 #include <cstring>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <stop_token>
+#include <thread>
+#include <vector>
 
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
+#include <sys/uio.h>
 
+#include "archive/archive.h"
+#include "broadcast/broadcast.h"
 #include "book/market.h"
+#include "cli/options.h"
 #include "fd/fd.h"
+#include "feed/decoder.h"
+#include "feed/handlers.h"
+#include "feed/pipeline.h"
 #include "itch/types.h"
-#include "util/binary_io.h"
-#include "itch/parser.h"
+#include "journal/journal.h"
+#include "logging/logger.h"
+#include "mem/arena.h"
+#include "metrics/metrics.h"
+#include "net/mcast.h"
+#include "recovery/late_join.h"
+#include "recovery/snapshot.h"
+#include "replay/checkpoint.h"
+#include "replay/index.h"
+#include "replay/mapped_file.h"
+#include "replay/replay.h"
+#include "rt/tuning.h"
+#include "stats/latency.h"
 
-std::optional<FD> create_mcast_socket(std::string_view mcast_group, int port);
-void process_packet(std::span<const std::byte> buffer, book::Market& market);
+// one feed channel's socket and what its receiver reports on the way out
+struct Receiver
+{
+    cli::Channel channel;
+    // its place in the channel list, which picks its execution index
+    std::size_t index;
+    FD sock;
+    metrics::ThreadCounters* counters;
+    std::optional<stats::FeedLatency> latency;
+    std::chrono::steady_clock::duration elapsed;
+    // set while the channel joins late
+    recovery::LateJoin* late_join;
+    // where the session was up to on the way out
+    feed::Session session;
+    std::uint64_t next_sequence;
+    // false after a socket error
+    bool ok;
+};
+
+void pin_receiver(const Receiver& receiver);
+// runs the channel's pipeline on the calling thread until shutdown or stop
+void receive(Receiver& receiver, book::Market& market, metrics::Registry& registry, journal::Journal* journal, broadcast::Publisher* ring, int recv_flags, const std::stop_token& stop);
+// offline rebuild of a whole BinaryFILE, no socket
+int replay_file(const cli::Options& options);
+std::size_t replay_threads(const cli::Options& options);
+// sequential decode of a compressed archive straight into the books
+bool replay_archive(replay::MappedFile file, book::Market& market);
+// offline BinaryFILE -> compressed archive
+int compress_file(const std::string& raw_path);
+// offline sidecar index and checkpoints for a BinaryFILE
+int index_file(const cli::Options& options);
+// one locate's book at a point in time, from the sidecars
+int query_book(const cli::Options& options);
 
 int main(int argc, char** argv)
 {
-    if (argc != 3)
+    const auto options{cli::parse_options(argc, argv)};
+    if (!options)
     {
-        std::println(std::cerr, "usage: {} <multicast_group> <port>", argv[0]);
         return 1;
     }
 
-    const auto* mcast_group{argv[1]};
-    const int port{std::atoi(argv[2])};
+    if (options->compress_path)
+    {
+        return compress_file(*options->compress_path);
+    }
+    if (options->index_archive)
+    {
+        return index_file(*options);
+    }
+    if (options->replay_path && options->query_locate)
+    {
+        return query_book(*options);
+    }
+    if (options->replay_path)
+    {
+        return replay_file(*options);
+    }
 
-    if (port <= 0 || port > 65535)
+    net::SocketTuning tuning{};
+    if (options->low_latency)
     {
-        std::println(std::cerr, "invalid port number {}", port);
-        return 1;
+        tuning.busy_poll_us = options->busy_poll_us;
+        tuning.rcvbuf_bytes = options->rcvbuf_bytes;
+    }
+    tuning.rx_timestamps = options->latency;
+    // a receiver blocked in recvmsg wakes this often to see a shutdown signal another thread took,
+    // or a snapshot that came in while the feed was quiet
+    if (options->channels.size() > 1 || options->snapshot_source)
+    {
+        tuning.recv_timeout_ms = 100;
     }
 
-    const auto sock{create_mcast_socket(mcast_group, port)};
-    if (!sock)
+    std::vector<Receiver> receivers{};
+    for (const auto& channel : options->channels)
     {
-        return 1;
+        auto sock{net::create_mcast_socket(channel.mcast_group, channel.port, tuning)};
+        if (!sock)
+        {
+            return 1;
+        }
+        receivers.push_back(Receiver{.channel = channel,
+                                     .index = receivers.size(),
+                                     .sock = std::move(*sock),
+                                     .counters = nullptr,
+                                     .latency = std::nullopt,
+                                     .elapsed = {},
+                                     .late_join = nullptr,
+                                     .session = {},
+                                     .next_sequence = 0,
+                                     .ok = true});
+    }
+
+    // threads started from here on inherit the rx core, the logger, metrics, snapshot fetch and
+    // broadcast monitor ones move themselves off every receiver's
+    std::vector<int> rx_cpus{};
+    for (const auto& receiver : receivers)
+    {
+        if (receiver.channel.cpu)
+        {
+            rx_cpus.push_back(*receiver.channel.cpu);
+        }
+    }
+    rt::reserve_rx_cpus(rx_cpus);
+
+    // pin before the arena is prefaulted so its pages land on the local node
+    pin_receiver(receivers.front());
+
+    std::optional<mem::Arena> arena{};
+    std::unique_ptr<std::pmr::memory_resource> pool{};
+    if (options->arena_pages)
+    {
+        arena.emplace(options->arena_bytes, *options->arena_pages);
+
+        const auto start{std::chrono::steady_clock::now()};
+        arena->prefault();
+        const auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+
+        std::println(std::cerr,
+                     "arena: {} MiB prefaulted in {} ms, requested {}, got {}",
+                     arena->capacity() / (1024 * 1024),
+                     elapsed.count(),
+                     mem::to_string(*options->arena_pages),
+                     mem::to_string(arena->mode()));
+
+        // receivers on different channels allocate concurrently
+        if (receivers.size() > 1)
+        {
+            pool = std::make_unique<std::pmr::synchronized_pool_resource>(&*arena);
+        }
+        else
+        {
+            pool = std::make_unique<std::pmr::unsynchronized_pool_resource>(&*arena);
+        }
+    }
+
+    book::Market market{pool ? pool.get() : std::pmr::get_default_resource()};
+    if (options->signals)
+    {
+        market.enable_signals();
+    }
+    if (options->match_capacity != 0)
+    {
+        market.enable_executions(options->match_capacity, receivers.size());
+        std::println(std::cerr,
+                     "executions: latest {} matches indexed for busts on each of {} channels, {} MiB each",
+                     market.executions()->capacity(),
+                     receivers.size(),
+                     market.executions()->bytes() / (1024 * 1024));
+    }
+    for (const auto& symbol : options->dense_symbols)
+    {
+        market.select_ladder(itch::to_symbol(symbol), book::liquid_ladder);
+    }
+
+    // the fetch starts now, the receiver holds packets from its first one until the books are in
+    std::optional<recovery::LateJoin> late_join{};
+    if (options->snapshot_source)
+    {
+        late_join.emplace(*options->snapshot_source, market, options->late_join_bytes);
+        receivers.front().late_join = &*late_join;
+    }
+
+    if (options->low_latency)
+    {
+        const auto locked{rt::lock_memory()};
+        if (!locked)
+        {
+            std::perror("mlockall");
+        }
+
+        for (const auto& receiver : receivers)
+        {
+            const auto settings{net::read_socket_settings(receiver.sock)};
+            std::println(std::cerr,
+                         "low-latency {}:{}: mlockall {}, SO_BUSY_POLL {}us (requested {}), SO_RCVBUF {} bytes (requested {}), spinning receive",
+                         receiver.channel.mcast_group,
+                         receiver.channel.port,
+                         locked ? "ok" : "failed",
+                         settings.busy_poll_us,
+                         options->busy_poll_us,
+                         settings.rcvbuf_bytes,
+                         options->rcvbuf_bytes);
+        }
     }
 
-    book::Market market{};
+    const int recv_flags{options->low_latency ? MSG_DONTWAIT : 0};
 
-    while (1)
+    // a journal and a ring per channel, each written only by that channel's receiver
+    std::vector<journal::Journal> journals{};
+    if (options->journal_path)
     {
-        std::byte msgbuf[1500];
-        ssize_t nbytes = recvfrom(sock->fd(),
-                                  msgbuf,
-                                  1500,
-                                  0,
-                                  nullptr,
-                                  nullptr);
+        for (std::size_t i = 0; i < receivers.size(); ++i)
+        {
+            auto journal{journal::Journal::create(cli::channel_path(*options->journal_path, i, receivers.size()), options->journal_bytes)};
+            if (!journal)
+            {
+                return 1;
+            }
+            journals.push_back(std::move(*journal));
+        }
+    }
 
-        if (nbytes < 0)
+    std::vector<broadcast::Publisher> rings{};
+    if (options->broadcast_name)
+    {
+        for (std::size_t i = 0; i < receivers.size(); ++i)
+        {
+            auto ring{broadcast::Publisher::create(cli::channel_path(*options->broadcast_name, i, receivers.size()), options->broadcast_events)};
+            if (!ring)
+            {
+                return 1;
+            }
+            rings.push_back(std::move(*ring));
+        }
+    }
+    // a reader falling behind is reported while it can still catch up, not only at exit
+    std::vector<std::unique_ptr<broadcast::ConsumerMonitor>> ring_monitors{};
+    for (const auto& ring : rings)
+    {
+        ring_monitors.push_back(std::make_unique<broadcast::ConsumerMonitor>(ring, std::cerr));
+    }
+    const auto journal_of{[&](std::size_t i) { return journals.empty() ? nullptr : &journals[i]; }};
+    const auto ring_of{[&](std::size_t i) { return rings.empty() ? nullptr : &rings[i]; }};
+
+    auto registry{std::make_unique<metrics::Registry>()};
+    std::optional<metrics::Server> metrics_server{};
+    if (options->metrics_socket)
+    {
+        metrics_server = metrics::Server::create(*registry, *options->metrics_socket);
+        if (!metrics_server)
         {
-            perror("recvfrom");
             return 1;
         }
+    }
 
-        process_packet(std::span{msgbuf, static_cast<size_t>(nbytes)}, market);
+    // registered in channel order, so receiver n in the metrics is the nth channel
+    for (auto& receiver : receivers)
+    {
+        receiver.counters = registry->add_thread();
+        if (receiver.counters == nullptr)
+        {
+            std::println(std::cerr, "too many channels, the metrics registry is full");
+            return 1;
+        }
+        if (options->latency)
+        {
+            receiver.latency.emplace();
+        }
     }
 
-    return 0;
+    rt::install_shutdown_handler();
+
+    // the first channel is received on this thread, every other on its own; the books they feed
+    // are disjoint by locate, so they share the market without locking
+    std::stop_source stop{};
+    {
+        std::vector<std::jthread> threads{};
+        for (std::size_t i = 1; i < receivers.size(); ++i)
+        {
+            threads.emplace_back([&, i] {
+                pin_receiver(receivers[i]);
+                receive(receivers[i], market, *registry, journal_of(i), ring_of(i), recv_flags, stop.get_token());
+                if (!receivers[i].ok)
+                {
+                    stop.request_stop();
+                }
+            });
+        }
+
+        receive(receivers.front(), market, *registry, journal_of(0), ring_of(0), recv_flags, stop.get_token());
+        if (!receivers.front().ok)
+        {
+            stop.request_stop();
+        }
+    }
+
+    for (const auto& receiver : receivers)
+    {
+        std::uint64_t messages{0};
+        for (const auto& count : receiver.counters->messages)
+        {
+            messages += count.get();
+        }
+        const auto seconds{std::chrono::duration<double>(receiver.elapsed).count()};
+        std::println(std::cerr,
+                     "channel {}:{}: {} packets, {} messages, {} missed ({:.0f} msgs/s), {} datagrams dropped by the kernel, {} messages shed in {} overloads",
+                     receiver.channel.mcast_group,
+                     receiver.channel.port,
+                     receiver.counters->packets.get(),
+                     messages,
+                     receiver.counters->missed_messages.get(),
+                     seconds > 0 ? static_cast<double>(messages) / seconds : 0.0,
+                     receiver.counters->socket_drops.get(),
+                     receiver.counters->shed_messages.get(),
+                     receiver.counters->overload_periods.get());
+        if (receiver.latency)
+        {
+            receiver.latency->print(std::cerr);
+        }
+    }
+
+    if (late_join && late_join->live())
+    {
+        const auto report{late_join->report()};
+        std::println(std::cerr,
+                     "late join: snapshot at sequence {} ({} orders over {} locates) loaded after {:.1f} ms, {} packets held, live after {:.1f} ms",
+                     report.snapshot.sequence,
+                     report.snapshot.orders,
+                     report.snapshot.locates,
+                     std::chrono::duration<double, std::milli>(report.loaded).count(),
+                     report.held_packets,
+                     std::chrono::duration<double, std::milli>(report.live).count());
+        if (report.missed_messages != 0)
+        {
+            std::println(std::cerr, "late join: {} messages between the snapshot and the feed were never seen", report.missed_messages);
+        }
+    }
+
+    if (options->save_snapshot_path)
+    {
+        const auto& receiver{receivers.front()};
+        const auto snapshot{recovery::encode_snapshot(market, receiver.session, receiver.next_sequence)};
+        if (recovery::write_snapshot(snapshot, *options->save_snapshot_path))
+        {
+            std::println(std::cerr, "snapshot: {} bytes as of sequence {} written to {}", snapshot.size(), receiver.next_sequence, *options->save_snapshot_path);
+        }
+    }
+
+    for (std::size_t i = 0; i < journals.size(); ++i)
+    {
+        journals[i].commit();
+        std::println(std::cerr,
+                     "journal {}: {} events written, {} dropped",
+                     cli::channel_path(*options->journal_path, i, journals.size()),
+                     journals[i].written(),
+                     journals[i].dropped());
+    }
+
+    ring_monitors.clear();
+    for (std::size_t i = 0; i < rings.size(); ++i)
+    {
+        rings[i].commit();
+        std::println(std::cerr, "broadcast {}: {} events published", cli::channel_path(*options->broadcast_name, i, rings.size()), rings[i].written());
+        for (const auto& consumer : rings[i].consumers())
+        {
+            std::println(std::cerr,
+                         "broadcast consumer pid {}: {} behind, {} lost{}",
+                         consumer.pid,
+                         consumer.behind,
+                         consumer.lost,
+                         consumer.slow ? ", slow" : "");
+        }
+    }
+
+    return std::ranges::all_of(receivers, &Receiver::ok) ? 0 : 1;
 }
 
-std::optional<FD> create_mcast_socket(std::string_view mcast_group, int port)
+void pin_receiver(const Receiver& receiver)
 {
-    FD sock{socket(AF_INET, SOCK_DGRAM, 0)};
+    if (!receiver.channel.cpu)
+    {
+        return;
+    }
+    if (rt::pin_current_thread(*receiver.channel.cpu))
+    {
+        std::println(std::cerr, "rx thread for {}:{} pinned to cpu {}", receiver.channel.mcast_group, receiver.channel.port, *receiver.channel.cpu);
+    }
+    else
+    {
+        std::perror("sched_setaffinity");
+    }
+}
+
+void receive(Receiver& receiver, book::Market& market, metrics::Registry& registry, journal::Journal* journal, broadcast::Publisher* ring, int recv_flags, const std::stop_token& stop)
+{
+    logging::Logger logger{std::cerr};
+    feed::BookHandler book_stage{market, receiver.index};
+    feed::MetricsHandler metrics_stage{market, registry, *receiver.counters, logger};
+    feed::SignalHandler signal_stage{market};
+    feed::LoadShedder shed_stage{*receiver.counters, logger};
+
+    std::byte msgbuf[1500];
+    alignas(cmsghdr) std::byte control[256];
+    iovec iov{.iov_base = msgbuf, .iov_len = sizeof(msgbuf)};
+    auto& latency{receiver.latency};
+    const auto start{std::chrono::steady_clock::now()};
+    // the queue costs a syscall to read, so it is only looked at every so many datagrams
+    constexpr std::uint64_t overload_sample_every{64};
+    std::uint64_t datagrams{0};
 
-    const auto yes{1};
-    if (setsockopt(sock.fd(), SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) < 0)
+    // the pipeline's type differs with each optional stage, so the loop is stamped out for each mix
+    auto* const late_join{receiver.late_join};
+    const auto run{[&](auto& pipeline) {
+        while (!rt::shutdown_requested() && !stop.stop_requested())
+        {
+            // a journal with a hole in it is no use to a replay, so the receiver stops at the first loss
+            if (journal != nullptr && journal->dropped() != 0)
+            {
+                std::println(std::cerr, "journal full after {} events, stopping; give it more room with --journal-mib", journal->written());
+                return false;
+            }
+
+            if (late_join != nullptr && !late_join->live() &&
+                !late_join->catch_up([&](std::span<const std::byte> held) { feed::decode_packet(held, pipeline); }))
+            {
+                return false;
+            }
+
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            const ssize_t nbytes{recvmsg(receiver.sock.fd(), &msg, recv_flags)};
+
+            if (nbytes < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                {
+                    continue;
+                }
+                perror("recvmsg");
+                return false;
+            }
+
+            if (++datagrams % overload_sample_every == 0)
+            {
+                if (const auto queue{net::read_rx_queue(receiver.sock)})
+                {
+                    shed_stage.sample(queue->queued_bytes, queue->limit_bytes, net::read_rx_drops(msg));
+                }
+            }
+
+            auto packet{std::span<const std::byte>{msgbuf, static_cast<size_t>(nbytes)}};
+            if (late_join != nullptr)
+            {
+                // held until the snapshot is in, and nothing it has already is applied again
+                if (!late_join->live())
+                {
+                    if (!late_join->hold(packet))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                packet = late_join->admit(packet);
+            }
+
+            const auto exchange_ts{feed::decode_packet(packet, pipeline)};
+
+            if (latency && exchange_ts)
+            {
+                const auto applied{std::chrono::system_clock::now()};
+                const auto stamps{net::read_rx_timestamps(msg)};
+                if (stamps.software_ns != 0)
+                {
+                    latency->record(stamps.software_ns,
+                                    stamps.hardware_ns != 0 ? stamps.hardware_ns : stamps.software_ns,
+                                    *exchange_ts,
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(applied.time_since_epoch()).count());
+                }
+            }
+        }
+        return true;
+    }};
+
+    const auto compose{[&](auto&... sinks) {
+        feed::Pipeline pipeline{shed_stage, book_stage, metrics_stage, signal_stage, sinks...};
+        return run(pipeline);
+    }};
+    if (journal != nullptr && ring != nullptr)
+    {
+        feed::JournalHandler journal_stage{*journal, market};
+        feed::JournalHandler broadcast_stage{*ring, market};
+        receiver.ok = compose(journal_stage, broadcast_stage);
+    }
+    else if (journal != nullptr)
     {
-        std::perror("setsockopt REUSE_ADDR");
-        return std::nullopt;
+        feed::JournalHandler journal_stage{*journal, market};
+        receiver.ok = compose(journal_stage);
     }
+    else if (ring != nullptr)
+    {
+        feed::JournalHandler broadcast_stage{*ring, market};
+        receiver.ok = compose(broadcast_stage);
+    }
+    else
+    {
+        receiver.ok = compose();
+    }
+    receiver.elapsed = std::chrono::steady_clock::now() - start;
+    receiver.session = metrics_stage.session();
+    receiver.next_sequence = metrics_stage.next_sequence();
+}
 
-    sockaddr_in addr{.sin_family = AF_INET,
-                     .sin_port = htons(static_cast<std::uint16_t>(port)),
-                     .sin_addr = {.s_addr = htonl(INADDR_ANY)},
-                     .sin_zero = {}};
+int replay_file(const cli::Options& options)
+{
+    auto file{replay::MappedFile::open(*options.replay_path)};
+    if (!file)
+    {
+        return 1;
+    }
+
+    const auto threads{replay_threads(options)};
 
-    if (bind(sock.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    // rebuild threads allocate concurrently, so the pool has to be the synchronized one
+    std::optional<mem::Arena> arena{};
+    std::optional<std::pmr::synchronized_pool_resource> pool{};
+    if (options.arena_pages)
     {
-        std::perror("bind");
-        return std::nullopt;
+        arena.emplace(options.arena_bytes, *options.arena_pages);
+        arena->prefault();
+        pool.emplace(&*arena);
     }
 
-    ip_mreq mreq{.imr_multiaddr = {.s_addr = inet_addr(mcast_group.data())},
-                 .imr_interface = {.s_addr = htonl(INADDR_ANY)}};
+    book::Market market{pool ? &*pool : std::pmr::get_default_resource()};
+    for (const auto& symbol : options.dense_symbols)
+    {
+        market.select_ladder(itch::to_symbol(symbol), book::liquid_ladder);
+    }
+    if (archive::Reader::is_archive(file->bytes()))
+    {
+        if (!replay_archive(std::move(*file), market))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        const auto summary{replay::run(file->bytes(), threads, market)};
+        const auto scan_ms{std::chrono::duration_cast<std::chrono::milliseconds>(summary.scan).count()};
+        const auto rebuild_ms{std::chrono::duration_cast<std::chrono::milliseconds>(summary.rebuild).count()};
+        const auto seconds{std::chrono::duration<double>(summary.rebuild).count()};
+        std::println(std::cerr,
+                     "replay: {} book messages over {} locates, scan {} ms, rebuild {} ms on {} threads ({:.0f} msgs/s)",
+                     summary.book_messages,
+                     summary.locates,
+                     scan_ms,
+                     rebuild_ms,
+                     threads,
+                     seconds > 0 ? static_cast<double>(summary.book_messages) / seconds : 0.0);
+    }
 
-    if (setsockopt(sock.fd(), IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    std::size_t live_orders{0};
+    std::size_t active_books{0};
+    std::size_t order_bytes{0};
+    for (std::uint16_t locate = 0; locate < std::numeric_limits<std::uint16_t>::max(); ++locate)
     {
-        std::perror("setsockopt IP_ADD_MEMBERSHIP");
-        return std::nullopt;
+        const auto& book{market.get_book(locate)};
+        const auto orders{book.order_count()};
+        live_orders += orders;
+        active_books += orders != 0 ? 1 : 0;
+        order_bytes += book.order_bytes();
     }
 
-    return sock;
+    std::println(std::cerr,
+                 "replay: {} live orders in {} books, {} MiB of order records ({:.1f} bytes per live order)",
+                 live_orders,
+                 active_books,
+                 order_bytes / (1024 * 1024),
+                 live_orders > 0 ? static_cast<double>(order_bytes) / static_cast<double>(live_orders) : 0.0);
+
+    if (arena)
+    {
+        std::println(std::cerr,
+                     "arena: {} of {} MiB used, {} MiB of it freed for reuse, {} bytes spilled",
+                     arena->used() / (1024 * 1024),
+                     arena->capacity() / (1024 * 1024),
+                     arena->free_bytes() / (1024 * 1024),
+                     arena->overflow());
+    }
+
+    return 0;
 }
 
-using Session = std::array<char, 10>;
-struct MoldUDP64Header
+bool replay_archive(replay::MappedFile file, book::Market& market)
 {
-    Session session;
-    std::uint64_t sequence_number;
-    std::uint16_t msg_count;
-};
+    const auto reader{archive::Reader::open(std::move(file))};
+    if (!reader)
+    {
+        return false;
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    reader->for_each([&](itch::MessageType type, std::span<const std::byte> body) { replay::apply(market, type, body); });
+    const auto seconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    const auto& footer{reader->footer()};
+    std::println(std::cerr,
+                 "replay: {} messages from {} chunks decoded and applied in {:.0f} ms, {:.0f} MiB/s of raw feed",
+                 footer.message_count,
+                 footer.chunk_count,
+                 seconds * 1000,
+                 seconds > 0 ? static_cast<double>(footer.raw_bytes) / (1024 * 1024) / seconds : 0.0);
+    return true;
+}
+
+int compress_file(const std::string& raw_path)
+{
+    const auto raw{replay::MappedFile::open(raw_path)};
+    if (!raw)
+    {
+        return 1;
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    const auto path{archive::archive_path(raw_path)};
+    const auto summary{archive::compress(raw->bytes(), path)};
+    if (!summary)
+    {
+        return 1;
+    }
+    const auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+
+    std::println(std::cerr,
+                 "archive: {} messages in {} chunks, {} -> {} MiB ({:.2f}x) written to {} in {} ms",
+                 summary->messages,
+                 summary->chunks,
+                 summary->raw_bytes / (1024 * 1024),
+                 summary->bytes / (1024 * 1024),
+                 summary->bytes > 0 ? static_cast<double>(summary->raw_bytes) / static_cast<double>(summary->bytes) : 0.0,
+                 path,
+                 elapsed.count());
+    return 0;
+}
 
-void process_packet(std::span<const std::byte> buffer, book::Market& market)
+std::size_t replay_threads(const cli::Options& options)
 {
+    return options.replay_threads != 0 ? options.replay_threads : std::max(1U, std::thread::hardware_concurrency());
+}
 
-    MoldUDP64Header header{};
-    std::size_t pos{0};
-
-    header.session = util::extract<Session>(buffer, pos);
-    header.sequence_number = util::extract_be<std::uint64_t>(buffer, pos);
-    header.msg_count = util::extract_be<std::uint16_t>(buffer, pos);
-
-    for (std::size_t i = 0; i < header.msg_count; ++i)
-    {
-        if (pos + 2 > buffer.size())
-        {
-            std::println(std::cerr, "Malformed packet (missing len but should have more messages)");
-            break;
-        }
-
-        const auto msg_len{util::extract_be<std::uint16_t>(buffer, pos)};
-        const auto msg_type{static_cast<itch::MessageType>(buffer[pos++])};
-
-        const auto msg_bytes{buffer.subspan(pos, msg_len - 1)};
-        switch (msg_type)
-        {
-        case itch::MessageType::SystemEvent:
-            itch::parse_system_event_message(msg_bytes);
-            break;
-        case itch::MessageType::StockDirectory:
-            itch::parse_stock_directory_message(msg_bytes);
-            break;
-        case itch::MessageType::StockTradingAction:
-            itch::parse_stock_trading_action_message(msg_bytes);
-            break;
-        case itch::MessageType::RegSHORestriction:
-            itch::parse_reg_sho_restriction_message(msg_bytes);
-            break;
-        case itch::MessageType::MarketParticipantPosition:
-            itch::parse_market_participant_position_message(msg_bytes);
-            break;
-        case itch::MessageType::MWCBDeclineLevel:
-            itch::parse_mwcb_decline_level_message(msg_bytes);
-            break;
-        case itch::MessageType::MWCBStatus:
-            itch::parse_mwcb_status_message(msg_bytes);
-            break;
-        case itch::MessageType::IPOQuotingPeriodUpdate:
-            itch::parse_ipo_quoting_period_update_message(msg_bytes);
-            break;
-        case itch::MessageType::LULDAuctionCollar:
-            itch::parse_luld_auction_collar_message(msg_bytes);
-            break;
-        case itch::MessageType::OperationalHalt:
-            itch::parse_operational_halt_message(msg_bytes);
-            break;
-        case itch::MessageType::AddOrder: {
-            const auto msg{itch::parse_add_order_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .add(msg.order_reference_number, msg.shares, msg.price, msg.side);
-            break;
-        }
-        case itch::MessageType::AddOrderMPID: {
-            const auto msg{itch::parse_add_order_mpid_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .add(msg.order_reference_number, msg.shares, msg.price, msg.side);
-            break;
-        }
-        case itch::MessageType::OrderExecuted: {
-            const auto msg{itch::parse_order_executed_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .reduce(msg.order_reference_number, msg.executed_shares);
-            break;
-        }
-        case itch::MessageType::OrderExecutedWithPrice: {
-            const auto msg{itch::parse_order_executed_with_price_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .reduce(msg.order_reference_number, msg.executed_shares);
-            break;
-        }
-        case itch::MessageType::OrderCancel: {
-            const auto msg{itch::parse_order_cancel_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .reduce(msg.order_reference_number, msg.canceled_shares);
-            break;
-        }
-        case itch::MessageType::OrderDelete: {
-            const auto msg{itch::parse_order_delete_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .remove(msg.order_reference_number);
-            break;
-        }
-        case itch::MessageType::OrderReplace: {
-            const auto msg{itch::parse_order_replace_message(msg_bytes)};
-            market.get_book(msg.header.stock_locate)
-                .replace(msg);
-            break;
-        }
-        case itch::MessageType::Trade:
-            itch::parse_trade_message(msg_bytes);
-            break;
-        case itch::MessageType::CrossTrade:
-            itch::parse_cross_trade_message(msg_bytes);
-            break;
-        case itch::MessageType::BrokenTrade:
-            itch::parse_broken_trade_message(msg_bytes);
-            break;
-        case itch::MessageType::NOII:
-            itch::parse_noii_message(msg_bytes);
-            break;
-        case itch::MessageType::RPII:
-            itch::parse_rpii_message(msg_bytes);
-            break;
-        case itch::MessageType::DirectListingPriceDiscovery:
-            itch::parse_direct_listing_price_discovery_message(msg_bytes);
-            break;
-        default:
-            std::println(std::cerr, "Unknown message type: {}", static_cast<char>(msg_type));
-            break;
-        }
-        pos += msg_len - 1;
+int index_file(const cli::Options& options)
+{
+    const auto& archive_path{*options.index_archive};
+    const auto archive{replay::MappedFile::open(archive_path)};
+    if (!archive)
+    {
+        return 1;
+    }
+
+    auto start{std::chrono::steady_clock::now()};
+    const auto path{replay::index_path(archive_path)};
+    const auto summary{replay::build_index(archive->bytes(), path)};
+    if (!summary)
+    {
+        return 1;
     }
+    auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+
+    std::println(std::cerr,
+                 "index: {} messages over {} locates, {} MiB written to {} in {} ms",
+                 summary->messages,
+                 summary->locates,
+                 summary->bytes / (1024 * 1024),
+                 path,
+                 elapsed.count());
+
+    if (options.checkpoint_secs == 0)
+    {
+        return 0;
+    }
+
+    const auto index{replay::Index::open(archive_path)};
+    if (!index)
+    {
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    const auto checkpoints_path{replay::checkpoint_path(archive_path)};
+    const auto checkpoints{replay::build_checkpoints(*index, checkpoints_path, options.checkpoint_secs * 1'000'000'000, replay_threads(options))};
+    if (!checkpoints)
+    {
+        return 1;
+    }
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::println(std::cerr,
+                 "checkpoints: {} every {}s holding {} orders, {} MiB written to {} in {} ms",
+                 checkpoints->checkpoints,
+                 options.checkpoint_secs,
+                 checkpoints->orders,
+                 checkpoints->bytes / (1024 * 1024),
+                 checkpoints_path,
+                 elapsed.count());
+    return 0;
+}
+
+int query_book(const cli::Options& options)
+{
+    const auto index{replay::Index::open(*options.replay_path)};
+    if (!index)
+    {
+        return 1;
+    }
+    const auto checkpoints{replay::Checkpoints::open(*index, *options.replay_path)};
+    if (!checkpoints)
+    {
+        return 1;
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    const auto book{replay::book_at(*index, *checkpoints, *options.query_locate, *options.query_at_ns)};
+    const auto elapsed{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)};
+
+    const auto bid{book.best_bid()};
+    const auto ask{book.best_ask()};
+    std::println(std::cerr,
+                 "locate {} at {}: {} orders on {} levels, bid {}x{}, ask {}x{}, rebuilt in {} us",
+                 *options.query_locate,
+                 *options.query_at_ns,
+                 book.order_count(),
+                 book.level_count(),
+                 bid ? bid->shares : 0,
+                 bid ? bid->price : 0,
+                 ask ? ask->shares : 0,
+                 ask ? ask->price : 0,
+                 elapsed.count());
+    return 0;
 }
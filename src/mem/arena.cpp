@@ -0,0 +1,330 @@
+#include "arena.h"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr std::size_t huge_page_size{2UL * 1024 * 1024};
+// big enough for a free block's header and footer, and the alignment every block gets for free
+constexpr std::size_t granule{64};
+
+std::size_t round_up(std::size_t n, std::size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+std::byte* map_anonymous(std::size_t bytes, int extra_flags)
+{
+    void* ptr{mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0)};
+    return ptr == MAP_FAILED ? nullptr : static_cast<std::byte*>(ptr);
+}
+
+std::size_t granules_for(std::size_t bytes)
+{
+    return bytes == 0 ? 1 : (bytes + granule - 1) / granule;
+}
+
+// the bin a block of this many granules sits in
+std::size_t bin_of(std::size_t granules)
+{
+    return static_cast<std::size_t>(std::bit_width(granules)) - 1;
+}
+
+// the lowest bin whose every block holds this many granules
+std::size_t bin_holding(std::size_t granules)
+{
+    return static_cast<std::size_t>(std::bit_width(granules - 1));
+}
+
+}
+
+namespace mem
+{
+
+std::optional<PageMode> parse_page_mode(std::string_view name)
+{
+    if (name == "explicit")
+    {
+        return PageMode::Explicit;
+    }
+    if (name == "transparent")
+    {
+        return PageMode::Transparent;
+    }
+    if (name == "off")
+    {
+        return PageMode::Normal;
+    }
+    return std::nullopt;
+}
+
+std::string_view to_string(PageMode mode)
+{
+    switch (mode)
+    {
+    case PageMode::Explicit:
+        return "explicit huge pages";
+    case PageMode::Transparent:
+        return "transparent huge pages";
+    case PageMode::Normal:
+        break;
+    }
+    return "normal pages";
+}
+
+Arena::Arena(std::size_t capacity, PageMode requested)
+    : capacity_{round_up(capacity, huge_page_size)},
+      edges_(capacity_ / granule / 64)
+{
+    if (requested == PageMode::Explicit)
+    {
+        if ((map_base_ = map_anonymous(capacity_, MAP_HUGETLB)) != nullptr)
+        {
+            map_bytes_ = capacity_;
+            begin_ = map_base_;
+            mode_ = PageMode::Explicit;
+            return;
+        }
+        requested = PageMode::Transparent;
+    }
+
+    // over-map by one huge page so the usable range can be 2MiB aligned for thp
+    map_bytes_ = capacity_ + huge_page_size;
+    map_base_ = map_anonymous(map_bytes_, 0);
+    if (map_base_ == nullptr)
+    {
+        throw std::system_error(errno, std::generic_category(), "mmap arena");
+    }
+
+    const auto base{reinterpret_cast<std::uintptr_t>(map_base_)};
+    begin_ = map_base_ + (round_up(base, huge_page_size) - base);
+
+    if (requested == PageMode::Transparent && madvise(begin_, capacity_, MADV_HUGEPAGE) == 0)
+    {
+        mode_ = PageMode::Transparent;
+    }
+}
+
+Arena::~Arena()
+{
+    munmap(map_base_, map_bytes_);
+}
+
+void Arena::prefault() noexcept
+{
+    const auto page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto* volatile_begin{static_cast<volatile std::byte*>(begin_)};
+    for (std::size_t offset = 0; offset < capacity_; offset += page)
+    {
+        volatile_begin[offset] = std::byte{0};
+    }
+}
+
+PageMode Arena::mode() const noexcept
+{
+    return mode_;
+}
+
+std::size_t Arena::capacity() const noexcept
+{
+    return capacity_;
+}
+
+std::size_t Arena::used() const noexcept
+{
+    return used_;
+}
+
+std::size_t Arena::overflow() const noexcept
+{
+    return overflow_;
+}
+
+std::size_t Arena::free_bytes() const noexcept
+{
+    return free_bytes_;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    const auto granules{granules_for(bytes)};
+    if (void* ptr{reuse(granules, alignment)})
+    {
+        return ptr;
+    }
+
+    const auto offset{round_up(used_, alignment)};
+    if (offset + granules * granule > capacity_)
+    {
+        overflow_ += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    // the alignment gap is free space too, or the blocks either side could never coalesce
+    const auto gap{used_};
+    used_ = offset + granules * granule;
+    if (offset != gap)
+    {
+        release(gap, (offset - gap) / granule);
+    }
+    return begin_ + offset;
+}
+
+void Arena::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+{
+    // integer compare, heap spill pointers are unrelated to the mapping
+    const auto addr{reinterpret_cast<std::uintptr_t>(ptr)};
+    const auto begin{reinterpret_cast<std::uintptr_t>(begin_)};
+    if (addr < begin || addr >= begin + capacity_)
+    {
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        return;
+    }
+    release(addr - begin, granules_for(bytes));
+}
+
+void* Arena::reuse(std::size_t granules, std::size_t alignment)
+{
+    // past a granule, the worst case start wastes all but one granule of the alignment
+    const auto slack{alignment > granule ? alignment / granule - 1 : 0};
+    const auto sure_bin{bin_holding(granules + slack)};
+
+    // the smallest bin where any block fits, its head is as good as any
+    FreeBlock* block{nullptr};
+    if (const auto fitting{occupied_bins_ >> sure_bin << sure_bin}; fitting != 0)
+    {
+        block = bins_[static_cast<std::size_t>(std::countr_zero(fitting))];
+    }
+    else
+    {
+        // bins where only some blocks fit, first fit
+        for (auto bin{bin_of(granules)}; bin < sure_bin && block == nullptr; ++bin)
+        {
+            for (auto* candidate{bins_[bin]}; candidate != nullptr; candidate = candidate->next)
+            {
+                const auto offset{static_cast<std::size_t>(reinterpret_cast<std::byte*>(candidate) - begin_)};
+                if (round_up(offset, alignment) + granules * granule <= offset + candidate->granules * granule)
+                {
+                    block = candidate;
+                    break;
+                }
+            }
+        }
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    const auto offset{static_cast<std::size_t>(reinterpret_cast<std::byte*>(block) - begin_)};
+    const auto end{offset + block->granules * granule};
+    unlink(block);
+
+    // the alignment gap and the tail stay free
+    const auto start{round_up(offset, alignment)};
+    if (start != offset)
+    {
+        link(offset, (start - offset) / granule);
+    }
+    if (start + granules * granule != end)
+    {
+        link(start + granules * granule, (end - start) / granule - granules);
+    }
+    return begin_ + start;
+}
+
+void Arena::release(std::size_t offset, std::size_t granules)
+{
+    // a free block's last granule is marked, and nothing free overlaps this one, so a mark just
+    // before is the end of a free neighbour whose size sits in its footer
+    if (offset != 0 && is_edge(offset / granule - 1))
+    {
+        std::size_t prev_granules{};
+        std::memcpy(&prev_granules, begin_ + offset - sizeof(prev_granules), sizeof(prev_granules));
+        offset -= prev_granules * granule;
+        granules += prev_granules;
+        unlink(reinterpret_cast<FreeBlock*>(begin_ + offset));
+    }
+    // and a mark just after is the start of one
+    if (const auto end{offset + granules * granule}; end < used_ && is_edge(end / granule))
+    {
+        auto* next{reinterpret_cast<FreeBlock*>(begin_ + end)};
+        granules += next->granules;
+        unlink(next);
+    }
+
+    // the top of the bump goes back to the bump
+    if (offset + granules * granule == used_)
+    {
+        used_ = offset;
+        return;
+    }
+    link(offset, granules);
+}
+
+void Arena::link(std::size_t offset, std::size_t granules)
+{
+    const auto bin{bin_of(granules)};
+    auto* block{new (begin_ + offset) FreeBlock{.granules = granules, .next = bins_[bin], .prev = nullptr}};
+    std::memcpy(begin_ + offset + granules * granule - sizeof(granules), &granules, sizeof(granules));
+    if (block->next != nullptr)
+    {
+        block->next->prev = block;
+    }
+    bins_[bin] = block;
+    occupied_bins_ |= 1ULL << bin;
+
+    set_edge(offset / granule, true);
+    set_edge(offset / granule + granules - 1, true);
+    free_bytes_ += granules * granule;
+}
+
+void Arena::unlink(FreeBlock* block)
+{
+    const auto bin{bin_of(block->granules)};
+    if (block->prev != nullptr)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        bins_[bin] = block->next;
+        if (block->next == nullptr)
+        {
+            occupied_bins_ &= ~(1ULL << bin);
+        }
+    }
+    if (block->next != nullptr)
+    {
+        block->next->prev = block->prev;
+    }
+
+    const auto first{static_cast<std::size_t>(reinterpret_cast<std::byte*>(block) - begin_) / granule};
+    set_edge(first, false);
+    set_edge(first + block->granules - 1, false);
+    free_bytes_ -= block->granules * granule;
+}
+
+bool Arena::is_edge(std::size_t index) const noexcept
+{
+    return ((edges_[index / 64] >> (index % 64)) & 1) != 0;
+}
+
+void Arena::set_edge(std::size_t index, bool edge) noexcept
+{
+    const auto bit{1ULL << (index % 64)};
+    edges_[index / 64] = edge ? edges_[index / 64] | bit : edges_[index / 64] & ~bit;
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+}
@@ -0,0 +1,99 @@
+#ifndef MEM_ARENA_H_
+#define MEM_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace mem
+{
+
+enum class PageMode
+{
+    Normal,
+    Transparent,
+    Explicit
+};
+
+std::optional<PageMode> parse_page_mode(std::string_view name);
+std::string_view to_string(PageMode mode);
+
+// bump allocator over one mmapped region, explicit huge pages -> thp -> normal pages
+// put a pool resource on top for small objects: it frees blocks past its largest pool, grown
+// vectors and rehashed bucket arrays, straight back here. blocks are whole 64-byte granules, a freed
+// one coalesces with its free neighbours and goes on a free list kept inside the block itself, one
+// list per power-of-two size, which later allocations take before bumping. exhaustion spills to
+// the heap
+class Arena : public std::pmr::memory_resource
+{
+  public:
+    Arena(std::size_t capacity, PageMode requested);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator=(Arena&&) = delete;
+
+    ~Arena() override;
+
+    // touch every page so the trading day never takes a fault in here
+    void prefault() noexcept;
+
+    [[nodiscard]]
+    PageMode mode() const noexcept;
+    [[nodiscard]]
+    std::size_t capacity() const noexcept;
+    [[nodiscard]]
+    std::size_t used() const noexcept;
+    [[nodiscard]]
+    std::size_t overflow() const noexcept;
+    // freed inside the region and not yet handed out again
+    [[nodiscard]]
+    std::size_t free_bytes() const noexcept;
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    [[nodiscard]]
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    // header of a free block, its granule count is repeated in the block's last 8 bytes
+    struct FreeBlock
+    {
+        std::size_t granules;
+        FreeBlock* next;
+        FreeBlock* prev;
+    };
+
+    [[nodiscard]]
+    void* reuse(std::size_t granules, std::size_t alignment);
+    // coalesces with the free blocks either side, or hands the top of the region back to the bump
+    void release(std::size_t offset, std::size_t granules);
+    void link(std::size_t offset, std::size_t granules);
+    void unlink(FreeBlock* block);
+    [[nodiscard]]
+    bool is_edge(std::size_t index) const noexcept;
+    void set_edge(std::size_t index, bool edge) noexcept;
+
+    std::byte* map_base_{nullptr};
+    std::size_t map_bytes_{0};
+    std::byte* begin_{nullptr};
+    std::size_t capacity_{0};
+    std::size_t used_{0};
+    std::size_t overflow_{0};
+    // bin n holds the free blocks of [2^n, 2^(n+1)) granules, never adjacent, none ending at used_
+    std::array<FreeBlock*, 64> bins_{};
+    std::uint64_t occupied_bins_{0};
+    // one bit per granule, set on the first and last granule of every free block
+    std::vector<std::uint64_t> edges_;
+    std::size_t free_bytes_{0};
+    PageMode mode_{PageMode::Normal};
+};
+
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+#include <iostream>
+#include <print>
+#include <iterator>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../itch/types.h"
+#include "../rt/tuning.h"
+
+namespace
+{
+
+void append_line(std::string& out, std::string_view name, std::uint64_t value)
+{
+    std::format_to(std::back_inserter(out), "{} {}\n", name, value);
+}
+
+void serve(const metrics::Registry& registry, int listener, const std::stop_token& stop)
+{
+    // created after the receiver is pinned; the polling and snapshot formatting go elsewhere
+    if (!rt::leave_rx_cpus())
+    {
+        std::perror("sched_setaffinity metrics");
+    }
+
+    pollfd pfd{.fd = listener, .events = POLLIN, .revents = 0};
+    while (!stop.stop_requested())
+    {
+        if (poll(&pfd, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        const int client{accept(listener, nullptr, nullptr)};
+        if (client < 0)
+        {
+            continue;
+        }
+
+        // a scraper that connects and never reads fills the socket buffer; give up on it rather
+        // than block here where a stop can't be seen
+        const timeval send_timeout{.tv_sec = 0, .tv_usec = 100'000};
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+        const auto text{registry.snapshot()};
+        std::size_t sent{0};
+        while (sent < text.size() && !stop.stop_requested())
+        {
+            const auto n{send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL)};
+            if (n <= 0)
+            {
+                break;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+        close(client);
+    }
+}
+
+}
+
+namespace metrics
+{
+
+ThreadCounters* Registry::add_thread() noexcept
+{
+    const auto slot{thread_count_.fetch_add(1, std::memory_order_acq_rel)};
+    if (slot >= max_threads)
+    {
+        thread_count_.store(max_threads, std::memory_order_release);
+        return nullptr;
+    }
+    return &threads_[slot];
+}
+
+std::string Registry::snapshot() const
+{
+    ThreadCounters total{};
+    const auto threads{thread_count_.load(std::memory_order_acquire)};
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        const auto& counters{threads_[t]};
+        total.packets.add(counters.packets.get());
+        total.malformed_packets.add(counters.malformed_packets.get());
+        total.unknown_message_types.add(counters.unknown_message_types.get());
+        total.sequence_gaps.add(counters.sequence_gaps.get());
+        total.missed_messages.add(counters.missed_messages.get());
+        total.orders_added.add(counters.orders_added.get());
+        total.orders_removed.add(counters.orders_removed.get());
+        total.books_activated.add(counters.books_activated.get());
+        total.books_deactivated.add(counters.books_deactivated.get());
+        total.trades_broken.add(counters.trades_broken.get());
+        total.unmatched_busts.add(counters.unmatched_busts.get());
+        total.socket_drops.add(counters.socket_drops.get());
+        total.overload_periods.add(counters.overload_periods.get());
+        total.shed_messages.add(counters.shed_messages.get());
+        for (std::size_t type = 0; type < counters.messages.size(); ++type)
+        {
+            total.messages[type].add(counters.messages[type].get());
+        }
+    }
+
+    std::string out{};
+    append_line(out, "packets", total.packets.get());
+    for (std::size_t type = 0; type < total.messages.size(); ++type)
+    {
+        if (const auto count{total.messages[type].get()}; count != 0)
+        {
+            const auto code{static_cast<char>(type)};
+            std::format_to(std::back_inserter(out),
+                           "messages{{type=\"{}\",code=\"{}\"}} {}\n",
+                           static_cast<itch::MessageType>(code),
+                           code,
+                           count);
+        }
+    }
+    append_line(out, "malformed_packets", total.malformed_packets.get());
+    append_line(out, "unknown_message_types", total.unknown_message_types.get());
+    append_line(out, "sequence_gaps", total.sequence_gaps.get());
+    append_line(out, "missed_messages", total.missed_messages.get());
+    append_line(out, "trades_broken", total.trades_broken.get());
+    append_line(out, "unmatched_busts", total.unmatched_busts.get());
+    append_line(out, "socket_drops", total.socket_drops.get());
+    append_line(out, "overload_periods", total.overload_periods.get());
+    append_line(out, "shed_messages", total.shed_messages.get());
+    // counters are read one at a time, a racing remove can briefly outrun its add
+    append_line(out, "live_orders", total.orders_added.get() - std::min(total.orders_added.get(), total.orders_removed.get()));
+    append_line(out, "active_books", total.books_activated.get() - std::min(total.books_activated.get(), total.books_deactivated.get()));
+
+    // each receive thread is one feed channel, throughput is read off these between snapshots
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        const auto& counters{threads_[t]};
+        std::uint64_t messages{0};
+        for (const auto& count : counters.messages)
+        {
+            messages += count.get();
+        }
+        std::format_to(std::back_inserter(out), "receiver_packets{{receiver=\"{}\"}} {}\n", t, counters.packets.get());
+        std::format_to(std::back_inserter(out), "receiver_messages{{receiver=\"{}\"}} {}\n", t, messages);
+        std::format_to(std::back_inserter(out), "receiver_missed_messages{{receiver=\"{}\"}} {}\n", t, counters.missed_messages.get());
+        std::format_to(std::back_inserter(out), "receiver_socket_drops{{receiver=\"{}\"}} {}\n", t, counters.socket_drops.get());
+    }
+
+    for (std::size_t locate = 0; locate < peak_levels_.size(); ++locate)
+    {
+        if (const auto peak{peak_levels_[locate].load(std::memory_order_relaxed)}; peak != 0)
+        {
+            std::format_to(std::back_inserter(out), "peak_levels{{locate=\"{}\"}} {}\n", locate, peak);
+        }
+    }
+    return out;
+}
+
+std::optional<Server> Server::create(const Registry& registry, const std::string& path)
+{
+    sockaddr_un addr{.sun_family = AF_UNIX, .sun_path = {}};
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        std::println(std::cerr, "metrics socket path too long: {}", path);
+        return std::nullopt;
+    }
+    path.copy(addr.sun_path, path.size());
+
+    const int fd{socket(AF_UNIX, SOCK_STREAM, 0)};
+    if (fd < 0)
+    {
+        std::perror("socket metrics");
+        return std::nullopt;
+    }
+    FD listener{fd};
+
+    // stale socket from a previous run
+    unlink(path.c_str());
+
+    if (bind(listener.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        std::perror("bind metrics");
+        return std::nullopt;
+    }
+
+    if (listen(listener.fd(), 8) < 0)
+    {
+        std::perror("listen metrics");
+        return std::nullopt;
+    }
+
+    return Server{registry, std::move(listener)};
+}
+
+Server::Server(const Registry& registry, FD listener)
+    : listener_{std::move(listener)},
+      thread_{[&registry, fd = listener_.fd()](const std::stop_token& stop) { serve(registry, fd, stop); }}
+{
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef METRICS_METRICS_H_
+#define METRICS_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "../fd/fd.h"
+#include "../util/cache.h"
+
+namespace metrics
+{
+
+// one writer, any number of readers: a plain load/store pair instead of a locked rmw
+class Counter
+{
+  public:
+    void add(std::uint64_t n = 1) noexcept
+    {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    std::uint64_t get() const noexcept
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<std::uint64_t> value_{0};
+};
+
+// owned by one hot-path thread, aligned so threads never share a line
+struct alignas(util::cache_line_size) ThreadCounters
+{
+    Counter packets;
+    Counter malformed_packets;
+    Counter unknown_message_types;
+    Counter sequence_gaps;
+    Counter missed_messages;
+    Counter orders_added;
+    Counter orders_removed;
+    Counter books_activated;
+    Counter books_deactivated;
+    Counter trades_broken;
+    // busts with nothing to correct: evicted from the execution index, never seen, or already broken
+    Counter unmatched_busts;
+    // datagrams the kernel dropped on the socket, and what the load shedder skipped meanwhile
+    Counter socket_drops;
+    Counter overload_periods;
+    Counter shed_messages;
+    // indexed by the itch::MessageType character
+    std::array<Counter, 256> messages;
+};
+
+class Registry
+{
+  public:
+    // startup only, nullptr once every slot is taken
+    ThreadCounters* add_thread() noexcept;
+
+    // levels only grow one at a time, so call this when a level is created
+    void observe_levels(std::uint16_t stock_locate, std::size_t levels) noexcept
+    {
+        auto& peak{peak_levels_[stock_locate]};
+        if (levels > peak.load(std::memory_order_relaxed))
+        {
+            peak.store(static_cast<std::uint32_t>(levels), std::memory_order_relaxed);
+        }
+    }
+
+    // text, one "name value" per line
+    [[nodiscard]]
+    std::string snapshot() const;
+
+  private:
+    static constexpr std::size_t max_threads{16};
+
+    std::array<ThreadCounters, max_threads> threads_{};
+    std::atomic<std::size_t> thread_count_{0};
+    std::array<std::atomic<std::uint32_t>, std::numeric_limits<std::uint16_t>::max() + 1> peak_levels_{};
+};
+
+// answers every connection on a unix stream socket with a snapshot and closes it
+class Server
+{
+  public:
+    static std::optional<Server> create(const Registry& registry, const std::string& path);
+
+    Server(Server&& other) noexcept = default;
+    Server& operator=(Server&& other) noexcept = default;
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    ~Server() = default;
+
+  private:
+    Server(const Registry& registry, FD listener);
+
+    FD listener_;
+    std::jthread thread_;
+};
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "mcast.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sock_diag.h>
+
+namespace
+{
+
+int get_int_option(int fd, int level, int name)
+{
+    int value{0};
+    socklen_t len{sizeof(value)};
+    if (getsockopt(fd, level, name, &value, &len) < 0)
+    {
+        return -1;
+    }
+    return value;
+}
+
+std::int64_t to_ns(const timespec& ts)
+{
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+}
+
+namespace net
+{
+
+std::optional<FD> create_mcast_socket(std::string_view mcast_group, int port, const SocketTuning& tuning)
+{
+    FD sock{socket(AF_INET, SOCK_DGRAM, 0)};
+
+    const auto yes{1};
+    if (setsockopt(sock.fd(), SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) < 0)
+    {
+        std::perror("setsockopt REUSE_ADDR");
+        return std::nullopt;
+    }
+
+    if (tuning.rcvbuf_bytes)
+    {
+        // FORCE ignores rmem_max but needs CAP_NET_ADMIN
+        const auto bytes{*tuning.rcvbuf_bytes};
+        if (setsockopt(sock.fd(), SOL_SOCKET, SO_RCVBUFFORCE, &bytes, sizeof(bytes)) < 0 &&
+            setsockopt(sock.fd(), SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0)
+        {
+            std::perror("setsockopt SO_RCVBUF");
+        }
+    }
+
+    if (tuning.busy_poll_us)
+    {
+        const auto usecs{*tuning.busy_poll_us};
+        if (setsockopt(sock.fd(), SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) < 0)
+        {
+            std::perror("setsockopt SO_BUSY_POLL");
+        }
+    }
+
+    // every datagram after the first drop carries the socket's drop count
+    const auto on{1};
+    if (setsockopt(sock.fd(), SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0)
+    {
+        std::perror("setsockopt SO_RXQ_OVFL");
+    }
+
+    if (tuning.rx_timestamps)
+    {
+        if (setsockopt(sock.fd(), SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+        {
+            std::perror("setsockopt SO_TIMESTAMPNS");
+        }
+
+        const int flags{SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                        SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE};
+        if (setsockopt(sock.fd(), SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0)
+        {
+            std::perror("setsockopt SO_TIMESTAMPING");
+        }
+    }
+
+    if (tuning.recv_timeout_ms)
+    {
+        const timeval timeout{.tv_sec = *tuning.recv_timeout_ms / 1000, .tv_usec = (*tuning.recv_timeout_ms % 1000) * 1000};
+        if (setsockopt(sock.fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)
+        {
+            std::perror("setsockopt SO_RCVTIMEO");
+        }
+    }
+
+    sockaddr_in addr{.sin_family = AF_INET,
+                     .sin_port = htons(static_cast<std::uint16_t>(port)),
+                     .sin_addr = {.s_addr = htonl(INADDR_ANY)},
+                     .sin_zero = {}};
+
+    if (bind(sock.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        std::perror("bind");
+        return std::nullopt;
+    }
+
+    ip_mreq mreq{.imr_multiaddr = {.s_addr = inet_addr(mcast_group.data())},
+                 .imr_interface = {.s_addr = htonl(INADDR_ANY)}};
+
+    if (setsockopt(sock.fd(), IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    {
+        std::perror("setsockopt IP_ADD_MEMBERSHIP");
+        return std::nullopt;
+    }
+
+    // a wildcard bind otherwise hears every group joined on this port, other channels' included
+    const auto no{0};
+    if (setsockopt(sock.fd(), IPPROTO_IP, IP_MULTICAST_ALL, &no, sizeof(no)) < 0)
+    {
+        std::perror("setsockopt IP_MULTICAST_ALL");
+    }
+
+    return sock;
+}
+
+SocketSettings read_socket_settings(const FD& sock)
+{
+    return {.busy_poll_us = get_int_option(sock.fd(), SOL_SOCKET, SO_BUSY_POLL),
+            .rcvbuf_bytes = get_int_option(sock.fd(), SOL_SOCKET, SO_RCVBUF)};
+}
+
+RxTimestamps read_rx_timestamps(msghdr& msg) noexcept
+{
+    RxTimestamps stamps{.software_ns = 0, .hardware_ns = 0};
+    for (auto* cmsg{CMSG_FIRSTHDR(&msg)}; cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET)
+        {
+            continue;
+        }
+
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING)
+        {
+            scm_timestamping ts{};
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            if (const auto sw{to_ns(ts.ts[0])}; sw != 0)
+            {
+                stamps.software_ns = sw;
+            }
+            stamps.hardware_ns = to_ns(ts.ts[2]);
+        }
+        else if (cmsg->cmsg_type == SCM_TIMESTAMPNS && stamps.software_ns == 0)
+        {
+            timespec ts{};
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            stamps.software_ns = to_ns(ts);
+        }
+    }
+    return stamps;
+}
+
+std::optional<RxQueue> read_rx_queue(const FD& sock) noexcept
+{
+    std::array<std::uint32_t, SK_MEMINFO_VARS> info{};
+    socklen_t len{sizeof(info)};
+    if (getsockopt(sock.fd(), SOL_SOCKET, SO_MEMINFO, info.data(), &len) < 0 || len < sizeof(std::uint32_t) * (SK_MEMINFO_RCVBUF + 1))
+    {
+        return std::nullopt;
+    }
+    return RxQueue{.queued_bytes = info[SK_MEMINFO_RMEM_ALLOC], .limit_bytes = info[SK_MEMINFO_RCVBUF]};
+}
+
+std::uint32_t read_rx_drops(msghdr& msg) noexcept
+{
+    for (auto* cmsg{CMSG_FIRSTHDR(&msg)}; cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+        {
+            std::uint32_t drops{0};
+            std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            return drops;
+        }
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef NET_MCAST_H_
+#define NET_MCAST_H_
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <sys/socket.h>
+
+#include "../fd/fd.h"
+
+namespace net
+{
+
+// best effort, unset leaves the kernel default
+struct SocketTuning
+{
+    std::optional<int> busy_poll_us;
+    std::optional<int> rcvbuf_bytes;
+    // SO_TIMESTAMPNS plus SO_TIMESTAMPING where the kernel has it
+    bool rx_timestamps{false};
+    // SO_RCVTIMEO, a blocked receive returns EAGAIN this often
+    std::optional<int> recv_timeout_ms;
+};
+
+// from recvmsg control data, 0 when not supplied
+// hardware needs the NIC's rx stamping switched on (hwstamp_ctl / ptp4l)
+struct RxTimestamps
+{
+    std::int64_t software_ns;
+    std::int64_t hardware_ns;
+};
+
+// what the kernel actually granted
+struct SocketSettings
+{
+    int busy_poll_us;
+    int rcvbuf_bytes;
+};
+
+// SO_MEMINFO: what the receive queue holds against what it may, both in kernel-accounted bytes
+// (FIONREAD on a datagram socket only sizes the next datagram)
+struct RxQueue
+{
+    std::uint32_t queued_bytes;
+    std::uint32_t limit_bytes;
+};
+
+std::optional<FD> create_mcast_socket(std::string_view mcast_group, int port, const SocketTuning& tuning = {});
+SocketSettings read_socket_settings(const FD& sock);
+RxTimestamps read_rx_timestamps(msghdr& msg) noexcept;
+std::optional<RxQueue> read_rx_queue(const FD& sock) noexcept;
+// SO_RXQ_OVFL: datagrams the kernel has dropped on this socket so far for want of buffer,
+// 0 while none have been (the kernel leaves the control message out until then)
+std::uint32_t read_rx_drops(msghdr& msg) noexcept;
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "late_join.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <print>
+#include <string_view>
+#include <utility>
+
+#include "../rt/tuning.h"
+#include "../util/binary_io.h"
+
+namespace
+{
+
+// session, sequence number, message count
+constexpr std::size_t mold_header_size{sizeof(feed::Session) + sizeof(std::uint64_t) + sizeof(std::uint16_t)};
+constexpr std::size_t sequence_offset{sizeof(feed::Session)};
+
+}
+
+namespace recovery
+{
+
+LateJoin::LateJoin(std::string source, book::Market& market, std::size_t buffer_bytes)
+    : started_{std::chrono::steady_clock::now()},
+      held_(buffer_bytes),
+      fetcher_{[this, source = std::move(source), &market](const std::stop_token& stop) { fetch(source, market, stop); }}
+{
+    trimmed_.reserve(64 * 1024);
+}
+
+bool LateJoin::hold(std::span<const std::byte> packet)
+{
+    const auto length{static_cast<std::uint16_t>(packet.size())};
+    if (held_.size() - held_bytes_ < sizeof(length) + packet.size())
+    {
+        std::println(std::cerr, "late join: {} packets held and the buffer is full before the snapshot arrived", held_packets_);
+        return false;
+    }
+    std::memcpy(held_.data() + held_bytes_, &length, sizeof(length));
+    std::memcpy(held_.data() + held_bytes_ + sizeof(length), packet.data(), packet.size());
+    held_bytes_ += sizeof(length) + packet.size();
+    ++held_packets_;
+    return true;
+}
+
+std::span<const std::byte> LateJoin::admit(std::span<const std::byte> packet)
+{
+    if (caught_up_ || packet.size() < mold_header_size)
+    {
+        return packet;
+    }
+
+    std::size_t pos{sequence_offset};
+    const auto sequence{util::extract_be<std::uint64_t>(packet, pos)};
+    const auto count{util::extract_be<std::uint16_t>(packet, pos)};
+    if (sequence >= snapshot_.sequence)
+    {
+        caught_up_ = true;
+        missed_messages_ = sequence - snapshot_.sequence;
+        return packet;
+    }
+    if (sequence + count <= snapshot_.sequence)
+    {
+        return {};
+    }
+
+    // the snapshot has the first few messages of this one already
+    const auto skip{snapshot_.sequence - sequence};
+    for (std::uint64_t i = 0; i < skip; ++i)
+    {
+        if (packet.size() - pos < sizeof(std::uint16_t))
+        {
+            return {};
+        }
+        const auto length{util::extract_be<std::uint16_t>(packet, pos)};
+        if (packet.size() - pos < length)
+        {
+            return {};
+        }
+        pos += length;
+    }
+
+    caught_up_ = true;
+    trimmed_.assign(packet.begin(), packet.begin() + sequence_offset);
+    trimmed_.resize(mold_header_size);
+    std::size_t header_pos{sequence_offset};
+    util::store_be(trimmed_, header_pos, snapshot_.sequence);
+    util::store_be(trimmed_, header_pos, static_cast<std::uint16_t>(count - skip));
+    trimmed_.insert(trimmed_.end(), packet.begin() + static_cast<std::ptrdiff_t>(pos), packet.end());
+    return trimmed_;
+}
+
+bool LateJoin::live() const noexcept
+{
+    return live_;
+}
+
+LateJoinReport LateJoin::report() const noexcept
+{
+    return {.snapshot = snapshot_,
+            .loaded = loaded_,
+            .live = live_after_,
+            .held_packets = held_packets_,
+            .missed_messages = missed_messages_};
+}
+
+void LateJoin::fetch(const std::string& source, book::Market& market, const std::stop_token& stop)
+{
+    // the download and the book build would otherwise share a core with the receiver holding packets
+    if (!rt::leave_rx_cpus())
+    {
+        std::perror("sched_setaffinity late join");
+    }
+
+    const auto snapshot{fetch_snapshot(source, stop)};
+    const auto info{snapshot ? load_snapshot(*snapshot, market) : std::nullopt};
+    if (!info)
+    {
+        std::println(std::cerr, "late join: no usable snapshot from {}", source);
+        state_.store(State::Failed, std::memory_order_release);
+        return;
+    }
+    snapshot_ = *info;
+    loaded_ = std::chrono::steady_clock::now() - started_;
+    state_.store(State::Loaded, std::memory_order_release);
+}
+
+bool LateJoin::same_session() const
+{
+    if (held_bytes_ == 0)
+    {
+        return true;
+    }
+    std::size_t pos{0};
+    const auto packet{next_held(pos)};
+    if (packet.size() < mold_header_size || std::ranges::equal(packet.first(sizeof(feed::Session)), std::as_bytes(std::span{snapshot_.session})))
+    {
+        return true;
+    }
+    std::println(std::cerr,
+                 "late join: snapshot is for session {}, the feed is on {}",
+                 std::string_view{snapshot_.session.data(), snapshot_.session.size()},
+                 std::string_view{reinterpret_cast<const char*>(packet.data()), sizeof(feed::Session)});
+    return false;
+}
+
+std::span<const std::byte> LateJoin::next_held(std::size_t& pos) const
+{
+    std::uint16_t length{0};
+    std::memcpy(&length, held_.data() + pos, sizeof(length));
+    const auto packet{std::span<const std::byte>{held_}.subspan(pos + sizeof(length), length)};
+    pos += sizeof(length) + length;
+    return packet;
+}
+
+void LateJoin::go_live()
+{
+    live_ = true;
+    live_after_ = std::chrono::steady_clock::now() - started_;
+    // the buffer is only for the join
+    held_ = {};
+    held_bytes_ = 0;
+}
+
+}
@@ -0,0 +1,124 @@
+#ifndef RECOVERY_LATE_JOIN_H_
+#define RECOVERY_LATE_JOIN_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "snapshot.h"
+#include "../book/market.h"
+
+namespace recovery
+{
+
+struct LateJoinReport
+{
+    SnapshotInfo snapshot;
+    // from construction until the snapshot was in the market
+    std::chrono::steady_clock::duration loaded;
+    // until the last held packet had been replayed
+    std::chrono::steady_clock::duration live;
+    std::uint64_t held_packets;
+    // messages between the snapshot and the first packet after it, lost for good
+    std::uint64_t missed_messages;
+};
+
+// joins a session already under way: the receive thread holds every packet from the first one on
+// while another thread fetches a snapshot and loads it into the market, then the held packets are
+// replayed from the snapshot's sequence and the receive thread goes on as usual
+class LateJoin
+{
+  public:
+    // starts the fetch, off the receivers' cores; buffer_bytes bounds what can be held meanwhile
+    LateJoin(std::string source, book::Market& market, std::size_t buffer_bytes);
+
+    LateJoin(const LateJoin&) = delete;
+    LateJoin& operator=(const LateJoin&) = delete;
+    LateJoin(LateJoin&&) = delete;
+    LateJoin& operator=(LateJoin&&) = delete;
+    // stops a fetch still waiting on the server
+    ~LateJoin() = default;
+
+    // receive thread, until live: a copy of the packet, false once the buffer is full
+    bool hold(std::span<const std::byte> packet);
+
+    // receive thread, whenever it is not live yet: once the snapshot is in, every held packet from
+    // its sequence on goes to fn in arrival order and the join is live; false if the snapshot
+    // could not be had or is for another session
+    template <typename Fn>
+    bool catch_up(Fn&& fn)
+    {
+        const auto state{state_.load(std::memory_order_acquire)};
+        if (state == State::Fetching)
+        {
+            return true;
+        }
+        if (state == State::Failed || !same_session())
+        {
+            return false;
+        }
+
+        for (std::size_t pos = 0; pos < held_bytes_;)
+        {
+            const auto packet{next_held(pos)};
+            if (const auto admitted{admit(packet)}; !admitted.empty())
+            {
+                fn(admitted);
+            }
+        }
+        go_live();
+        return true;
+    }
+
+    // the part of packet from the snapshot's sequence on, empty if it is all older
+    std::span<const std::byte> admit(std::span<const std::byte> packet);
+
+    [[nodiscard]]
+    bool live() const noexcept;
+    // meaningful once live
+    [[nodiscard]]
+    LateJoinReport report() const noexcept;
+
+  private:
+    enum class State : std::uint8_t
+    {
+        Fetching,
+        Loaded,
+        Failed
+    };
+
+    void fetch(const std::string& source, book::Market& market, const std::stop_token& stop);
+    [[nodiscard]]
+    bool same_session() const;
+    std::span<const std::byte> next_held(std::size_t& pos) const;
+    void go_live();
+
+    std::chrono::steady_clock::time_point started_;
+    // written by the fetch thread before state_ leaves Fetching
+    SnapshotInfo snapshot_{};
+    std::chrono::steady_clock::duration loaded_{};
+    std::atomic<State> state_{State::Fetching};
+
+    // length-prefixed packets, touched up front so holding one never faults
+    std::vector<std::byte> held_;
+    std::size_t held_bytes_{0};
+    std::uint64_t held_packets_{0};
+    // a packet that straddles the snapshot, rewritten without the messages it already covers
+    std::vector<std::byte> trimmed_;
+    bool caught_up_{false};
+    bool live_{false};
+    std::chrono::steady_clock::duration live_after_{};
+    std::uint64_t missed_messages_{0};
+
+    std::jthread fetcher_;
+};
+
+}
+
+#endif
@@ -0,0 +1,347 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <print>
+#include <string_view>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../fd/fd.h"
+#include "../replay/mapped_file.h"
+#include "../util/binary_io.h"
+
+namespace
+{
+
+constexpr std::string_view tcp_scheme{"tcp://"};
+// a fetch looks for a stop this often, and gives up on a server that goes quiet for the timeout
+constexpr int fetch_poll_ms{100};
+constexpr std::chrono::seconds fetch_idle_timeout{10};
+
+template <typename T>
+void append_be(std::vector<std::byte>& out, T value)
+{
+    auto pos{out.size()};
+    out.resize(pos + sizeof(T));
+    util::store_be(std::span{out}, pos, value);
+}
+
+template <std::size_t N>
+void append_chars(std::vector<std::byte>& out, const std::array<char, N>& chars)
+{
+    const auto* bytes{reinterpret_cast<const std::byte*>(chars.data())};
+    out.insert(out.end(), bytes, bytes + N);
+}
+
+void append(std::vector<std::byte>& out, const recovery::SnapshotHeader& header)
+{
+    append_chars(out, header.magic);
+    append_be(out, header.sequence);
+    append_be(out, header.locate_count);
+    append_be(out, header.order_count);
+    append_chars(out, header.session);
+}
+
+void append(std::vector<std::byte>& out, const recovery::LocateOrders& locate)
+{
+    append_be(out, locate.order_count);
+    append_be(out, locate.locate);
+    append_chars(out, locate.symbol);
+    append_be(out, locate.ladder.tick);
+    append_be(out, locate.ladder.ticks);
+}
+
+void append(std::vector<std::byte>& out, const replay::SavedOrder& order)
+{
+    append_be(out, order.ref_num);
+    append_be(out, order.shares);
+    append_be(out, order.price_side);
+}
+
+// "<ipv4>:<port>"
+std::optional<sockaddr_in> parse_endpoint(std::string_view endpoint)
+{
+    const auto colon{endpoint.rfind(':')};
+    if (colon == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+    const std::string host{endpoint.substr(0, colon)};
+    const auto port_text{endpoint.substr(colon + 1)};
+
+    std::uint16_t port{0};
+    const auto [end, ec]{std::from_chars(port_text.data(), port_text.data() + port_text.size(), port)};
+    if (ec != std::errc{} || end != port_text.data() + port_text.size() || port == 0)
+    {
+        return std::nullopt;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+    {
+        return std::nullopt;
+    }
+    return addr;
+}
+
+// false on a stop, an error or a server that has been quiet too long
+bool wait_for(int fd, short events, const std::stop_token& stop)
+{
+    pollfd pfd{.fd = fd, .events = events, .revents = 0};
+    const auto deadline{std::chrono::steady_clock::now() + fetch_idle_timeout};
+    while (!stop.stop_requested())
+    {
+        const int ready{poll(&pfd, 1, fetch_poll_ms)};
+        if (ready > 0)
+        {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR)
+        {
+            std::perror("poll snapshot");
+            return false;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            std::println(std::cerr, "snapshot server silent for {}s, giving up", fetch_idle_timeout.count());
+            return false;
+        }
+    }
+    return false;
+}
+
+std::optional<std::vector<std::byte>> fetch_tcp(std::string_view endpoint, const std::stop_token& stop)
+{
+    const auto addr{parse_endpoint(endpoint)};
+    if (!addr)
+    {
+        std::println(std::cerr, "invalid snapshot server {}", endpoint);
+        return std::nullopt;
+    }
+
+    // non-blocking throughout, so a hung server never holds up a shutdown
+    const int fd{socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)};
+    if (fd < 0)
+    {
+        std::perror("socket snapshot");
+        return std::nullopt;
+    }
+    FD sock{fd};
+
+    if (connect(sock.fd(), reinterpret_cast<const sockaddr*>(&*addr), sizeof(*addr)) < 0)
+    {
+        if (errno != EINPROGRESS)
+        {
+            std::perror("connect snapshot");
+            return std::nullopt;
+        }
+        if (!wait_for(sock.fd(), POLLOUT, stop))
+        {
+            return std::nullopt;
+        }
+        int error{0};
+        socklen_t length{sizeof(error)};
+        if (getsockopt(sock.fd(), SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+        {
+            errno = error;
+            std::perror("connect snapshot");
+            return std::nullopt;
+        }
+    }
+
+    // the server closes once the snapshot is out
+    std::vector<std::byte> out{};
+    std::array<std::byte, 64 * 1024> chunk{};
+    for (;;)
+    {
+        const auto n{read(sock.fd(), chunk.data(), chunk.size())};
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN)
+            {
+                if (!wait_for(sock.fd(), POLLIN, stop))
+                {
+                    return std::nullopt;
+                }
+                continue;
+            }
+            std::perror("read snapshot");
+            return std::nullopt;
+        }
+        if (n == 0)
+        {
+            return out;
+        }
+        out.insert(out.end(), chunk.begin(), chunk.begin() + n);
+    }
+}
+
+std::optional<std::vector<std::byte>> fetch_file(const std::string& path)
+{
+    const auto file{replay::MappedFile::open(path)};
+    if (!file)
+    {
+        return std::nullopt;
+    }
+    const auto bytes{file->bytes()};
+    return std::vector<std::byte>{bytes.begin(), bytes.end()};
+}
+
+}
+
+namespace recovery
+{
+
+std::vector<std::byte> encode_snapshot(const book::Market& market, const feed::Session& session, std::uint64_t sequence)
+{
+    // the header goes in last, once the counts are known
+    std::vector<std::byte> out(snapshot_header_size);
+    SnapshotHeader header{.magic = snapshot_magic, .sequence = sequence, .locate_count = 0, .order_count = 0, .session = session};
+
+    std::vector<std::pair<std::uint32_t, replay::SavedOrder>> resting{};
+    for (std::uint32_t locate = 0; locate < std::numeric_limits<std::uint16_t>::max(); ++locate)
+    {
+        const auto& book{market.get_book(static_cast<std::uint16_t>(locate))};
+        const auto symbol{market.symbol(static_cast<std::uint16_t>(locate))};
+        if (book.order_count() == 0 && !symbol)
+        {
+            continue;
+        }
+
+        // time priority, so a load rebuilds the same queues
+        resting.clear();
+        book.for_each_order([&](std::uint64_t ref_num, const book::QueuedOrder& order) {
+            resting.emplace_back(order.seq, replay::SavedOrder{.ref_num = ref_num, .shares = order.shares, .price_side = order.price_side});
+        });
+        std::ranges::sort(resting, {}, &std::pair<std::uint32_t, replay::SavedOrder>::first);
+
+        append(out, LocateOrders{.order_count = resting.size(),
+                                 .locate = static_cast<std::uint16_t>(locate),
+                                 .symbol = symbol.value_or(itch::Symbol{}),
+                                 .ladder = book.ladder()});
+        for (const auto& [seq, order] : resting)
+        {
+            append(out, order);
+        }
+        ++header.locate_count;
+        header.order_count += resting.size();
+    }
+
+    std::vector<std::byte> head{};
+    append(head, header);
+    std::ranges::copy(head, out.begin());
+    return out;
+}
+
+bool write_snapshot(std::span<const std::byte> snapshot, const std::string& path)
+{
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write(reinterpret_cast<const char*>(snapshot.data()), static_cast<std::streamsize>(snapshot.size()));
+    if (!out)
+    {
+        std::println(std::cerr, "can't write snapshot to {}", path);
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::vector<std::byte>> fetch_snapshot(const std::string& source, const std::stop_token& stop)
+{
+    if (source.starts_with(tcp_scheme))
+    {
+        return fetch_tcp(std::string_view{source}.substr(tcp_scheme.size()), stop);
+    }
+    return fetch_file(source);
+}
+
+std::optional<SnapshotInfo> load_snapshot(std::span<const std::byte> snapshot, book::Market& market)
+{
+    std::size_t pos{0};
+    if (snapshot.size() < snapshot_header_size)
+    {
+        std::println(std::cerr, "snapshot is truncated");
+        return std::nullopt;
+    }
+    const SnapshotHeader header{.magic = util::extract<std::array<char, 8>>(snapshot, pos),
+                                .sequence = util::extract_be<std::uint64_t>(snapshot, pos),
+                                .locate_count = util::extract_be<std::uint64_t>(snapshot, pos),
+                                .order_count = util::extract_be<std::uint64_t>(snapshot, pos),
+                                .session = util::extract<feed::Session>(snapshot, pos)};
+    if (header.magic != snapshot_magic)
+    {
+        std::println(std::cerr, "not a snapshot this build can read");
+        return std::nullopt;
+    }
+
+    for (std::uint64_t i = 0; i < header.locate_count; ++i)
+    {
+        if (snapshot.size() - pos < locate_orders_size)
+        {
+            std::println(std::cerr, "snapshot is truncated");
+            return std::nullopt;
+        }
+        const LocateOrders locate{.order_count = util::extract_be<std::uint64_t>(snapshot, pos),
+                                  .locate = util::extract_be<std::uint16_t>(snapshot, pos),
+                                  .symbol = util::extract<itch::Symbol>(snapshot, pos),
+                                  .ladder = {.tick = util::extract_be<std::uint32_t>(snapshot, pos),
+                                             .ticks = util::extract_be<std::uint32_t>(snapshot, pos)}};
+        if (locate.locate == std::numeric_limits<std::uint16_t>::max())
+        {
+            std::println(std::cerr, "snapshot locate {} out of range", locate.locate);
+            return std::nullopt;
+        }
+        if (locate.order_count > (snapshot.size() - pos) / saved_order_size)
+        {
+            std::println(std::cerr, "snapshot is truncated");
+            return std::nullopt;
+        }
+
+        // the ladder first, as the directory would have laid it out before any order arrived
+        if (locate.symbol != itch::Symbol{})
+        {
+            if (locate.ladder.ticks != 0)
+            {
+                market.select_ladder(locate.symbol, locate.ladder);
+            }
+            market.name_locate(locate.locate, locate.symbol);
+        }
+
+        auto& book{market.get_book(locate.locate)};
+        for (std::uint64_t j = 0; j < locate.order_count; ++j)
+        {
+            const replay::SavedOrder order{.ref_num = util::extract_be<std::uint64_t>(snapshot, pos),
+                                           .shares = util::extract_be<std::uint32_t>(snapshot, pos),
+                                           .price_side = util::extract_be<std::uint32_t>(snapshot, pos)};
+            const book::Order saved{.shares = order.shares, .price_side = order.price_side};
+            book.add(order.ref_num, order.shares, saved.price(), saved.side());
+        }
+        market.refresh_top(locate.locate);
+    }
+
+    return SnapshotInfo{.session = header.session,
+                        .sequence = header.sequence,
+                        .locates = header.locate_count,
+                        .orders = header.order_count};
+}
+
+}
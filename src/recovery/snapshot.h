@@ -0,0 +1,72 @@
+#ifndef RECOVERY_SNAPSHOT_H_
+#define RECOVERY_SNAPSHOT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "../book/market.h"
+#include "../feed/decoder.h"
+#include "../replay/checkpoint.h"
+
+namespace recovery
+{
+
+inline constexpr std::array<char, 8> snapshot_magic{'L', '3', 'S', 'N', 'A', 'P', '0', '3'};
+
+// wire and file layout: header, then per locate the directory named or holding orders a LocateOrders
+// and its orders in time priority.
+// every field goes out on its own, integers big-endian, so no padding or host layout reaches the bytes
+struct SnapshotHeader
+{
+    std::array<char, 8> magic;
+    // MoldUDP64 sequence of the first message the books do not reflect
+    std::uint64_t sequence;
+    std::uint64_t locate_count;
+    std::uint64_t order_count;
+    feed::Session session;
+};
+
+struct LocateOrders
+{
+    std::uint64_t order_count;
+    std::uint16_t locate;
+    // all zeros until the directory names the locate
+    itch::Symbol symbol;
+    // the book's, so a load lays out the same ladder before the orders go in
+    book::LadderProfile ladder;
+};
+
+// encoded sizes, an order as replay::SavedOrder's ref_num, shares, price_side
+inline constexpr std::size_t snapshot_header_size{sizeof(snapshot_magic) + 3 * sizeof(std::uint64_t) + sizeof(feed::Session)};
+inline constexpr std::size_t locate_orders_size{sizeof(std::uint64_t) + sizeof(std::uint16_t) + sizeof(itch::Symbol) + 2 * sizeof(std::uint32_t)};
+inline constexpr std::size_t saved_order_size{sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t)};
+
+// what a load put in the market
+struct SnapshotInfo
+{
+    feed::Session session;
+    std::uint64_t sequence;
+    std::uint64_t locates;
+    std::uint64_t orders;
+};
+
+// every resting order of the market's books as of sequence
+std::vector<std::byte> encode_snapshot(const book::Market& market, const feed::Session& session, std::uint64_t sequence);
+bool write_snapshot(std::span<const std::byte> snapshot, const std::string& path);
+
+// a path, or tcp://<ipv4>:<port> for a server that sends one snapshot and closes; a tcp fetch
+// gives up within 100ms of a stop, or after 10s without a byte from the server
+std::optional<std::vector<std::byte>> fetch_snapshot(const std::string& source, const std::stop_token& stop = {});
+
+// into books that hold nothing yet, nullopt if the bytes are not a whole snapshot
+std::optional<SnapshotInfo> load_snapshot(std::span<const std::byte> snapshot, book::Market& market);
+
+}
+
+#endif
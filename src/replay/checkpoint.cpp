@@ -0,0 +1,285 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <print>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../fd/fd.h"
+#include "../itch/parser.h"
+#include "replay.h"
+
+namespace
+{
+
+constexpr std::size_t locate_count{std::numeric_limits<std::uint16_t>::max() + 1UL};
+
+constexpr std::size_t header_bytes{sizeof(replay::CheckpointHeader) + locate_count * sizeof(replay::CheckpointRange)};
+
+std::size_t sidecar_bytes(std::uint64_t checkpoints, std::uint64_t orders)
+{
+    return header_bytes + checkpoints * sizeof(replay::Checkpoint) + orders * sizeof(replay::SavedOrder);
+}
+
+bool write_at(int fd, std::span<const std::byte> bytes, std::uint64_t offset)
+{
+    while (!bytes.empty())
+    {
+        const auto written{::pwrite(fd, bytes.data(), bytes.size(), static_cast<off_t>(offset))};
+        if (written < 0)
+        {
+            std::perror("write checkpoints");
+            return false;
+        }
+        bytes = bytes.subspan(static_cast<std::size_t>(written));
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+// the sidecar past the ranges, grown by every worker: a write claims its room at the end first
+struct Tail
+{
+    int fd;
+    std::atomic<std::uint64_t> end{header_bytes};
+
+    // where bytes went, nullopt if the write failed
+    std::optional<std::uint64_t> append(std::span<const std::byte> bytes)
+    {
+        const auto offset{end.fetch_add(bytes.size(), std::memory_order_relaxed)};
+        return write_at(fd, bytes, offset) ? std::optional{offset} : std::nullopt;
+    }
+};
+
+// checkpoints of one locate, each one's orders already in the file
+struct LocateCheckpoints
+{
+    std::vector<replay::Checkpoint> checkpoints;
+    std::uint64_t order_count{0};
+    // one checkpoint's orders on their way out, reused
+    std::vector<std::pair<std::uint32_t, replay::SavedOrder>> resting;
+    std::vector<replay::SavedOrder> orders;
+};
+
+// orders go out in time priority so a restore rebuilds the same queues
+bool save(LocateCheckpoints& out, Tail& tail, const book::Book& book, std::uint64_t time_ns, std::uint64_t position)
+{
+    out.resting.clear();
+    book.for_each_order([&](std::uint64_t ref_num, const book::QueuedOrder& order) {
+        out.resting.emplace_back(order.seq,
+                                 replay::SavedOrder{.ref_num = ref_num,
+                                                    .shares = order.shares,
+                                                    .price_side = order.price_side});
+    });
+    std::ranges::sort(out.resting, {}, &std::pair<std::uint32_t, replay::SavedOrder>::first);
+    out.orders.clear();
+    for (const auto& [seq, order] : out.resting)
+    {
+        out.orders.push_back(order);
+    }
+
+    const auto offset{tail.append(std::as_bytes(std::span{out.orders}))};
+    if (!offset)
+    {
+        return false;
+    }
+    out.checkpoints.push_back(replay::Checkpoint{.time_ns = time_ns,
+                                                 .position = position,
+                                                 .orders_offset = *offset,
+                                                 .order_count = out.orders.size()});
+    out.order_count += out.orders.size();
+    return true;
+}
+
+// nullopt if a write failed
+std::optional<LocateCheckpoints> checkpoint_locate(const replay::Index& index, Tail& tail, std::uint16_t locate, std::uint64_t interval_ns)
+{
+    LocateCheckpoints out{};
+    book::Book book{};
+    std::uint64_t boundary{interval_ns};
+    std::uint64_t position{0};
+
+    for (const auto offset : index.offsets(locate))
+    {
+        const auto [type, body]{replay::message_at(index.archive(), offset)};
+        const auto timestamp{itch::parse_message_header(body).timestamp};
+        // one per interval with messages, an idle stretch just leaves the previous one in force
+        if (timestamp >= boundary)
+        {
+            if (!save(out, tail, book, boundary, position))
+            {
+                return std::nullopt;
+            }
+            boundary = (timestamp / interval_ns + 1) * interval_ns;
+        }
+        replay::apply(book, type, body);
+        ++position;
+    }
+    return out;
+}
+
+}
+
+namespace replay
+{
+
+std::string checkpoint_path(const std::string& archive_path)
+{
+    return archive_path + ".ckpt";
+}
+
+std::optional<CheckpointSummary> build_checkpoints(const Index& index, const std::string& path, std::uint64_t interval_ns, std::size_t threads)
+{
+    interval_ns = std::max<std::uint64_t>(interval_ns, 1);
+    threads = std::max<std::size_t>(threads, 1);
+
+    const int fd{::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+    if (fd < 0)
+    {
+        std::perror("open checkpoints");
+        return std::nullopt;
+    }
+    const FD sidecar{fd};
+
+    // locates handed out one at a time, a few hot symbols dominate the work; a checkpoint's orders go
+    // to the end of the file as it is taken, the locate's checkpoints once it is done
+    std::vector<CheckpointRange> ranges(locate_count, CheckpointRange{.offset = 0, .count = 0});
+    Tail tail{.fd = sidecar.fd()};
+    std::atomic<std::uint64_t> checkpoint_count{0};
+    std::atomic<std::uint64_t> order_count{0};
+    std::atomic<bool> ok{true};
+    std::atomic<std::size_t> next{0};
+    {
+        std::vector<std::jthread> workers{};
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([&] {
+                for (auto locate{next.fetch_add(1, std::memory_order_relaxed)}; locate < locate_count;
+                     locate = next.fetch_add(1, std::memory_order_relaxed))
+                {
+                    const auto built{checkpoint_locate(index, tail, static_cast<std::uint16_t>(locate), interval_ns)};
+                    if (!built)
+                    {
+                        ok.store(false, std::memory_order_relaxed);
+                        continue;
+                    }
+                    if (built->checkpoints.empty())
+                    {
+                        continue;
+                    }
+                    const auto offset{tail.append(std::as_bytes(std::span{built->checkpoints}))};
+                    if (!offset)
+                    {
+                        ok.store(false, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    ranges[locate] = CheckpointRange{.offset = *offset, .count = built->checkpoints.size()};
+                    checkpoint_count.fetch_add(built->checkpoints.size(), std::memory_order_relaxed);
+                    order_count.fetch_add(built->order_count, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    const CheckpointSummary summary{.checkpoints = checkpoint_count.load(), .orders = order_count.load(), .bytes = tail.end.load()};
+    if (!ok.load() || !write_at(sidecar.fd(), std::as_bytes(std::span{ranges}), sizeof(CheckpointHeader)))
+    {
+        return std::nullopt;
+    }
+
+    // header last, a torn build never carries the magic
+    const CheckpointHeader header{.magic = checkpoint_magic,
+                                  .archive_size = index.archive().size(),
+                                  .interval_ns = interval_ns,
+                                  .checkpoint_count = summary.checkpoints,
+                                  .order_count = summary.orders};
+    if (!write_at(sidecar.fd(), std::as_bytes(std::span{&header, 1}), 0))
+    {
+        return std::nullopt;
+    }
+    return summary;
+}
+
+std::optional<Checkpoints> Checkpoints::open(const Index& index, const std::string& archive_path)
+{
+    const auto path{checkpoint_path(archive_path)};
+    auto sidecar{MappedFile::open(path, Access::Random)};
+    if (!sidecar)
+    {
+        return std::nullopt;
+    }
+
+    const auto bytes{sidecar->bytes()};
+    CheckpointHeader header{};
+    if (bytes.size() >= header_bytes)
+    {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+    if (header.magic != checkpoint_magic || header.archive_size != index.archive().size() ||
+        bytes.size() != sidecar_bytes(header.checkpoint_count, header.order_count))
+    {
+        std::println(std::cerr, "{} does not checkpoint {}", path, archive_path);
+        return std::nullopt;
+    }
+
+    return Checkpoints{std::move(*sidecar)};
+}
+
+Checkpoints::Checkpoints(MappedFile sidecar)
+    : sidecar_{std::move(sidecar)}
+{
+    locates_ = {reinterpret_cast<const CheckpointRange*>(sidecar_.bytes().data() + sizeof(CheckpointHeader)), locate_count};
+}
+
+const Checkpoint* Checkpoints::nearest(std::uint16_t locate, std::uint64_t at_ns) const
+{
+    const auto& range{locates_[locate]};
+    const std::span checkpoints{reinterpret_cast<const Checkpoint*>(sidecar_.bytes().data() + range.offset), range.count};
+    const auto after{std::ranges::upper_bound(checkpoints, at_ns, {}, &Checkpoint::time_ns)};
+    return after == checkpoints.begin() ? nullptr : &*(after - 1);
+}
+
+std::span<const SavedOrder> Checkpoints::orders(const Checkpoint& checkpoint) const
+{
+    return {reinterpret_cast<const SavedOrder*>(sidecar_.bytes().data() + checkpoint.orders_offset), checkpoint.order_count};
+}
+
+book::Book book_at(const Index& index, const Checkpoints& checkpoints, std::uint16_t locate, std::uint64_t at_ns)
+{
+    book::Book book{};
+    std::size_t position{0};
+
+    if (const auto* checkpoint{checkpoints.nearest(locate, at_ns)})
+    {
+        for (const auto& order : checkpoints.orders(*checkpoint))
+        {
+            const book::Order saved{.shares = order.shares, .price_side = order.price_side};
+            book.add(order.ref_num, order.shares, saved.price(), saved.side());
+        }
+        position = checkpoint->position;
+    }
+
+    // range from 0 ends at the first message stamped after at_ns
+    const auto offsets{index.offsets(locate)};
+    const auto end{index.range(locate, 0, at_ns).size()};
+    for (const auto offset : offsets.subspan(position, end - std::min(end, position)))
+    {
+        const auto [type, body]{message_at(index.archive(), offset)};
+        apply(book, type, body);
+    }
+    return book;
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef REPLAY_CHECKPOINT_H_
+#define REPLAY_CHECKPOINT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "../book/book.h"
+#include "index.h"
+#include "mapped_file.h"
+
+namespace replay
+{
+
+inline constexpr std::array<char, 8> checkpoint_magic{'L', '3', 'C', 'K', 'P', 'T', '0', '2'};
+
+// sidecar layout: header, one CheckpointRange per locate, then blocks in the order they were written:
+// a checkpoint's orders as soon as it is taken, a locate's checkpoints once it is done
+struct alignas(64) CheckpointHeader
+{
+    std::array<char, 8> magic;
+    std::uint64_t archive_size;
+    std::uint64_t interval_ns;
+    std::uint64_t checkpoint_count;
+    std::uint64_t order_count;
+};
+
+struct CheckpointRange
+{
+    // byte offset of the locate's checkpoints
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+// book state after the locate's messages stamped before time_ns, position of them
+struct Checkpoint
+{
+    std::uint64_t time_ns;
+    std::uint64_t position;
+    // byte offset of its first order
+    std::uint64_t orders_offset;
+    std::uint64_t order_count;
+};
+
+// side in the top bit of price, itch prices stay below 2^31; stored in time priority
+struct SavedOrder
+{
+    std::uint64_t ref_num;
+    std::uint32_t shares;
+    // packed as book::Order packs it
+    std::uint32_t price_side;
+};
+
+// <archive>.ckpt
+std::string checkpoint_path(const std::string& archive_path);
+
+struct CheckpointSummary
+{
+    std::uint64_t checkpoints;
+    std::uint64_t orders;
+    std::size_t bytes;
+};
+
+// replays each locate through the index on threads workers, one checkpoint per interval it has messages in;
+// a checkpoint's orders are written as it is taken, a worker holds only its locate's checkpoints
+std::optional<CheckpointSummary> build_checkpoints(const Index& index, const std::string& path, std::uint64_t interval_ns, std::size_t threads);
+
+class Checkpoints
+{
+  public:
+    // nullopt if the sidecar is missing, torn, or was built for another archive than index's
+    static std::optional<Checkpoints> open(const Index& index, const std::string& archive_path);
+
+    // latest checkpoint for the locate at or before at_ns
+    [[nodiscard]]
+    const Checkpoint* nearest(std::uint16_t locate, std::uint64_t at_ns) const;
+
+    [[nodiscard]]
+    std::span<const SavedOrder> orders(const Checkpoint& checkpoint) const;
+
+  private:
+    explicit Checkpoints(MappedFile sidecar);
+
+    MappedFile sidecar_;
+    std::span<const CheckpointRange> locates_;
+};
+
+// the locate's book with every message stamped at or before at_ns applied
+book::Book book_at(const Index& index, const Checkpoints& checkpoints, std::uint16_t locate, std::uint64_t at_ns);
+
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <print>
+#include <vector>
+
+#include "../itch/parser.h"
+
+namespace
+{
+
+constexpr std::size_t locate_count{std::numeric_limits<std::uint16_t>::max() + 1UL};
+
+constexpr std::size_t header_bytes{sizeof(replay::IndexHeader) + locate_count * sizeof(replay::LocateRange)};
+
+std::size_t sidecar_bytes(std::uint64_t messages, std::uint64_t marks)
+{
+    return header_bytes + (messages + marks) * sizeof(std::uint64_t);
+}
+
+std::uint64_t mark_count(std::uint64_t messages, std::uint32_t stride)
+{
+    return (messages + stride - 1) / stride;
+}
+
+// messages shorter than the common header have no locate to file them under
+template <typename Fn>
+void for_each_indexed(std::span<const std::byte> archive, Fn&& fn)
+{
+    replay::for_each_message(archive, [&](std::uint64_t offset, itch::MessageType, std::span<const std::byte> body) {
+        if (body.size() >= itch::message_header_size)
+        {
+            fn(offset, itch::parse_message_header(body));
+        }
+    });
+}
+
+}
+
+namespace replay
+{
+
+std::string index_path(const std::string& archive_path)
+{
+    return archive_path + ".idx";
+}
+
+std::optional<IndexSummary> build_index(std::span<const std::byte> archive, const std::string& path, std::uint32_t stride)
+{
+    stride = std::max<std::uint32_t>(stride, 1);
+
+    std::vector<LocateRange> locates(locate_count, LocateRange{.first = 0, .count = 0, .first_mark = 0});
+    for_each_indexed(archive, [&](std::uint64_t, const itch::MessageHeader& header) { ++locates[header.stock_locate].count; });
+
+    IndexSummary summary{};
+    std::uint64_t marks{0};
+    for (auto& range : locates)
+    {
+        range.first = summary.messages;
+        range.first_mark = marks;
+        summary.messages += range.count;
+        marks += mark_count(range.count, stride);
+        summary.locates += range.count != 0 ? 1 : 0;
+    }
+    summary.bytes = sidecar_bytes(summary.messages, marks);
+
+    auto sidecar{MappedFile::create(path, summary.bytes)};
+    if (!sidecar)
+    {
+        return std::nullopt;
+    }
+    auto* map{sidecar->writable().data()};
+
+    std::memcpy(map + sizeof(IndexHeader), locates.data(), locates.size() * sizeof(LocateRange));
+    auto* offsets{reinterpret_cast<std::uint64_t*>(map + header_bytes)};
+    auto* mark_stamps{offsets + summary.messages};
+
+    // reuse count as the fill cursor
+    for (auto& range : locates)
+    {
+        range.count = 0;
+    }
+    for_each_indexed(archive, [&](std::uint64_t offset, const itch::MessageHeader& header) {
+        auto& range{locates[header.stock_locate]};
+        if (range.count % stride == 0)
+        {
+            mark_stamps[range.first_mark + range.count / stride] = header.timestamp;
+        }
+        offsets[range.first + range.count++] = offset;
+    });
+
+    // header last, a torn build never carries the magic
+    const IndexHeader header{.magic = index_magic,
+                             .archive_size = archive.size(),
+                             .message_count = summary.messages,
+                             .mark_count = marks,
+                             .stride = stride};
+    std::memcpy(map, &header, sizeof(header));
+
+    return summary;
+}
+
+std::optional<Index> Index::open(const std::string& archive_path)
+{
+    auto archive{MappedFile::open(archive_path, Access::Random)};
+    if (!archive)
+    {
+        return std::nullopt;
+    }
+    const auto path{index_path(archive_path)};
+    auto sidecar{MappedFile::open(path, Access::Random)};
+    if (!sidecar)
+    {
+        return std::nullopt;
+    }
+
+    const auto bytes{sidecar->bytes()};
+    IndexHeader header{};
+    if (bytes.size() >= header_bytes)
+    {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+    if (header.magic != index_magic || header.archive_size != archive->bytes().size() ||
+        bytes.size() != sidecar_bytes(header.message_count, header.mark_count) || header.stride == 0)
+    {
+        std::println(std::cerr, "{} does not index {}", path, archive_path);
+        return std::nullopt;
+    }
+
+    return Index{std::move(*archive), std::move(*sidecar)};
+}
+
+Index::Index(MappedFile archive, MappedFile sidecar)
+    : archive_{std::move(archive)},
+      sidecar_{std::move(sidecar)}
+{
+    const auto* map{sidecar_.bytes().data()};
+    header_ = reinterpret_cast<const IndexHeader*>(map);
+    locates_ = {reinterpret_cast<const LocateRange*>(map + sizeof(IndexHeader)), locate_count};
+    offsets_ = {reinterpret_cast<const std::uint64_t*>(map + header_bytes), header_->message_count};
+    marks_ = {offsets_.data() + offsets_.size(), header_->mark_count};
+}
+
+std::span<const std::byte> Index::archive() const noexcept
+{
+    return archive_.bytes();
+}
+
+std::span<const std::uint64_t> Index::offsets(std::uint16_t locate) const noexcept
+{
+    const auto& range{locates_[locate]};
+    return offsets_.subspan(range.first, range.count);
+}
+
+std::span<const std::uint64_t> Index::range(std::uint16_t locate, std::uint64_t from_ns, std::uint64_t to_ns) const
+{
+    const auto first{bound(locate, from_ns, false)};
+    const auto last{bound(locate, to_ns, true)};
+    if (last <= first)
+    {
+        return {};
+    }
+    return offsets(locate).subspan(first, last - first);
+}
+
+std::size_t Index::bound(std::uint16_t locate, std::uint64_t ts, bool after) const
+{
+    const auto& range{locates_[locate]};
+    const auto offsets{offsets_.subspan(range.first, range.count)};
+    const auto marks{marks_.subspan(range.first_mark, mark_count(range.count, header_->stride))};
+    const auto before{[&](std::uint64_t stamp) { return after ? stamp <= ts : stamp < ts; }};
+
+    // marks narrow it to one stride, only that block touches the archive
+    const auto mark{static_cast<std::size_t>(std::ranges::partition_point(marks, before) - marks.begin())};
+    const auto lo{mark == 0 ? 0 : (mark - 1) * header_->stride};
+    const auto hi{std::min<std::size_t>(mark * header_->stride, offsets.size())};
+    const auto block{offsets.subspan(lo, hi - lo)};
+
+    const auto it{std::ranges::partition_point(block, before, [&](std::uint64_t offset) { return timestamp_at(offset); })};
+    return lo + static_cast<std::size_t>(it - block.begin());
+}
+
+std::uint64_t Index::timestamp_at(std::uint64_t offset) const
+{
+    return itch::parse_message_header(message_at(archive(), offset).second).timestamp;
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef REPLAY_INDEX_H_
+#define REPLAY_INDEX_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "itch_file.h"
+#include "mapped_file.h"
+
+namespace replay
+{
+
+inline constexpr std::array<char, 8> index_magic{'L', '3', 'I', 'D', 'X', '0', '0', '1'};
+
+// sidecar layout: header, one LocateRange per locate, offsets grouped by locate, then marks
+struct alignas(64) IndexHeader
+{
+    std::array<char, 8> magic;
+    std::uint64_t archive_size;
+    std::uint64_t message_count;
+    std::uint64_t mark_count;
+    // marks hold the timestamp of every stride-th offset of a locate
+    std::uint32_t stride;
+};
+
+struct LocateRange
+{
+    std::uint64_t first;
+    std::uint64_t count;
+    std::uint64_t first_mark;
+};
+
+// <archive>.idx
+std::string index_path(const std::string& archive_path);
+
+struct IndexSummary
+{
+    std::uint64_t messages;
+    std::size_t locates;
+    std::size_t bytes;
+};
+
+// two scans of the archive, the second writes straight into the mapped sidecar
+std::optional<IndexSummary> build_index(std::span<const std::byte> archive, const std::string& path, std::uint32_t stride = 256);
+
+// archive plus sidecar, both mapped for random access
+class Index
+{
+  public:
+    // nullopt if the sidecar is missing, torn, or was built for a different archive
+    static std::optional<Index> open(const std::string& archive_path);
+
+    [[nodiscard]]
+    std::span<const std::byte> archive() const noexcept;
+
+    // every message for the locate, in file order
+    [[nodiscard]]
+    std::span<const std::uint64_t> offsets(std::uint16_t locate) const noexcept;
+
+    // the ones stamped within [from_ns, to_ns], ns since midnight
+    [[nodiscard]]
+    std::span<const std::uint64_t> range(std::uint16_t locate, std::uint64_t from_ns, std::uint64_t to_ns) const;
+
+    // fn(type, body) for each message in range
+    template <typename Fn>
+    void for_each(std::uint16_t locate, std::uint64_t from_ns, std::uint64_t to_ns, Fn&& fn) const
+    {
+        for (const auto offset : range(locate, from_ns, to_ns))
+        {
+            const auto [type, body]{message_at(archive(), offset)};
+            fn(type, body);
+        }
+    }
+
+  private:
+    Index(MappedFile archive, MappedFile sidecar);
+
+    // position of the first message stamped at/after ts (or strictly after, with after)
+    std::size_t bound(std::uint16_t locate, std::uint64_t ts, bool after) const;
+    std::uint64_t timestamp_at(std::uint64_t offset) const;
+
+    MappedFile archive_;
+    MappedFile sidecar_;
+    const IndexHeader* header_;
+    std::span<const LocateRange> locates_;
+    std::span<const std::uint64_t> offsets_;
+    std::span<const std::uint64_t> marks_;
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef REPLAY_ITCH_FILE_H_
+#define REPLAY_ITCH_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "../itch/types.h"
+#include "../util/binary_io.h"
+
+namespace replay
+{
+
+// NASDAQ BinaryFILE is [u16 be length][type][body] repeated
+// fn(offset of the length prefix, type, body after the type byte), stops at a truncated tail
+template <typename Fn>
+void for_each_message(std::span<const std::byte> data, Fn&& fn)
+{
+    std::size_t pos{0};
+    while (pos + 3 <= data.size())
+    {
+        const auto offset{pos};
+        const auto len{util::extract_be<std::uint16_t>(data, pos)};
+        if (len == 0 || pos + len > data.size())
+        {
+            return;
+        }
+        const auto type{static_cast<itch::MessageType>(data[pos])};
+        fn(offset, type, data.subspan(pos + 1, len - 1U));
+        pos += len;
+    }
+}
+
+// the record at offset, as for_each_message hands it out
+inline std::pair<itch::MessageType, std::span<const std::byte>> message_at(std::span<const std::byte> data, std::uint64_t offset)
+{
+    std::size_t pos{offset};
+    const auto len{util::extract_be<std::uint16_t>(data, pos)};
+    return {static_cast<itch::MessageType>(data[pos]), data.subspan(pos + 1, len - 1U)};
+}
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "mapped_file.h"
+
+#include <cstdio>
+#include <iostream>
+#include <print>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../fd/fd.h"
+
+namespace replay
+{
+
+std::optional<MappedFile> MappedFile::open(const std::string& path, Access access)
+{
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+    {
+        std::perror("open");
+        return std::nullopt;
+    }
+    const FD file{fd};
+
+    struct stat st{};
+    if (fstat(file.fd(), &st) < 0)
+    {
+        std::perror("fstat");
+        return std::nullopt;
+    }
+
+    const auto size{static_cast<std::size_t>(st.st_size)};
+    if (size == 0)
+    {
+        std::println(std::cerr, "{} is empty", path);
+        return std::nullopt;
+    }
+
+    void* ptr{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd(), 0)};
+    if (ptr == MAP_FAILED)
+    {
+        std::perror("mmap");
+        return std::nullopt;
+    }
+    madvise(ptr, size, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    return MappedFile{static_cast<std::byte*>(ptr), size};
+}
+
+std::optional<MappedFile> MappedFile::create(const std::string& path, std::size_t size)
+{
+    const int fd{::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)};
+    if (fd < 0)
+    {
+        std::perror("open");
+        return std::nullopt;
+    }
+    const FD file{fd};
+
+    if (ftruncate(file.fd(), static_cast<off_t>(size)) < 0)
+    {
+        std::perror("ftruncate");
+        return std::nullopt;
+    }
+
+    void* ptr{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd(), 0)};
+    if (ptr == MAP_FAILED)
+    {
+        std::perror("mmap");
+        return std::nullopt;
+    }
+
+    return MappedFile{static_cast<std::byte*>(ptr), size};
+}
+
+MappedFile::MappedFile(std::byte* map, std::size_t size)
+    : map_{map},
+      size_{size}
+{
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : map_{std::exchange(other.map_, nullptr)},
+      size_{std::exchange(other.size_, 0)}
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (map_ != nullptr)
+        {
+            munmap(map_, size_);
+        }
+        map_ = std::exchange(other.map_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    if (map_ != nullptr)
+    {
+        munmap(map_, size_);
+    }
+}
+
+std::span<const std::byte> MappedFile::bytes() const noexcept
+{
+    return {map_, size_};
+}
+
+std::span<std::byte> MappedFile::writable() noexcept
+{
+    return {map_, size_};
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef REPLAY_MAPPED_FILE_H_
+#define REPLAY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace replay
+{
+
+// readahead hint for the mapping
+enum class Access
+{
+    Sequential,
+    Random
+};
+
+// read-only mapping of a whole file, or a shared writable one for a file being built
+class MappedFile
+{
+  public:
+    static std::optional<MappedFile> open(const std::string& path, Access access = Access::Sequential);
+    // truncates path to size bytes
+    static std::optional<MappedFile> create(const std::string& path, std::size_t size);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    [[nodiscard]]
+    std::span<const std::byte> bytes() const noexcept;
+    // only meaningful on a created file
+    [[nodiscard]]
+    std::span<std::byte> writable() noexcept;
+
+  private:
+    MappedFile(std::byte* map, std::size_t size);
+
+    std::byte* map_;
+    std::size_t size_;
+};
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#include "../feed/handlers.h"
+#include "../itch/parser.h"
+#include "itch_file.h"
+
+namespace
+{
+
+using locate_counts = std::array<std::uint64_t, std::numeric_limits<std::uint16_t>::max() + 1UL>;
+
+// every type the book stage takes: orders, and the directory, trades and auction messages the
+// market keeps per locate; a record too short for the header has no locate to shard it by
+bool is_book_message(itch::MessageType type, std::span<const std::byte> body)
+{
+    if (body.size() < itch::message_header_size)
+    {
+        return false;
+    }
+    switch (type)
+    {
+    case itch::MessageType::StockDirectory:
+    case itch::MessageType::AddOrder:
+    case itch::MessageType::AddOrderMPID:
+    case itch::MessageType::OrderExecuted:
+    case itch::MessageType::OrderExecutedWithPrice:
+    case itch::MessageType::OrderCancel:
+    case itch::MessageType::OrderDelete:
+    case itch::MessageType::OrderReplace:
+    case itch::MessageType::Trade:
+    case itch::MessageType::CrossTrade:
+    case itch::MessageType::BrokenTrade:
+    case itch::MessageType::NOII:
+    case itch::MessageType::DirectListingPriceDiscovery:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::uint16_t locate_of(std::span<const std::byte> body)
+{
+    std::size_t pos{0};
+    return util::extract_be<std::uint16_t>(body, pos);
+}
+
+}
+
+namespace replay
+{
+
+void apply(book::Book& book, itch::MessageType type, std::span<const std::byte> body)
+{
+    feed::OrderHandler order_stage{book};
+    feed::Pipeline pipeline{order_stage};
+    feed::dispatch(type, body, pipeline);
+}
+
+void apply(book::Market& market, itch::MessageType type, std::span<const std::byte> body)
+{
+    feed::BookHandler book_stage{market};
+    feed::SignalHandler signal_stage{market};
+    feed::Pipeline pipeline{book_stage, signal_stage};
+    feed::dispatch(type, body, pipeline);
+}
+
+std::vector<Shard> partition(std::span<const std::byte> data, std::size_t shard_count)
+{
+    shard_count = std::max<std::size_t>(shard_count, 1);
+
+    auto counts{std::make_unique<locate_counts>()};
+    for_each_message(data, [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+        if (is_book_message(type, body))
+        {
+            ++(*counts)[locate_of(body)];
+        }
+    });
+
+    std::vector<std::uint16_t> active{};
+    for (std::size_t locate = 0; locate < counts->size(); ++locate)
+    {
+        if ((*counts)[locate] != 0)
+        {
+            active.push_back(static_cast<std::uint16_t>(locate));
+        }
+    }
+    std::ranges::stable_sort(active, std::greater<>{}, [&](std::uint16_t locate) { return (*counts)[locate]; });
+
+    std::vector<Shard> shards(shard_count);
+    std::vector<std::uint64_t> load(shard_count, 0);
+    auto owner{std::make_unique<std::array<std::uint16_t, std::tuple_size_v<locate_counts>>>()};
+    for (const auto locate : active)
+    {
+        const auto lightest{static_cast<std::size_t>(std::ranges::min_element(load) - load.begin())};
+        shards[lightest].locates.push_back(locate);
+        load[lightest] += (*counts)[locate];
+        (*owner)[locate] = static_cast<std::uint16_t>(lightest);
+    }
+
+    for (std::size_t i = 0; i < shard_count; ++i)
+    {
+        shards[i].offsets.reserve(load[i]);
+    }
+    for_each_message(data, [&](std::uint64_t offset, itch::MessageType type, std::span<const std::byte> body) {
+        if (is_book_message(type, body))
+        {
+            shards[(*owner)[locate_of(body)]].offsets.push_back(offset);
+        }
+    });
+
+    return shards;
+}
+
+void rebuild(std::span<const std::byte> data, const std::vector<Shard>& shards, book::Market& market)
+{
+    const auto replay_shard{[&](const Shard& shard) {
+        for (const auto offset : shard.offsets)
+        {
+            const auto [type, body]{message_at(data, offset)};
+            apply(market, type, body);
+        }
+    }};
+
+    if (shards.size() == 1)
+    {
+        replay_shard(shards.front());
+        return;
+    }
+
+    std::vector<std::jthread> workers{};
+    workers.reserve(shards.size());
+    for (const auto& shard : shards)
+    {
+        workers.emplace_back(replay_shard, std::cref(shard));
+    }
+}
+
+Summary run(std::span<const std::byte> data, std::size_t threads, book::Market& market)
+{
+    Summary summary{};
+
+    const auto start{std::chrono::steady_clock::now()};
+    const auto shards{partition(data, threads)};
+    const auto scanned{std::chrono::steady_clock::now()};
+    rebuild(data, shards, market);
+    const auto rebuilt{std::chrono::steady_clock::now()};
+
+    for (const auto& shard : shards)
+    {
+        summary.book_messages += shard.offsets.size();
+        summary.locates += shard.locates.size();
+    }
+    summary.scan = scanned - start;
+    summary.rebuild = rebuilt - scanned;
+    return summary;
+}
+
+}
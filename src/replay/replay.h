@@ -0,0 +1,48 @@
+#ifndef REPLAY_REPLAY_H_
+#define REPLAY_REPLAY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../book/market.h"
+#include "../itch/types.h"
+
+namespace replay
+{
+
+// one message through the live feed's book and signal stages, without journal or counters
+void apply(book::Market& market, itch::MessageType type, std::span<const std::byte> body);
+// the order messages alone, on a book standing apart from any market
+void apply(book::Book& book, itch::MessageType type, std::span<const std::byte> body);
+
+// the locates one rebuild thread owns and the messages the book stage takes for them, in file order
+struct Shard
+{
+    std::vector<std::uint16_t> locates;
+    std::vector<std::uint64_t> offsets;
+};
+
+// pass one: count book messages per locate, spread locates over shard_count shards
+// heaviest first onto the lightest shard, then collect each shard's offsets
+std::vector<Shard> partition(std::span<const std::byte> data, std::size_t shard_count);
+
+// pass two: one thread per shard applies its messages, books are disjoint so no locking
+void rebuild(std::span<const std::byte> data, const std::vector<Shard>& shards, book::Market& market);
+
+struct Summary
+{
+    std::uint64_t book_messages;
+    std::size_t locates;
+    std::chrono::nanoseconds scan;
+    std::chrono::nanoseconds rebuild;
+};
+
+// both passes, timed
+Summary run(std::span<const std::byte> data, std::size_t threads, book::Market& market);
+
+}
+
+#endif
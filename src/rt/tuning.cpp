@@ -0,0 +1,85 @@
+#include "tuning.h"
+
+#include <atomic>
+#include <csignal>
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace
+{
+
+std::atomic<bool> shutdown_flag{false};
+
+// written once at startup, before the threads that read it exist
+cpu_set_t housekeeping_cpus{};
+bool have_housekeeping_cpus{false};
+
+void on_shutdown_signal(int /*signal*/)
+{
+    shutdown_flag.store(true, std::memory_order_relaxed);
+}
+
+}
+
+namespace rt
+{
+
+bool pin_current_thread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void reserve_rx_cpus(std::span<const int> cpus)
+{
+    if (cpus.empty() || sched_getaffinity(0, sizeof(housekeeping_cpus), &housekeeping_cpus) != 0)
+    {
+        return;
+    }
+    cpu_set_t remaining{housekeeping_cpus};
+    for (const int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_CLR(cpu, &remaining);
+        }
+    }
+    // every cpu taken by a receiver: side threads keep the whole mask rather than none
+    if (CPU_COUNT(&remaining) != 0)
+    {
+        housekeeping_cpus = remaining;
+    }
+    have_housekeeping_cpus = true;
+}
+
+bool leave_rx_cpus()
+{
+    if (!have_housekeeping_cpus)
+    {
+        return true;
+    }
+    return sched_setaffinity(0, sizeof(housekeeping_cpus), &housekeeping_cpus) == 0;
+}
+
+bool lock_memory()
+{
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+}
+
+void install_shutdown_handler()
+{
+    struct sigaction action{};
+    action.sa_handler = on_shutdown_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+bool shutdown_requested() noexcept
+{
+    return shutdown_flag.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,25 @@
+#ifndef RT_TUNING_H_
+#define RT_TUNING_H_
+
+#include <span>
+
+namespace rt
+{
+
+// both return false and leave errno set when the kernel refuses
+bool pin_current_thread(int cpu);
+bool lock_memory();
+
+// housekeeping cpus: the ones the process may run on less the receivers'. call it before any thread
+// is pinned, a thread started later inherits its creator's mask, rx core and all
+void reserve_rx_cpus(std::span<const int> cpus);
+// moves the calling side thread onto the housekeeping cpus, a no-op when nothing is reserved
+bool leave_rx_cpus();
+
+// SIGINT/SIGTERM set a flag and interrupt blocking syscalls (no SA_RESTART)
+void install_shutdown_handler();
+bool shutdown_requested() noexcept;
+
+}
+
+#endif
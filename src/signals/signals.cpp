@@ -0,0 +1,76 @@
+#include "signals.h"
+
+#include <numeric>
+#include <span>
+
+namespace
+{
+
+bool two_sided(const signals::Top& top)
+{
+    return top.bid_levels != 0 && top.ask_levels != 0;
+}
+
+double depth_ratio(std::span<const book::Level> levels)
+{
+    if (levels.empty())
+    {
+        return signals::undefined;
+    }
+    const auto total{std::accumulate(levels.begin(), levels.end(), std::uint64_t{0}, [](std::uint64_t sum, const book::Level& level) {
+        return sum + level.shares;
+    })};
+    return static_cast<double>(levels.front().shares) / static_cast<double>(total);
+}
+
+}
+
+namespace signals
+{
+
+void Spread::on_top(const Top& top) noexcept
+{
+    spread = two_sided(top) ? static_cast<double>(top.asks[0].price) - static_cast<double>(top.bids[0].price) : undefined;
+}
+
+void Imbalance::on_top(const Top& top) noexcept
+{
+    if (!two_sided(top))
+    {
+        imbalance = undefined;
+        return;
+    }
+    const auto bid{static_cast<double>(top.bids[0].shares)};
+    const auto ask{static_cast<double>(top.asks[0].shares)};
+    imbalance = (bid - ask) / (bid + ask);
+}
+
+void Microprice::on_top(const Top& top) noexcept
+{
+    if (!two_sided(top))
+    {
+        microprice = undefined;
+        return;
+    }
+    const auto bid{static_cast<double>(top.bids[0].shares)};
+    const auto ask{static_cast<double>(top.asks[0].shares)};
+    microprice = (static_cast<double>(top.bids[0].price) * ask + static_cast<double>(top.asks[0].price) * bid) / (bid + ask);
+}
+
+void BidDepthRatio::on_top(const Top& top) noexcept
+{
+    ratio = depth_ratio(std::span{top.bids}.first(top.bid_levels));
+}
+
+void AskDepthRatio::on_top(const Top& top) noexcept
+{
+    ratio = depth_ratio(std::span{top.asks}.first(top.ask_levels));
+}
+
+void TradeVwap::on_trade(std::uint32_t price, std::uint32_t traded) noexcept
+{
+    notional += static_cast<double>(price) * static_cast<double>(traded);
+    shares += traded;
+}
+
+}
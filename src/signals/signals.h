@@ -0,0 +1,223 @@
+#ifndef SIGNALS_SIGNALS_H_
+#define SIGNALS_SIGNALS_H_
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "../book/book.h"
+
+namespace signals
+{
+
+inline constexpr std::size_t depth_levels{5};
+
+// best levels of a locate after a change, what top-driven signals see
+struct Top
+{
+    std::array<book::Level, depth_levels> bids;
+    std::array<book::Level, depth_levels> asks;
+    std::size_t bid_levels;
+    std::size_t ask_levels;
+};
+
+// one value per locate, fed by on_top(const Top&) after book changes and/or
+// on_trade(price, shares) for prints; NaN while undefined
+template <typename S>
+concept Signal = std::default_initializable<S> && requires(const S& signal) {
+    { S::name } -> std::convertible_to<std::string_view>;
+    { signal.value() } -> std::convertible_to<double>;
+};
+
+template <typename S>
+concept TopSignal = Signal<S> && requires(S& signal, const Top& top) { signal.on_top(top); };
+
+template <typename S>
+concept TradeSignal = Signal<S> && requires(S& signal, std::uint32_t price, std::uint32_t shares) {
+    signal.on_trade(price, shares);
+};
+
+inline constexpr double undefined{std::numeric_limits<double>::quiet_NaN()};
+
+// prices stay in itch units (1/10000 dollar)
+struct Spread
+{
+    static constexpr std::string_view name{"spread"};
+    double spread{undefined};
+
+    void on_top(const Top& top) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return spread;
+    }
+};
+
+// (bid - ask) / (bid + ask) shares at the touch, in [-1, 1]
+struct Imbalance
+{
+    static constexpr std::string_view name{"imbalance"};
+    double imbalance{undefined};
+
+    void on_top(const Top& top) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return imbalance;
+    }
+};
+
+// touch prices weighted by the opposite side's shares
+struct Microprice
+{
+    static constexpr std::string_view name{"microprice"};
+    double microprice{undefined};
+
+    void on_top(const Top& top) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return microprice;
+    }
+};
+
+// shares at the best level over shares in the best depth_levels levels
+struct BidDepthRatio
+{
+    static constexpr std::string_view name{"bid_depth_ratio"};
+    double ratio{undefined};
+
+    void on_top(const Top& top) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return ratio;
+    }
+};
+
+struct AskDepthRatio
+{
+    static constexpr std::string_view name{"ask_depth_ratio"};
+    double ratio{undefined};
+
+    void on_top(const Top& top) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return ratio;
+    }
+};
+
+// session vwap of printed executions and non-displayed trades
+struct TradeVwap
+{
+    static constexpr std::string_view name{"trade_vwap"};
+    double notional{0};
+    std::uint64_t shares{0};
+
+    void on_trade(std::uint32_t price, std::uint32_t traded) noexcept;
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return shares == 0 ? undefined : notional / static_cast<double>(shares);
+    }
+};
+
+// the set of signals is fixed at compile time, state for every locate lives in one table
+template <Signal... Signals>
+class Registry
+{
+  public:
+    static constexpr std::size_t size{sizeof...(Signals)};
+    static constexpr std::array<std::string_view, size> names{Signals::name...};
+
+    Registry()
+        : locates_(std::numeric_limits<std::uint16_t>::max() + 1UL)
+    {
+    }
+
+    // after any change to the locate's book, books without depth show only their best levels
+    template <book::DepthPolicy Policy>
+    void on_book(std::uint16_t locate, const book::BasicBook<Policy>& book)
+    {
+        if constexpr ((TopSignal<Signals> || ...))
+        {
+            Top top{};
+            if constexpr (Policy::depth)
+            {
+                top.bid_levels = book.depth(itch::Side::Buy, top.bids);
+                top.ask_levels = book.depth(itch::Side::Sell, top.asks);
+            }
+            else
+            {
+                top.bid_levels = best_into(book.best_bid(), top.bids);
+                top.ask_levels = best_into(book.best_ask(), top.asks);
+            }
+            std::apply([&](auto&... signal) { (notify_top(signal, top), ...); }, locates_[locate]);
+        }
+    }
+
+    void on_trade(std::uint16_t locate, std::uint32_t price, std::uint32_t shares)
+    {
+        std::apply([&](auto&... signal) { (notify_trade(signal, price, shares), ...); }, locates_[locate]);
+    }
+
+    template <Signal S>
+    [[nodiscard]]
+    double value(std::uint16_t locate) const
+    {
+        return std::get<S>(locates_[locate]).value();
+    }
+
+    // in the order of names
+    [[nodiscard]]
+    std::array<double, size> values(std::uint16_t locate) const
+    {
+        return std::apply([](const auto&... signal) { return std::array<double, size>{signal.value()...}; },
+                          locates_[locate]);
+    }
+
+  private:
+    static std::size_t best_into(const std::optional<book::Level>& best, std::array<book::Level, depth_levels>& out)
+    {
+        if (!best)
+        {
+            return 0;
+        }
+        out[0] = *best;
+        return 1;
+    }
+
+    template <typename S>
+    static void notify_top(S& signal, const Top& top)
+    {
+        if constexpr (TopSignal<S>)
+        {
+            signal.on_top(top);
+        }
+    }
+
+    template <typename S>
+    static void notify_trade(S& signal, std::uint32_t price, std::uint32_t shares)
+    {
+        if constexpr (TradeSignal<S>)
+        {
+            signal.on_trade(price, shares);
+        }
+    }
+
+    std::vector<std::tuple<Signals...>> locates_;
+};
+
+// what book::Market maintains when signals are on, new signals get added here
+using Stage = Registry<Spread, Imbalance, Microprice, BidDepthRatio, AskDepthRatio, TradeVwap>;
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "histogram.h"
+
+#include <cmath>
+#include <print>
+
+namespace stats
+{
+
+void Histogram::merge(const Histogram& other) noexcept
+{
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    negative_ += other.negative_;
+    max_ = std::max(max_, other.max_);
+}
+
+void Histogram::reset() noexcept
+{
+    *this = Histogram{};
+}
+
+std::uint64_t Histogram::count() const noexcept
+{
+    return count_;
+}
+
+std::uint64_t Histogram::negative() const noexcept
+{
+    return negative_;
+}
+
+std::int64_t Histogram::max() const noexcept
+{
+    return max_;
+}
+
+std::int64_t Histogram::quantile(double q) const noexcept
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+
+    const auto rank{std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count_))))};
+    std::uint64_t seen{0};
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= rank)
+        {
+            const auto upper{i + 1 < bucket_count ? bucket_lower(i + 1) - 1 : bucket_lower(i)};
+            return std::min(static_cast<std::int64_t>(upper), max_);
+        }
+    }
+    return max_;
+}
+
+void Histogram::print(std::ostream& out, std::string_view name) const
+{
+    std::println(out,
+                 "{}: count {} p50 {} p90 {} p99 {} p99.9 {} max {} negative {}",
+                 name,
+                 count_,
+                 quantile(0.5),
+                 quantile(0.9),
+                 quantile(0.99),
+                 quantile(0.999),
+                 max_,
+                 negative_);
+
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        if (counts_[i] != 0)
+        {
+            std::println(out, "  [{}, {}) {}", bucket_lower(i), i + 1 < bucket_count ? bucket_lower(i + 1) : bucket_lower(i), counts_[i]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef STATS_HISTOGRAM_H_
+#define STATS_HISTOGRAM_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace stats
+{
+
+// log-linear buckets, 16 per power of two (~6% resolution), fixed size so record never allocates
+class Histogram
+{
+  public:
+    void record(std::int64_t value) noexcept
+    {
+        if (value < 0)
+        {
+            ++negative_;
+            return;
+        }
+        ++counts_[bucket(static_cast<std::uint64_t>(value))];
+        ++count_;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const Histogram& other) noexcept;
+    void reset() noexcept;
+
+    [[nodiscard]]
+    std::uint64_t count() const noexcept;
+    [[nodiscard]]
+    std::uint64_t negative() const noexcept;
+    [[nodiscard]]
+    std::int64_t max() const noexcept;
+    // upper edge of the bucket holding the quantile, q in [0, 1]
+    [[nodiscard]]
+    std::int64_t quantile(double q) const noexcept;
+
+    // summary line then one line per non-empty bucket
+    void print(std::ostream& out, std::string_view name) const;
+
+    static constexpr int sub_bucket_bits{4};
+    static constexpr std::size_t bucket_count{(64 - sub_bucket_bits + 1) << sub_bucket_bits};
+
+    static constexpr std::size_t bucket(std::uint64_t value) noexcept
+    {
+        constexpr std::uint64_t sub_buckets{1U << sub_bucket_bits};
+        if (value < sub_buckets)
+        {
+            return value;
+        }
+        const auto shift{static_cast<std::size_t>(std::bit_width(value) - 1 - sub_bucket_bits)};
+        return ((shift + 1) << sub_bucket_bits) + static_cast<std::size_t>((value >> shift) & (sub_buckets - 1));
+    }
+
+    static constexpr std::uint64_t bucket_lower(std::size_t index) noexcept
+    {
+        constexpr std::uint64_t sub_buckets{1U << sub_bucket_bits};
+        if (index < sub_buckets)
+        {
+            return index;
+        }
+        const auto shift{(index >> sub_bucket_bits) - 1};
+        return (sub_buckets + (index & (sub_buckets - 1))) << shift;
+    }
+
+  private:
+    std::array<std::uint64_t, bucket_count> counts_{};
+    std::uint64_t count_{0};
+    std::uint64_t negative_{0};
+    std::int64_t max_{0};
+};
+
+}
+
+#endif
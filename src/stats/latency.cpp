@@ -0,0 +1,29 @@
+#include "latency.h"
+
+#include <chrono>
+
+namespace stats
+{
+
+FeedLatency::FeedLatency()
+    : zone_{std::chrono::locate_zone("America/New_York")},
+      midnight_ns_{exchange_midnight_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count())}
+{
+}
+
+void FeedLatency::print(std::ostream& out) const
+{
+    wire_to_book_.print(out, "kernel rx -> book applied (ns)");
+    feed_transit_.print(out, "exchange timestamp -> rx (ns)");
+}
+
+std::int64_t FeedLatency::exchange_midnight_ns(std::int64_t ns) const
+{
+    using namespace std::chrono;
+
+    const sys_time<nanoseconds> now{nanoseconds{ns}};
+    const auto midnight{zone_->to_sys(floor<days>(zone_->to_local(now)))};
+    return duration_cast<nanoseconds>(midnight.time_since_epoch()).count();
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef STATS_LATENCY_H_
+#define STATS_LATENCY_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "histogram.h"
+
+namespace stats
+{
+
+// all times are CLOCK_REALTIME ns since the epoch, exchange_ts is ITCH ns since midnight eastern
+class FeedLatency
+{
+  public:
+    // loads the tz database, so at startup rather than on the first packet
+    FeedLatency();
+
+    void record(std::int64_t rx_ns, std::int64_t wire_ns, std::uint64_t exchange_ts, std::int64_t applied_ns) noexcept
+    {
+        wire_to_book_.record(applied_ns - rx_ns);
+
+        if (wire_ns < midnight_ns_ || wire_ns - midnight_ns_ >= ns_per_day)
+        {
+            midnight_ns_ = exchange_midnight_ns(wire_ns);
+        }
+        feed_transit_.record(wire_ns - midnight_ns_ - static_cast<std::int64_t>(exchange_ts));
+    }
+
+    void print(std::ostream& out) const;
+
+  private:
+    static constexpr std::int64_t ns_per_day{86'400'000'000'000};
+
+    // start of the exchange day containing ns, in the same clock
+    [[nodiscard]]
+    std::int64_t exchange_midnight_ns(std::int64_t ns) const;
+
+    const std::chrono::time_zone* zone_;
+    Histogram wire_to_book_{};
+    Histogram feed_transit_{};
+    std::int64_t midnight_ns_{0};
+};
+
+}
+
+#endif
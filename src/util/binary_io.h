@@ -23,6 +23,16 @@ T extract_be(std::span<const std::byte> bytes, std::size_t& pos)
     return value;
 }
 
+// writes value in network order at pos, whatever the host's
+template <typename T>
+void store_be(std::span<std::byte> bytes, std::size_t& pos, T value)
+{
+    for (std::size_t i = sizeof(T); i-- > 0;)
+    {
+        bytes[pos++] = static_cast<std::byte>(value >> (8 * i));
+    }
+}
+
 }
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef UTIL_CACHE_H_
+#define UTIL_CACHE_H_
+
+#include <cstddef>
+
+namespace util
+{
+// std::hardware_destructive_interference_size warns when used in headers (-Winterference-size)
+inline constexpr std::size_t cache_line_size{64};
+}
+
+#endif
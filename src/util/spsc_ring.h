@@ -0,0 +1,82 @@
+#ifndef UTIL_SPSC_RING_H_
+#define UTIL_SPSC_RING_H_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <type_traits>
+
+#include "cache.h"
+
+namespace util
+{
+
+// bounded single producer / single consumer queue, never blocks either side
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(std::has_single_bit(Capacity), "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    bool try_push(const T& value) noexcept
+    {
+        const auto head{head_.load(std::memory_order_relaxed)};
+        if (head - cached_tail_ == Capacity)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == Capacity)
+            {
+                return false;
+            }
+        }
+        slots_[head & mask] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& out) noexcept
+    {
+        const auto tail{tail_.load(std::memory_order_relaxed)};
+        if (tail == cached_head_)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_)
+            {
+                return false;
+            }
+        }
+        out = slots_[tail & mask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // approximate from either side
+    [[nodiscard]]
+    std::size_t size() const noexcept
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+  private:
+    static constexpr std::size_t mask{Capacity - 1};
+
+    // producer line
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_{0};
+    // consumer line
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_{0};
+
+    alignas(cache_line_size) std::array<T, Capacity> slots_{};
+};
+
+}
+
+#endif
@@ -0,0 +1,282 @@
+#include <benchmark/benchmark.h>
+#include <archive/archive.h>
+#include <fd/fd.h>
+#include <replay/itch_file.h>
+#include <replay/mapped_file.h>
+
+#include "../unit/file_builder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// handing out every message of a day, straight from the BinaryFILE against rebuilt from the archive,
+// from memory and from a file whose pages were dropped from the cache first
+// set L3BOOK_BENCH_ITCH to a BinaryFILE to run over a real day instead of the synthetic mix
+
+namespace
+{
+
+// adds, executions, cancels, replaces and deletes over a few thousand locates, stamps climbing
+FileBuilder synthetic()
+{
+    FileBuilder file{};
+    std::mt19937_64 rng{42};
+    std::uint64_t ref{1};
+    std::uint64_t match{1};
+    std::uint64_t ns{34'200'000'000'000};
+    for (int i = 0; i < 2'000'000; ++i)
+    {
+        ns += rng() % 20'000;
+        file.set_time(ns);
+        const auto locate{static_cast<std::uint16_t>(rng() % 2 == 0 ? 1 + rng() % 8 : 9 + rng() % 2000)};
+        const auto price{static_cast<std::uint32_t>(1'000'000 + rng() % 500)};
+        const auto recent{ref - 1 - rng() % std::min<std::uint64_t>(ref, 256)};
+        const auto roll{ref < 256 ? 0 : rng() % 100};
+        if (roll < 45)
+        {
+            file.add(locate, ref++, rng() % 2 == 0 ? 'B' : 'S', 100, price);
+        }
+        else if (roll < 85)
+        {
+            file.remove(locate, recent);
+        }
+        else if (roll < 90)
+        {
+            file.cancel(locate, recent, 40);
+        }
+        else if (roll < 95)
+        {
+            file.execute_with_price(locate, recent, 100, match++, price);
+        }
+        else
+        {
+            file.replace(locate, recent, ref++, 100, price);
+        }
+    }
+    return file;
+}
+
+std::span<const std::byte> raw()
+{
+    static const auto source{[] {
+        std::vector<std::byte> bytes{};
+        if (const char* path{std::getenv("L3BOOK_BENCH_ITCH")}; path != nullptr)
+        {
+            if (const auto file{replay::MappedFile::open(path)})
+            {
+                bytes.assign(file->bytes().begin(), file->bytes().end());
+            }
+            return bytes;
+        }
+        const auto file{synthetic()};
+        bytes.assign(file.bytes().begin(), file.bytes().end());
+        return bytes;
+    }()};
+    return source;
+}
+
+// the same day as an archive, mapped once
+const std::optional<archive::Reader>& archived()
+{
+    static const auto reader{[]() -> std::optional<archive::Reader> {
+        const auto path{(std::filesystem::temp_directory_path() / "l3_bench.l3a").string()};
+        if (!archive::compress(raw(), path))
+        {
+            return std::nullopt;
+        }
+        auto mapped{replay::MappedFile::open(path)};
+        std::filesystem::remove(path);
+        return mapped ? archive::Reader::open(std::move(*mapped)) : std::nullopt;
+    }()};
+    return reader;
+}
+
+// the day and its archive written out for the cold runs, removed on exit
+class DiskCopies
+{
+  public:
+    DiskCopies()
+        : raw_path_{(std::filesystem::temp_directory_path() / "l3_bench_cold.itch").string()},
+          archive_path_{(std::filesystem::temp_directory_path() / "l3_bench_cold.l3a").string()}
+    {
+        std::ofstream file{raw_path_, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(raw().data()), static_cast<std::streamsize>(raw().size()));
+        file.close();
+        written_ = file && archive::compress(raw(), archive_path_);
+    }
+
+    DiskCopies(const DiskCopies&) = delete;
+    DiskCopies& operator=(const DiskCopies&) = delete;
+    DiskCopies(DiskCopies&&) = delete;
+    DiskCopies& operator=(DiskCopies&&) = delete;
+    ~DiskCopies()
+    {
+        std::filesystem::remove(raw_path_);
+        std::filesystem::remove(archive_path_);
+    }
+
+    [[nodiscard]]
+    bool written() const noexcept
+    {
+        return written_;
+    }
+    [[nodiscard]]
+    const std::string& raw_path() const noexcept
+    {
+        return raw_path_;
+    }
+    [[nodiscard]]
+    const std::string& archive_path() const noexcept
+    {
+        return archive_path_;
+    }
+
+  private:
+    std::string raw_path_;
+    std::string archive_path_;
+    bool written_{false};
+};
+
+const DiskCopies& disk_copies()
+{
+    static const DiskCopies copies{};
+    return copies;
+}
+
+// written back and out of the page cache, so the next read of path goes to the disk
+bool drop_cached(const std::string& path)
+{
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+    {
+        return false;
+    }
+    const FD file{fd};
+    return ::fdatasync(file.fd()) == 0 && ::posix_fadvise(file.fd(), 0, 0, POSIX_FADV_DONTNEED) == 0;
+}
+
+void BM_RawRead(benchmark::State& state)
+{
+    const auto bytes{raw()};
+    std::uint64_t messages{0};
+    for (auto _ : state)
+    {
+        replay::for_each_message(bytes, [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+            benchmark::DoNotOptimize(type);
+            benchmark::DoNotOptimize(body.data());
+            ++messages;
+        });
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(messages));
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes.size()));
+}
+
+// bytes processed counts the BinaryFILE bytes rebuilt, so the two rates compare directly
+void BM_ArchiveDecode(benchmark::State& state)
+{
+    const auto& reader{archived()};
+    if (!reader)
+    {
+        state.SkipWithError("could not build the archive");
+        return;
+    }
+    std::uint64_t messages{0};
+    for (auto _ : state)
+    {
+        reader->for_each([&](itch::MessageType type, std::span<const std::byte> body) {
+            benchmark::DoNotOptimize(type);
+            benchmark::DoNotOptimize(body.data());
+            ++messages;
+        });
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(messages));
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(reader->footer().raw_bytes));
+}
+
+// both cold ones count the BinaryFILE bytes too; the archive wins here only if reading fewer bytes
+// off the disk saves more than the decode costs
+void BM_RawReadCold(benchmark::State& state)
+{
+    const auto& copies{disk_copies()};
+    if (!copies.written())
+    {
+        state.SkipWithError("could not write the files");
+        return;
+    }
+    std::uint64_t messages{0};
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        if (!drop_cached(copies.raw_path()))
+        {
+            state.SkipWithError("could not drop the file from the page cache");
+            return;
+        }
+        state.ResumeTiming();
+        const auto file{replay::MappedFile::open(copies.raw_path())};
+        if (!file)
+        {
+            state.SkipWithError("could not map the file");
+            return;
+        }
+        replay::for_each_message(file->bytes(), [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+            benchmark::DoNotOptimize(type);
+            benchmark::DoNotOptimize(body.data());
+            ++messages;
+        });
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(messages));
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(raw().size()));
+}
+
+void BM_ArchiveDecodeCold(benchmark::State& state)
+{
+    const auto& copies{disk_copies()};
+    if (!copies.written())
+    {
+        state.SkipWithError("could not write the files");
+        return;
+    }
+    std::uint64_t messages{0};
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        if (!drop_cached(copies.archive_path()))
+        {
+            state.SkipWithError("could not drop the file from the page cache");
+            return;
+        }
+        state.ResumeTiming();
+        auto file{replay::MappedFile::open(copies.archive_path())};
+        const auto reader{file ? archive::Reader::open(std::move(*file)) : std::nullopt};
+        if (!reader)
+        {
+            state.SkipWithError("could not open the archive");
+            return;
+        }
+        reader->for_each([&](itch::MessageType type, std::span<const std::byte> body) {
+            benchmark::DoNotOptimize(type);
+            benchmark::DoNotOptimize(body.data());
+            ++messages;
+        });
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(messages));
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(raw().size()));
+}
+
+}
+
+BENCHMARK(BM_RawRead)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ArchiveDecode)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RawReadCold)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ArchiveDecodeCold)->Unit(benchmark::kMillisecond);
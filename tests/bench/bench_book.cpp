@@ -0,0 +1,198 @@
+#include <benchmark/benchmark.h>
+#include <book/book.h>
+
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+enum class OpKind
+{
+    Add,
+    Execute,
+    Cancel,
+    Delete,
+    Replace
+};
+
+struct Op
+{
+    OpKind kind;
+    std::uint64_t ref_num;
+    // replace: the new ref
+    std::uint64_t new_ref_num;
+    std::uint32_t shares;
+    std::uint32_t price;
+    itch::Side side;
+};
+
+// one busy symbol: adds cluster near the touch, most orders are cancelled, some trade
+const std::vector<Op>& stream()
+{
+    static const auto ops{[] {
+        std::vector<Op> out{};
+        std::mt19937_64 rng{42};
+        // ref and price of every resting order
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> live{};
+        std::uint64_t next_ref{1};
+        constexpr std::uint32_t mid{1'000'000};
+
+        while (out.size() < 250'000)
+        {
+            const auto roll{rng() % 100};
+            if (roll < 45 || live.size() < 64)
+            {
+                const auto side{rng() % 2 == 0 ? itch::Side::Buy : itch::Side::Sell};
+                const auto offset{100 * static_cast<std::uint32_t>(1 + std::min<std::uint64_t>(rng() % 64, rng() % 64))};
+                out.push_back({.kind = OpKind::Add,
+                               .ref_num = next_ref,
+                               .new_ref_num = 0,
+                               .shares = 100 * static_cast<std::uint32_t>(1 + rng() % 10),
+                               .price = side == itch::Side::Buy ? mid - offset : mid + offset,
+                               .side = side});
+                live.emplace_back(next_ref++, out.back().price);
+                continue;
+            }
+
+            const auto pick{rng() % live.size()};
+            const auto [ref, price]{live[pick]};
+            if (roll < 80)
+            {
+                out.push_back({.kind = OpKind::Delete, .ref_num = ref, .new_ref_num = 0, .shares = 0, .price = 0, .side = itch::Side::Buy});
+                live[pick] = live.back();
+                live.pop_back();
+            }
+            else if (roll < 88)
+            {
+                out.push_back({.kind = OpKind::Execute, .ref_num = ref, .new_ref_num = 0, .shares = 100, .price = 0, .side = itch::Side::Buy});
+            }
+            else if (roll < 94)
+            {
+                out.push_back({.kind = OpKind::Cancel, .ref_num = ref, .new_ref_num = 0, .shares = 100, .price = 0, .side = itch::Side::Buy});
+            }
+            else
+            {
+                out.push_back({.kind = OpKind::Replace,
+                               .ref_num = ref,
+                               .new_ref_num = next_ref,
+                               .shares = 100 * static_cast<std::uint32_t>(1 + rng() % 10),
+                               .price = price,
+                               .side = itch::Side::Buy});
+                live[pick].first = next_ref++;
+            }
+        }
+        return out;
+    }()};
+    return ops;
+}
+
+template <typename Policy>
+void apply(book::BasicBook<Policy>& book, const Op& op)
+{
+    switch (op.kind)
+    {
+    case OpKind::Add:
+        benchmark::DoNotOptimize(book.add(op.ref_num, op.shares, op.price, op.side));
+        break;
+    case OpKind::Execute:
+    case OpKind::Cancel:
+        benchmark::DoNotOptimize(book.reduce(op.ref_num, op.shares));
+        break;
+    case OpKind::Delete:
+        benchmark::DoNotOptimize(book.remove(op.ref_num));
+        break;
+    case OpKind::Replace: {
+        // same price, new size and time priority
+        const itch::OrderReplaceMessage msg{.header = {},
+                                            .original_order_reference_number = op.ref_num,
+                                            .new_order_reference_number = op.new_ref_num,
+                                            .shares = op.shares,
+                                            .price = op.price};
+        benchmark::DoNotOptimize(book.replace(msg));
+        break;
+    }
+    }
+}
+
+template <typename Policy>
+book::BasicBook<Policy> loaded(std::size_t ops)
+{
+    book::BasicBook<Policy> book{};
+    for (std::size_t i = 0; i < ops; ++i)
+    {
+        apply(book, stream()[i]);
+    }
+    return book;
+}
+
+// arg: dense ladder ticks, 0 keeps the levels sparse
+template <typename Policy>
+void BM_ApplyStream(benchmark::State& state)
+{
+    const auto& ops{stream()};
+    for (auto _ : state)
+    {
+        book::BasicBook<Policy> book{};
+        book.set_ladder({.tick = 100, .ticks = static_cast<std::uint32_t>(state.range(0))});
+        for (const auto& op : ops)
+        {
+            apply(book, op);
+        }
+        benchmark::DoNotOptimize(book.order_count());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(ops.size()));
+}
+
+template <typename Policy>
+void BM_BestQuote(benchmark::State& state)
+{
+    const auto book{loaded<Policy>(100'000)};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(book.best_bid());
+        benchmark::DoNotOptimize(book.best_ask());
+    }
+}
+
+template <typename Policy>
+void BM_Depth10(benchmark::State& state)
+{
+    const auto book{loaded<Policy>(100'000)};
+    std::array<book::Level, 10> out{};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(book.depth(itch::Side::Buy, out));
+        benchmark::DoNotOptimize(book.depth(itch::Side::Sell, out));
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_QueuePosition(benchmark::State& state)
+{
+    auto book{loaded<book::L3Queues>(100'000)};
+    std::vector<std::uint64_t> refs{};
+    book.for_each_order([&](std::uint64_t ref_num, const auto&) { refs.push_back(ref_num); });
+    std::size_t next{0};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(book.queue_position(refs[next]));
+        next = next + 1 == refs.size() ? 0 : next + 1;
+    }
+}
+
+}
+
+BENCHMARK_TEMPLATE(BM_ApplyStream, book::Bbo)->Arg(0)->Arg(book::liquid_ladder.ticks)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ApplyStream, book::L2)->Arg(0)->Arg(book::liquid_ladder.ticks)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ApplyStream, book::L3)->Arg(0)->Arg(book::liquid_ladder.ticks)->Unit(benchmark::kMillisecond);
+// what the queue index costs add and reduce, against L3 above
+BENCHMARK_TEMPLATE(BM_ApplyStream, book::L3Queues)->Arg(0)->Arg(book::liquid_ladder.ticks)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BestQuote, book::Bbo);
+BENCHMARK_TEMPLATE(BM_BestQuote, book::L2);
+BENCHMARK_TEMPLATE(BM_BestQuote, book::L3);
+BENCHMARK_TEMPLATE(BM_Depth10, book::L2);
+BENCHMARK_TEMPLATE(BM_Depth10, book::L3);
+BENCHMARK(BM_QueuePosition);
@@ -0,0 +1,239 @@
+#include <benchmark/benchmark.h>
+#include <book/book.h>
+#include <book/order_window.h>
+#include <itch/parser.h>
+#include <replay/itch_file.h>
+#include <replay/mapped_file.h>
+
+#include <cstdlib>
+#include <limits>
+#include <memory_resource>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// order lookup alone, the book's window against the hash map it replaced
+// set L3BOOK_BENCH_ITCH to a BinaryFILE to run over a real day instead of the synthetic mix
+
+namespace
+{
+
+enum class OpKind : std::uint8_t
+{
+    Add,
+    Reduce,
+    Delete,
+    Replace
+};
+
+struct Op
+{
+    std::uint64_t ref_num;
+    // replace: the new ref
+    std::uint64_t new_ref_num;
+    std::uint32_t shares;
+    std::uint16_t locate;
+    OpKind kind;
+};
+
+constexpr std::size_t max_ops{50'000'000};
+
+std::vector<Op> from_file(const char* path)
+{
+    std::vector<Op> out{};
+    const auto file{replay::MappedFile::open(path)};
+    if (!file)
+    {
+        return out;
+    }
+    replay::for_each_message(file->bytes(), [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+        if (out.size() == max_ops)
+        {
+            return;
+        }
+        switch (type)
+        {
+        case itch::MessageType::AddOrder: {
+            const auto msg{itch::parse_add_order_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = msg.shares, .locate = msg.header.stock_locate, .kind = OpKind::Add});
+            break;
+        }
+        case itch::MessageType::AddOrderMPID: {
+            const auto msg{itch::parse_add_order_mpid_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = msg.shares, .locate = msg.header.stock_locate, .kind = OpKind::Add});
+            break;
+        }
+        case itch::MessageType::OrderExecuted: {
+            const auto msg{itch::parse_order_executed_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = msg.executed_shares, .locate = msg.header.stock_locate, .kind = OpKind::Reduce});
+            break;
+        }
+        case itch::MessageType::OrderExecutedWithPrice: {
+            const auto msg{itch::parse_order_executed_with_price_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = msg.executed_shares, .locate = msg.header.stock_locate, .kind = OpKind::Reduce});
+            break;
+        }
+        case itch::MessageType::OrderCancel: {
+            const auto msg{itch::parse_order_cancel_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = msg.canceled_shares, .locate = msg.header.stock_locate, .kind = OpKind::Reduce});
+            break;
+        }
+        case itch::MessageType::OrderDelete: {
+            const auto msg{itch::parse_order_delete_message(body)};
+            out.push_back({.ref_num = msg.order_reference_number, .new_ref_num = 0, .shares = 0, .locate = msg.header.stock_locate, .kind = OpKind::Delete});
+            break;
+        }
+        case itch::MessageType::OrderReplace: {
+            const auto msg{itch::parse_order_replace_message(body)};
+            out.push_back({.ref_num = msg.original_order_reference_number,
+                           .new_ref_num = msg.new_order_reference_number,
+                           .shares = msg.shares,
+                           .locate = msg.header.stock_locate,
+                           .kind = OpKind::Replace});
+            break;
+        }
+        default:
+            break;
+        }
+    });
+    return out;
+}
+
+// one global ref sequence over many locates, a few busy ones; most orders die young, some rest all day
+std::vector<Op> synthetic()
+{
+    std::vector<Op> out{};
+    std::mt19937_64 rng{42};
+    std::vector<std::pair<std::uint16_t, std::uint64_t>> live{};
+    std::uint64_t next_ref{1};
+
+    while (out.size() < 2'000'000)
+    {
+        const auto roll{rng() % 100};
+        if (roll < 45 || live.size() < 64)
+        {
+            // locate 1..8 take half the flow
+            const auto locate{static_cast<std::uint16_t>(rng() % 2 == 0 ? 1 + rng() % 8 : 9 + rng() % 2000)};
+            out.push_back({.ref_num = next_ref, .new_ref_num = 0, .shares = 100, .locate = locate, .kind = OpKind::Add});
+            live.emplace_back(locate, next_ref++);
+            continue;
+        }
+
+        // the young end of live, with the occasional old order
+        const auto pick{rng() % 20 == 0 ? rng() % live.size() : live.size() - 1 - rng() % std::min<std::size_t>(live.size(), 256)};
+        const auto [locate, ref]{live[pick]};
+        if (roll < 85)
+        {
+            out.push_back({.ref_num = ref, .new_ref_num = 0, .shares = 0, .locate = locate, .kind = OpKind::Delete});
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        else if (roll < 93)
+        {
+            out.push_back({.ref_num = ref, .new_ref_num = 0, .shares = 40, .locate = locate, .kind = OpKind::Reduce});
+        }
+        else
+        {
+            out.push_back({.ref_num = ref, .new_ref_num = next_ref, .shares = 100, .locate = locate, .kind = OpKind::Replace});
+            live[pick].second = next_ref++;
+        }
+    }
+    return out;
+}
+
+const std::vector<Op>& stream()
+{
+    static const auto ops{[] {
+        const char* path{std::getenv("L3BOOK_BENCH_ITCH")};
+        return path != nullptr ? from_file(path) : synthetic();
+    }()};
+    return ops;
+}
+
+// what BasicBook held before the window
+class HashStore
+{
+  public:
+    bool insert(std::uint64_t ref_num, const book::Order& order)
+    {
+        return orders_.try_emplace(ref_num, order).second;
+    }
+
+    book::Order* find(std::uint64_t ref_num)
+    {
+        const auto it{orders_.find(ref_num)};
+        return it == orders_.end() ? nullptr : &it->second;
+    }
+
+    void erase(std::uint64_t ref_num)
+    {
+        orders_.erase(ref_num);
+    }
+
+  private:
+    std::pmr::unordered_map<std::uint64_t, book::Order> orders_;
+};
+
+template <typename Store>
+void take(Store& store, std::uint64_t ref_num, std::uint32_t shares)
+{
+    auto* const order{store.find(ref_num)};
+    if (order == nullptr)
+    {
+        return;
+    }
+    if (shares >= order->shares)
+    {
+        store.erase(ref_num);
+        return;
+    }
+    order->shares -= shares;
+}
+
+template <typename Store>
+void BM_OrderStore(benchmark::State& state)
+{
+    const auto& ops{stream()};
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<Store> stores(std::numeric_limits<std::uint16_t>::max() + 1UL);
+        state.ResumeTiming();
+
+        for (const auto& op : ops)
+        {
+            auto& store{stores[op.locate]};
+            switch (op.kind)
+            {
+            case OpKind::Add:
+                benchmark::DoNotOptimize(store.insert(op.ref_num, {.shares = op.shares, .price_side = book::pack_price(10000, itch::Side::Buy)}));
+                break;
+            case OpKind::Reduce:
+                take(store, op.ref_num, op.shares);
+                break;
+            case OpKind::Delete:
+                take(store, op.ref_num, std::numeric_limits<std::uint32_t>::max());
+                break;
+            case OpKind::Replace:
+                if (const auto* order{store.find(op.ref_num)})
+                {
+                    const auto replacement{*order};
+                    store.erase(op.ref_num);
+                    benchmark::DoNotOptimize(store.insert(op.new_ref_num, {.shares = op.shares, .price_side = replacement.price_side}));
+                }
+                break;
+            }
+        }
+
+        state.PauseTiming();
+        stores = {};
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(ops.size()));
+}
+
+}
+
+BENCHMARK_TEMPLATE(BM_OrderStore, HashStore)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_OrderStore, book::OrderWindow<book::Order>)->Unit(benchmark::kMillisecond);
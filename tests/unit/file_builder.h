@@ -0,0 +1,162 @@
+#ifndef TESTS_FILE_BUILDER_H_
+#define TESTS_FILE_BUILDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// BinaryFILE writer, just enough message types to exercise every book operation
+class FileBuilder
+{
+  public:
+    void add(std::uint16_t locate, std::uint64_t ref, char side, std::uint32_t shares, std::uint32_t price)
+    {
+        begin('A', 36, locate);
+        put(ref);
+        put(static_cast<std::uint8_t>(side));
+        put(shares);
+        put(std::uint64_t{0x2020202020202020});
+        put(price);
+    }
+
+    void execute(std::uint16_t locate, std::uint64_t ref, std::uint32_t shares)
+    {
+        begin('E', 31, locate);
+        put(ref);
+        put(shares);
+        put(std::uint64_t{0});
+    }
+
+    void cancel(std::uint16_t locate, std::uint64_t ref, std::uint32_t shares)
+    {
+        begin('X', 23, locate);
+        put(ref);
+        put(shares);
+    }
+
+    void remove(std::uint16_t locate, std::uint64_t ref)
+    {
+        begin('D', 19, locate);
+        put(ref);
+    }
+
+    void replace(std::uint16_t locate, std::uint64_t original, std::uint64_t replacement, std::uint32_t shares, std::uint32_t price)
+    {
+        begin('U', 35, locate);
+        put(original);
+        put(replacement);
+        put(shares);
+        put(price);
+    }
+
+    void set_time(std::uint64_t ns)
+    {
+        time_ = ns;
+    }
+
+    void add_mpid(std::uint16_t locate, std::uint64_t ref, char side, std::uint32_t shares, std::uint32_t price)
+    {
+        begin('F', 40, locate);
+        put(ref);
+        put(static_cast<std::uint8_t>(side));
+        put(shares);
+        put(std::uint64_t{0x4141504c20202020});
+        put(price);
+        put(std::uint32_t{0x47534d4b});
+    }
+
+    void execute_with_price(std::uint16_t locate, std::uint64_t ref, std::uint32_t shares, std::uint64_t match, std::uint32_t price)
+    {
+        begin('C', 36, locate);
+        put(ref);
+        put(shares);
+        put(match);
+        put(static_cast<std::uint8_t>('Y'));
+        put(price);
+    }
+
+    void trade(std::uint16_t locate, std::uint32_t shares, std::uint64_t match, std::uint32_t price)
+    {
+        begin('P', 44, locate);
+        put(std::uint64_t{0});
+        put(static_cast<std::uint8_t>('B'));
+        put(shares);
+        put(std::uint64_t{0x4141504c20202020});
+        put(price);
+        put(match);
+    }
+
+    void stock_directory(std::uint16_t locate, std::uint64_t symbol)
+    {
+        begin('R', 39, locate);
+        put(symbol);
+        put(static_cast<std::uint8_t>('Q'));
+        put(static_cast<std::uint8_t>('N'));
+        put(std::uint32_t{100});
+        for (const auto flag : {'N', 'C', 'C', ' ', 'P', 'N', 'N', '1', 'N'})
+        {
+            put(static_cast<std::uint8_t>(flag));
+        }
+        put(std::uint32_t{1});
+        put(static_cast<std::uint8_t>('N'));
+    }
+
+    void noii(std::uint16_t locate, std::uint64_t paired, std::uint64_t imbalance, std::uint32_t price)
+    {
+        begin('I', 50, locate);
+        put(paired);
+        put(imbalance);
+        put(static_cast<std::uint8_t>('B'));
+        put(std::uint64_t{0x4141504c20202020});
+        put(price);
+        put(price);
+        put(price);
+        put(static_cast<std::uint8_t>('O'));
+        put(static_cast<std::uint8_t>('L'));
+    }
+
+    void system_event()
+    {
+        begin('S', 12, 0);
+        put(static_cast<std::uint8_t>('O'));
+    }
+
+    [[nodiscard]]
+    std::span<const std::byte> bytes() const
+    {
+        return data_;
+    }
+
+    void truncate(std::size_t bytes)
+    {
+        data_.resize(data_.size() - bytes);
+    }
+
+  private:
+    template <typename T>
+    void put(T value)
+    {
+        for (std::size_t i = sizeof(T); i-- > 0;)
+        {
+            data_.push_back(static_cast<std::byte>(value >> (8 * i)));
+        }
+    }
+
+    void begin(char type, std::uint16_t length, std::uint16_t locate)
+    {
+        put(length);
+        put(static_cast<std::uint8_t>(type));
+        put(locate);
+        put(std::uint16_t{0});
+        for (std::size_t i = 6; i-- > 0;)
+        {
+            data_.push_back(static_cast<std::byte>(time_ >> (8 * i)));
+        }
+    }
+
+    std::vector<std::byte> data_;
+    std::uint64_t time_{0};
+};
+
+#endif
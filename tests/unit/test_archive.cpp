@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include <archive/archive.h>
+#include <itch/parser.h>
+#include <replay/itch_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "file_builder.h"
+
+namespace
+{
+
+// every encoded type plus ones that go through verbatim, refs and stamps climbing like a real day
+FileBuilder make_mixed_day()
+{
+    FileBuilder file{};
+    file.system_event();
+    std::uint64_t ref{1000};
+    std::uint64_t match{1};
+    for (std::uint32_t i = 0; i < 30000; ++i)
+    {
+        file.set_time(34'200'000'000'000 + std::uint64_t{i} * 1'234'567 / 7);
+        const auto locate{static_cast<std::uint16_t>(1 + i * 7919 % 500)};
+        switch (i % 9)
+        {
+        case 0:
+        case 1:
+            file.add(locate, ++ref, i % 2 == 0 ? 'B' : 'S', 100 * (1 + i % 5), 1'000'000 + i % 300);
+            break;
+        case 2:
+            file.add_mpid(locate, ++ref, 'S', 300, 1'000'100);
+            break;
+        case 3:
+            file.execute(locate, ref - 2, 100);
+            break;
+        case 4:
+            file.execute_with_price(locate, ref - 3, 50, ++match, 1'000'050);
+            break;
+        case 5:
+            file.cancel(locate, ref - 1, 10);
+            break;
+        case 6:
+            file.replace(locate, ref - 4, ref + 1, 200, 999'900);
+            ++ref;
+            break;
+        case 7:
+            file.trade(locate, 500, ++match, 1'000'000);
+            break;
+        default:
+            file.remove(locate, ref - 5);
+            if (i % 100 == 8)
+            {
+                file.system_event();
+            }
+            break;
+        }
+    }
+    return file;
+}
+
+struct Decoded
+{
+    std::vector<std::byte> bytes;
+    std::vector<std::uint64_t> timestamps;
+};
+
+// back to BinaryFILE framing so it compares byte for byte with the input
+Decoded decode(const archive::Reader& reader, std::size_t first_chunk = 0)
+{
+    Decoded out{};
+    reader.for_each(
+        [&](itch::MessageType type, std::span<const std::byte> body) {
+            const auto length{body.size() + 1};
+            out.bytes.push_back(static_cast<std::byte>(length >> 8));
+            out.bytes.push_back(static_cast<std::byte>(length));
+            out.bytes.push_back(static_cast<std::byte>(type));
+            out.bytes.insert(out.bytes.end(), body.begin(), body.end());
+            out.timestamps.push_back(itch::parse_message_header(body).timestamp);
+        },
+        first_chunk);
+    return out;
+}
+
+} // namespace
+
+TEST(Archive, RoundTripsByteForByte)
+{
+    const auto file{make_mixed_day()};
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test.l3a").string()};
+
+    const auto summary{archive::compress(file.bytes(), path, 4096)};
+    ASSERT_TRUE(summary);
+    EXPECT_EQ(summary->raw_bytes, file.bytes().size());
+    EXPECT_EQ(summary->chunks, (summary->messages + 4095) / 4096);
+    EXPECT_LT(summary->bytes * 2, summary->raw_bytes);
+
+    auto mapped{replay::MappedFile::open(path)};
+    ASSERT_TRUE(mapped);
+    ASSERT_TRUE(archive::Reader::is_archive(mapped->bytes()));
+    const auto reader{archive::Reader::open(std::move(*mapped))};
+    ASSERT_TRUE(reader);
+
+    const auto decoded{decode(*reader)};
+    ASSERT_EQ(decoded.bytes.size(), file.bytes().size());
+    EXPECT_TRUE(std::ranges::equal(decoded.bytes, file.bytes()));
+
+    std::filesystem::remove(path);
+}
+
+TEST(Archive, ChunkAtCoversEverythingFromATime)
+{
+    const auto file{make_mixed_day()};
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_seek.l3a").string()};
+    ASSERT_TRUE(archive::compress(file.bytes(), path, 1000));
+    auto mapped{replay::MappedFile::open(path)};
+    ASSERT_TRUE(mapped);
+    const auto reader{archive::Reader::open(std::move(*mapped))};
+    ASSERT_TRUE(reader);
+
+    const auto all{decode(*reader)};
+    EXPECT_EQ(reader->chunk_at(all.timestamps[1]), 0);
+    EXPECT_EQ(reader->chunk_at(all.timestamps.back() + 1), reader->chunk_count() - 1);
+    for (const auto at : {all.timestamps[1], all.timestamps[12345], all.timestamps.back(), all.timestamps.back() + 1})
+    {
+        const auto from{decode(*reader, reader->chunk_at(at))};
+        EXPECT_EQ(std::ranges::count_if(from.timestamps, [&](std::uint64_t ts) { return ts >= at; }),
+                  std::ranges::count_if(all.timestamps, [&](std::uint64_t ts) { return ts >= at; }));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(Archive, RejectsTornFile)
+{
+    const auto file{make_mixed_day()};
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_torn.l3a").string()};
+    ASSERT_TRUE(archive::compress(file.bytes(), path, 4096));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    auto mapped{replay::MappedFile::open(path)};
+    ASSERT_TRUE(mapped);
+    EXPECT_FALSE(archive::Reader::open(std::move(*mapped)));
+
+    std::filesystem::remove(path);
+}
+
+TEST(Archive, RejectsChunksOutsideTheirSpan)
+{
+    const auto file{make_mixed_day()};
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_directory.l3a").string()};
+    ASSERT_TRUE(archive::compress(file.bytes(), path, 4096));
+
+    // the first chunk claims to run into the directory
+    {
+        std::fstream out{path, std::ios::in | std::ios::out | std::ios::binary};
+        archive::Footer footer{};
+        out.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+        out.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+        archive::ChunkEntry entry{};
+        out.seekg(static_cast<std::streamoff>(footer.directory_offset));
+        out.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+        entry.bytes = static_cast<std::uint32_t>(footer.directory_offset);
+        out.seekp(static_cast<std::streamoff>(footer.directory_offset));
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+
+    auto mapped{replay::MappedFile::open(path)};
+    ASSERT_TRUE(mapped);
+    EXPECT_FALSE(archive::Reader::open(std::move(*mapped)));
+
+    std::filesystem::remove(path);
+}
+
+TEST(Archive, CorruptChunkStopsDecoding)
+{
+    const auto file{make_mixed_day()};
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_corrupt.l3a").string()};
+    ASSERT_TRUE(archive::compress(file.bytes(), path, 4096));
+    auto mapped{replay::MappedFile::open(path)};
+    ASSERT_TRUE(mapped);
+    const auto bytes{mapped->bytes()};
+    archive::Footer footer{};
+    std::memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+    archive::ChunkEntry entry{};
+    std::memcpy(&entry, bytes.data() + footer.directory_offset, sizeof(entry));
+    const std::vector chunk(bytes.begin() + static_cast<std::ptrdiff_t>(entry.offset), bytes.begin() + static_cast<std::ptrdiff_t>(entry.offset + entry.bytes));
+
+    itch::MessageType type{};
+    std::span<const std::byte> body{};
+    const auto count{[&](std::span<const std::byte> chunk_bytes) {
+        archive::ChunkDecoder decoder{chunk_bytes};
+        std::uint32_t messages{0};
+        while (decoder.next(type, body))
+        {
+            ++messages;
+        }
+        return messages;
+    }};
+    EXPECT_EQ(count(chunk), entry.messages);
+
+    // column sizes past the end of the chunk
+    auto oversized{chunk};
+    archive::ChunkHeader header{};
+    std::memcpy(&header, oversized.data(), sizeof(header));
+    header.column_bytes[static_cast<std::size_t>(archive::Column::Refs)] += 1;
+    std::memcpy(oversized.data(), &header, sizeof(header));
+    EXPECT_EQ(count(oversized), 0);
+    EXPECT_EQ(count(std::span{chunk}.first(sizeof(header) - 1)), 0);
+
+    // more messages than the columns hold
+    auto overcounted{chunk};
+    header.column_bytes[static_cast<std::size_t>(archive::Column::Refs)] -= 1;
+    header.messages *= 2;
+    std::memcpy(overcounted.data(), &header, sizeof(header));
+    EXPECT_EQ(count(overcounted), entry.messages);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <mem/arena.h>
+
+#include <cstdint>
+#include <fstream>
+#include <memory_resource>
+#include <unordered_map>
+
+namespace
+{
+
+constexpr std::size_t mib{1024 * 1024};
+
+bool inside(const mem::Arena& arena, const void* ptr, const void* first)
+{
+    const auto addr{reinterpret_cast<std::uintptr_t>(ptr)};
+    const auto begin{reinterpret_cast<std::uintptr_t>(first)};
+    return addr >= begin && addr < begin + arena.capacity();
+}
+
+}
+
+TEST(Arena, RoundsUpToHugePages)
+{
+    mem::Arena arena{1, mem::PageMode::Normal};
+    EXPECT_EQ(arena.capacity(), 2 * mib);
+    EXPECT_EQ(arena.mode(), mem::PageMode::Normal);
+    EXPECT_EQ(arena.used(), 0);
+}
+
+TEST(Arena, ExplicitFallsBackWithoutReservedPages)
+{
+    std::ifstream reserved_file{"/proc/sys/vm/nr_hugepages"};
+    std::size_t reserved{0};
+    reserved_file >> reserved;
+    if (reserved != 0)
+    {
+        GTEST_SKIP() << reserved << " huge pages reserved";
+    }
+
+    mem::Arena arena{4 * mib, mem::PageMode::Explicit};
+    EXPECT_NE(arena.mode(), mem::PageMode::Explicit);
+    arena.prefault();
+    auto* ptr{static_cast<std::byte*>(arena.allocate(mib, 64))};
+    ptr[mib - 1] = std::byte{1};
+    EXPECT_EQ(arena.overflow(), 0);
+}
+
+TEST(Arena, HonoursAlignment)
+{
+    mem::Arena arena{2 * mib, mem::PageMode::Normal};
+    const auto* first{arena.allocate(1, 1)};
+    for (const std::size_t alignment : {2, 8, 16, 64, 4096})
+    {
+        const auto* ptr{arena.allocate(3, alignment)};
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % alignment, 0) << alignment;
+        EXPECT_TRUE(inside(arena, ptr, first));
+    }
+    EXPECT_EQ(arena.overflow(), 0);
+}
+
+TEST(Arena, SpillsToTheHeapWhenFull)
+{
+    mem::Arena arena{2 * mib, mem::PageMode::Normal};
+    auto* first{arena.allocate(mib + mib / 2, 64)};
+    auto* spilled{arena.allocate(mib, 64)};
+    EXPECT_FALSE(inside(arena, spilled, first));
+    EXPECT_EQ(arena.overflow(), mib);
+    EXPECT_EQ(arena.used(), mib + mib / 2);
+
+    // the spill goes back to the heap, not onto the free list
+    arena.deallocate(spilled, mib, 64);
+    EXPECT_EQ(arena.free_bytes(), 0);
+}
+
+TEST(Arena, FreedBlocksAreReused)
+{
+    mem::Arena arena{2 * mib, mem::PageMode::Normal};
+    auto* a{arena.allocate(256 * 1024, 64)};
+    auto* b{arena.allocate(256 * 1024, 64)};
+    auto* c{arena.allocate(64, 64)};
+    const auto used{arena.used()};
+
+    // a and b coalesce, then a larger request than either alone fits
+    arena.deallocate(a, 256 * 1024, 64);
+    arena.deallocate(b, 256 * 1024, 64);
+    EXPECT_EQ(arena.free_bytes(), 512 * 1024);
+    EXPECT_EQ(arena.allocate(384 * 1024, 64), a);
+    EXPECT_EQ(arena.free_bytes(), 128 * 1024);
+    EXPECT_EQ(arena.used(), used);
+
+    // the top of the bump is handed back to the bump
+    arena.deallocate(c, 64, 64);
+    EXPECT_EQ(arena.used(), 384 * 1024);
+    EXPECT_EQ(arena.free_bytes(), 0);
+    EXPECT_EQ(arena.overflow(), 0);
+}
+
+TEST(Arena, TakesTheSmallestBinThatFits)
+{
+    mem::Arena arena{2 * mib, mem::PageMode::Normal};
+    // each followed by a live block so neither coalesces or goes back to the bump
+    auto* big{arena.allocate(256 * 1024, 64)};
+    static_cast<void>(arena.allocate(64, 64));
+    auto* small{arena.allocate(4096, 64)};
+    static_cast<void>(arena.allocate(64, 64));
+
+    // the big block comes first in the region but the small one is the better fit
+    arena.deallocate(big, 256 * 1024, 64);
+    arena.deallocate(small, 4096, 64);
+    EXPECT_EQ(arena.allocate(4096, 64), small);
+    EXPECT_EQ(arena.allocate(4096, 4096), big);
+    EXPECT_EQ(arena.free_bytes(), 252 * 1024);
+}
+
+TEST(Arena, RehashingUnderAPoolStaysInTheArena)
+{
+    mem::Arena arena{16 * mib, mem::PageMode::Normal};
+    {
+        std::pmr::unsynchronized_pool_resource pool{&arena};
+        // a bucket array outgrows the pool's largest block and each rehash frees the old one
+        std::pmr::unordered_map<std::uint64_t, std::uint64_t> map{&pool};
+        for (std::uint64_t i = 0; i < 200'000; ++i)
+        {
+            map.emplace(i, i);
+        }
+    }
+    EXPECT_EQ(arena.overflow(), 0);
+    EXPECT_EQ(arena.used(), 0);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <book/auction.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+itch::NOIIMessage make_noii(std::uint16_t locate,
+                            std::uint64_t timestamp,
+                            std::uint64_t imbalance,
+                            itch::ImbalanceDirection direction,
+                            std::uint32_t near_price,
+                            itch::CrossType cross = itch::CrossType::Closing)
+{
+    return {.header = {.stock_locate = locate, .tracking_number = 0, .timestamp = timestamp},
+            .paired_shares = 1000,
+            .imbalance_shares = imbalance,
+            .imbalance_direction = direction,
+            .symbol = {},
+            .far_price = near_price - 100,
+            .near_price = near_price,
+            .current_reference_price = near_price + 100,
+            .cross_type = cross,
+            .price_variation_indicator = itch::PriceVariationIndicator::LessThan1Percent};
+}
+
+} // namespace
+
+TEST(Auction, KeepsLatestIndicationAndHistory)
+{
+    book::AuctionTable table{};
+    EXPECT_EQ(table.find(9), nullptr);
+
+    for (std::uint32_t i = 0; i < 10; ++i)
+    {
+        table.on_noii(make_noii(9, 1000 + i, 500 + i, itch::ImbalanceDirection::BuyImbalance, 10000 + i));
+    }
+
+    const auto* auction{table.find(9)};
+    ASSERT_NE(auction, nullptr);
+    EXPECT_EQ(auction->imbalance_shares, 509);
+    EXPECT_EQ(auction->paired_shares, 1000);
+    EXPECT_EQ(auction->direction, itch::ImbalanceDirection::BuyImbalance);
+    EXPECT_EQ(auction->indications, 10);
+    EXPECT_EQ(auction->indication(0).near_price, 10009);
+    EXPECT_EQ(auction->indication(0).reference_price, 10109);
+    // the ring keeps the last history_size
+    EXPECT_EQ(auction->indication(book::Auction::history_size - 1).near_price, 10002);
+    EXPECT_EQ(auction->cross_price, 0);
+
+    table.on_cross_trade({.header = {.stock_locate = 9, .tracking_number = 0, .timestamp = 2000},
+                          .shares = 4000,
+                          .symbol = {},
+                          .cross_price = 10010,
+                          .match_number = 1,
+                          .type = itch::CrossType::Closing});
+    EXPECT_EQ(table.find(9)->cross_price, 10010);
+    EXPECT_EQ(table.find(9)->cross_shares, 4000);
+    EXPECT_EQ(table.size(), 1);
+}
+
+TEST(Auction, DirectListingGetsASlot)
+{
+    book::AuctionTable table{};
+    table.on_direct_listing({.header = {.stock_locate = 4, .tracking_number = 0, .timestamp = 1},
+                             .symbol = {},
+                             .open_eligibility = itch::OpenEligibility::Eligible,
+                             .min_allowed_price = 9000,
+                             .max_allowed_price = 11000,
+                             .near_execution_price = 10500,
+                             .near_execution_time = 34200000000000,
+                             .lower_price_range_collar = 9500,
+                             .upper_price_range_collar = 11500});
+
+    const auto* auction{table.find(4)};
+    ASSERT_NE(auction, nullptr);
+    EXPECT_EQ(auction->near_execution_price, 10500);
+    EXPECT_EQ(auction->open_eligibility, itch::OpenEligibility::Eligible);
+    EXPECT_EQ(auction->indications, 0);
+}
+
+TEST(Auction, ScansFilterByCrossAndSize)
+{
+    book::AuctionTable table{};
+    table.on_noii(make_noii(30, 1, 700, itch::ImbalanceDirection::SellImbalance, 10000));
+    table.on_noii(make_noii(10, 1, 300, itch::ImbalanceDirection::BuyImbalance, 10000));
+    table.on_noii(make_noii(20, 1, 900, itch::ImbalanceDirection::NoImbalance, 10000));
+    table.on_noii(make_noii(40, 1, 5000, itch::ImbalanceDirection::BuyImbalance, 10000, itch::CrossType::Opening));
+    table.on_noii(make_noii(50, 1, 700, itch::ImbalanceDirection::BuyImbalance, 10000));
+    table.on_noii(make_noii(60, 1, 100, itch::ImbalanceDirection::SellImbalance, 10000));
+
+    std::array<std::uint16_t, 8> out{};
+    ASSERT_EQ(table.imbalanced(itch::CrossType::Closing, 500, out), 2);
+    EXPECT_EQ(out[0], 30);
+    EXPECT_EQ(out[1], 50);
+    EXPECT_EQ(table.imbalanced(itch::CrossType::Closing, 0, std::span{out}.first(1)), 1);
+
+    ASSERT_EQ(table.largest_imbalances(itch::CrossType::Closing, std::span{out}.first(3)), 3);
+    // ties go to the lower locate
+    EXPECT_EQ(out[0], 30);
+    EXPECT_EQ(out[1], 50);
+    EXPECT_EQ(out[2], 10);
+
+    // a later noii moves the locate
+    table.on_noii(make_noii(10, 2, 8000, itch::ImbalanceDirection::BuyImbalance, 10000));
+    ASSERT_EQ(table.largest_imbalances(itch::CrossType::Closing, out), 4);
+    EXPECT_EQ(out[0], 10);
+    EXPECT_EQ(out[3], 60);
+}
+
+TEST(Auction, ChannelsTrackTheirLocatesConcurrently)
+{
+    // two receivers, each with its own locates, seeing them for the first time at once
+    book::AuctionTable table{};
+    {
+        std::vector<std::jthread> receivers{};
+        for (std::uint16_t channel = 0; channel < 2; ++channel)
+        {
+            receivers.emplace_back([&table, channel] {
+                for (std::uint16_t i = 0; i < 500; ++i)
+                {
+                    const auto locate{static_cast<std::uint16_t>(2 * i + channel + 1)};
+                    table.on_noii(make_noii(locate, 1, locate, itch::ImbalanceDirection::BuyImbalance, 10000));
+                    table.on_cross_trade({.header = {.stock_locate = locate, .tracking_number = 0, .timestamp = 2},
+                                          .shares = locate,
+                                          .symbol = {},
+                                          .cross_price = 10000,
+                                          .match_number = locate,
+                                          .type = itch::CrossType::Closing});
+                }
+            });
+        }
+    }
+
+    EXPECT_EQ(table.size(), 1000);
+    for (std::uint16_t locate = 1; locate <= 1000; ++locate)
+    {
+        const auto* auction{table.find(locate)};
+        ASSERT_NE(auction, nullptr);
+        EXPECT_EQ(auction->imbalance_shares, locate);
+        EXPECT_EQ(auction->cross_shares, locate);
+    }
+    std::array<std::uint16_t, 1> out{};
+    ASSERT_EQ(table.largest_imbalances(itch::CrossType::Closing, out), 1);
+    EXPECT_EQ(out[0], 1000);
+}
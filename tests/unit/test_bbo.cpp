@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <book/bbo.h>
+#include <book/market.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+void quote(book::Market& market, std::uint16_t locate, std::uint32_t bid, std::uint32_t ask, std::uint32_t shares = 100)
+{
+    auto& book{market.get_book(locate)};
+    if (bid != 0)
+    {
+        book.add(locate * 10ULL, shares, bid, itch::Side::Buy);
+    }
+    if (ask != 0)
+    {
+        book.add(locate * 10ULL + 1, shares, ask, itch::Side::Sell);
+    }
+    market.refresh_top(locate);
+}
+
+std::vector<std::uint16_t> scan(auto kernel)
+{
+    std::vector<std::uint16_t> out(1024);
+    out.resize(kernel(std::span{out}));
+    return out;
+}
+
+} // namespace
+
+TEST(Bbo, ScansFindMatchingLocates)
+{
+    auto market{std::make_unique<book::Market>()};
+    quote(*market, 1, 10000, 10100);
+    quote(*market, 2, 10000, 10000);
+    quote(*market, 17, 20000, 19900);
+    quote(*market, 33, 5000, 0);
+    quote(*market, 40, 0, 7000);
+    quote(*market, 65534, 30000, 30500);
+
+    const auto& bbo{market->bbo()};
+    EXPECT_EQ(scan([&](auto out) { return book::crossed_or_locked(bbo, out); }), (std::vector<std::uint16_t>{2, 17}));
+    EXPECT_EQ(scan([&](auto out) { return book::bids_above(bbo, 10000, out); }), (std::vector<std::uint16_t>{17, 65534}));
+    EXPECT_EQ(scan([&](auto out) { return book::spreads_at_least(bbo, 100, out); }), (std::vector<std::uint16_t>{1, 65534}));
+    EXPECT_EQ(scan([&](auto out) { return book::spreads_at_least(bbo, 101, out); }), (std::vector<std::uint16_t>{65534}));
+    EXPECT_EQ(book::resting_notional(bbo), 100ULL * (10000 + 10100 + 10000 + 10000 + 20000 + 19900 + 5000 + 7000 + 30000 + 30500));
+
+    // the top refreshes as levels go away
+    market->get_book(17).remove(171);
+    market->refresh_top(17);
+    EXPECT_TRUE(scan([&](auto out) { return book::crossed_or_locked(bbo, out); }) == std::vector<std::uint16_t>{2});
+}
+
+TEST(Bbo, WidestSpreadsMatchesSort)
+{
+    auto market{std::make_unique<book::Market>()};
+    std::vector<std::pair<std::uint32_t, std::uint16_t>> spreads{};
+    for (std::uint16_t locate = 1; locate < 3000; locate = static_cast<std::uint16_t>(locate + 3))
+    {
+        const std::uint32_t spread{(locate * 7919U) % 500 + 1};
+        quote(*market, locate, 100000, 100000 + spread);
+        spreads.emplace_back(spread, locate);
+    }
+    std::ranges::sort(spreads, [](const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+    std::vector<std::uint16_t> widest(25);
+    ASSERT_EQ(book::widest_spreads(market->bbo(), widest), widest.size());
+    for (std::size_t i = 0; i < widest.size(); ++i)
+    {
+        EXPECT_EQ(widest[i], spreads[i].second) << i;
+    }
+}
+
+TEST(Bbo, ScanStopsWhenOutputIsFull)
+{
+    auto market{std::make_unique<book::Market>()};
+    for (std::uint16_t locate = 1; locate <= 100; ++locate)
+    {
+        quote(*market, locate, 10000, 9000);
+    }
+    std::vector<std::uint16_t> out(10);
+    EXPECT_EQ(book::crossed_or_locked(market->bbo(), out), 10);
+    EXPECT_EQ(out.back(), 10);
+}
@@ -0,0 +1,508 @@
+#include <gtest/gtest.h>
+#include <book/book.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+itch::OrderReplaceMessage make_replace(std::uint64_t original, std::uint64_t replacement, std::uint32_t shares, std::uint32_t price)
+{
+    return {.header = {},
+            .original_order_reference_number = original,
+            .new_order_reference_number = replacement,
+            .shares = shares,
+            .price = price};
+}
+
+// counts what the book asks its arena for
+class CountingResource : public std::pmr::memory_resource
+{
+  public:
+    std::size_t bytes{0};
+
+  private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override
+    {
+        bytes += size;
+        return std::pmr::new_delete_resource()->allocate(size, alignment);
+    }
+    void do_deallocate(void* p, std::size_t size, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace
+
+TEST(Book, AddAggregatesLevels)
+{
+    book::Book book{};
+
+    auto change = book.add(1, 100, 10000, itch::Side::Buy);
+    ASSERT_TRUE(change);
+    EXPECT_TRUE(change->top);
+    EXPECT_EQ(change->level.shares, 100);
+    EXPECT_EQ(change->level.orders, 1);
+
+    change = book.add(2, 50, 10000, itch::Side::Buy);
+    ASSERT_TRUE(change);
+    EXPECT_EQ(change->level.shares, 150);
+    EXPECT_EQ(change->level.orders, 2);
+
+    change = book.add(3, 10, 9900, itch::Side::Buy);
+    ASSERT_TRUE(change);
+    EXPECT_FALSE(change->top);
+
+    EXPECT_FALSE(book.add(3, 10, 9900, itch::Side::Buy));
+
+    const auto bid{book.best_bid()};
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(bid->price, 10000);
+    EXPECT_EQ(bid->shares, 150);
+    EXPECT_FALSE(book.best_ask());
+}
+
+TEST(Book, BestAskIsLowest)
+{
+    book::Book book{};
+    book.add(1, 100, 10100, itch::Side::Sell);
+    const auto change{book.add(2, 100, 10050, itch::Side::Sell)};
+
+    ASSERT_TRUE(change);
+    EXPECT_TRUE(change->top);
+    EXPECT_EQ(book.best_ask()->price, 10050);
+}
+
+TEST(Book, ReduceAndRemove)
+{
+    book::Book book{};
+    book.add(1, 100, 10000, itch::Side::Buy);
+    book.add(2, 100, 9900, itch::Side::Buy);
+
+    auto change = book.reduce(1, 30);
+    ASSERT_TRUE(change);
+    EXPECT_EQ(change->shares, 30);
+    EXPECT_EQ(change->order_shares, 70);
+    EXPECT_EQ(change->level.shares, 70);
+    EXPECT_EQ(change->level.orders, 1);
+    EXPECT_TRUE(change->top);
+
+    // over-execution clamps to what is left
+    change = book.reduce(1, 500);
+    ASSERT_TRUE(change);
+    EXPECT_EQ(change->shares, 70);
+    EXPECT_EQ(change->order_shares, 0);
+    EXPECT_EQ(change->level.orders, 0);
+    EXPECT_EQ(book.best_bid()->price, 9900);
+
+    change = book.remove(2);
+    ASSERT_TRUE(change);
+    EXPECT_EQ(change->shares, 100);
+    EXPECT_FALSE(book.best_bid());
+
+    EXPECT_FALSE(book.remove(2));
+    EXPECT_FALSE(book.reduce(42, 1));
+}
+
+TEST(Book, ReplaceKeepsSide)
+{
+    book::Book book{};
+    book.add(1, 100, 10000, itch::Side::Sell);
+
+    const auto change{book.replace(make_replace(1, 2, 40, 10010))};
+    ASSERT_TRUE(change);
+    EXPECT_EQ(change->removed.level.orders, 0);
+    ASSERT_TRUE(change->added);
+    EXPECT_EQ(change->added->side, itch::Side::Sell);
+    EXPECT_EQ(change->added->level.price, 10010);
+
+    EXPECT_FALSE(book.remove(1));
+    EXPECT_EQ(book.best_ask()->shares, 40);
+    EXPECT_FALSE(book.replace(make_replace(1, 3, 1, 1)));
+}
+
+TEST(Book, OrdersPackSideIntoPrice)
+{
+    constexpr std::uint32_t highest{2'000'000'000};
+    constexpr book::Order sell{.shares = 1, .price_side = book::pack_price(highest, itch::Side::Sell)};
+    constexpr book::Order buy{.shares = 1, .price_side = book::pack_price(highest, itch::Side::Buy)};
+    static_assert(sell.price() == highest && sell.side() == itch::Side::Sell);
+    static_assert(buy.price() == highest && buy.side() == itch::Side::Buy);
+
+    book::Book book{};
+    book.add(1, 100, highest, itch::Side::Sell);
+    EXPECT_EQ(book.best_ask()->price, highest);
+    EXPECT_EQ(book.remove(1)->side, itch::Side::Sell);
+}
+
+TEST(Book, AttributionStaysWithTheOrder)
+{
+    book::Book book{};
+    const itch::MPID mpid{'G', 'S', 'C', 'O'};
+    book.add(1, 100, 10000, itch::Side::Buy, mpid);
+    book.add(2, 100, 10000, itch::Side::Buy);
+    EXPECT_EQ(book.attribution(1), mpid);
+    EXPECT_FALSE(book.attribution(2));
+
+    // partial fills keep it, a replace carries it to the new ref
+    book.reduce(1, 40);
+    EXPECT_EQ(book.attribution(1), mpid);
+    book.replace(make_replace(1, 3, 50, 10010));
+    EXPECT_FALSE(book.attribution(1));
+    EXPECT_EQ(book.attribution(3), mpid);
+
+    book.remove(3);
+    EXPECT_FALSE(book.attribution(3));
+}
+
+TEST(Book, OrderBytesFollowLiveOrders)
+{
+    book::BasicBook<book::L2> book{};
+    // an idle book allocates nothing, its empty maps each count one shared bucket
+    EXPECT_LE(book.order_bytes(), 2 * sizeof(void*));
+    for (std::uint64_t ref = 1; ref <= 10'000; ++ref)
+    {
+        book.add(ref, 100, 10000 + static_cast<std::uint32_t>(ref % 16), itch::Side::Buy);
+    }
+    // dense refs stay in the window, 8 bytes a record plus a bit, with room left to grow into
+    const auto per_order{static_cast<double>(book.order_bytes()) / static_cast<double>(book.order_count())};
+    EXPECT_GE(per_order, 8.0);
+    EXPECT_LT(per_order, 16.0);
+}
+
+TEST(Book, QueuePositionCountsOrdersAhead)
+{
+    book::BasicBook<book::L3Queues> book{};
+    book.add(1, 100, 10000, itch::Side::Buy);
+    book.add(2, 200, 10000, itch::Side::Buy);
+    book.add(3, 300, 10000, itch::Side::Buy);
+    book.add(4, 50, 10000, itch::Side::Sell);
+
+    auto position{book.queue_position(3)};
+    ASSERT_TRUE(position);
+    EXPECT_EQ(position->orders_ahead, 2);
+    EXPECT_EQ(position->shares_ahead, 300);
+    EXPECT_EQ(position->level.shares, 600);
+
+    // updates ahead move the answer
+    book.reduce(1, 40);
+    book.remove(2);
+    book.add(5, 70, 10000, itch::Side::Buy);
+    position = book.queue_position(3);
+    ASSERT_TRUE(position);
+    EXPECT_EQ(position->orders_ahead, 1);
+    EXPECT_EQ(position->shares_ahead, 60);
+
+    position = book.queue_position(5);
+    ASSERT_TRUE(position);
+    EXPECT_EQ(position->orders_ahead, 2);
+    EXPECT_EQ(position->shares_ahead, 360);
+
+    // a replace loses priority
+    book.replace(make_replace(1, 6, 60, 10000));
+    position = book.queue_position(6);
+    ASSERT_TRUE(position);
+    EXPECT_EQ(position->orders_ahead, 2);
+    EXPECT_EQ(position->shares_ahead, 370);
+
+    EXPECT_EQ(book.queue_position(4)->orders_ahead, 0);
+    EXPECT_FALSE(book.queue_position(2));
+}
+
+TEST(Book, QueuePositionMatchesBruteForce)
+{
+    struct Resting
+    {
+        std::uint64_t ref_num;
+        std::uint32_t price;
+        std::uint32_t shares;
+    };
+
+    book::BasicBook<book::L3Queues> book{};
+    std::mt19937 rng{7};
+    // live orders in arrival order, the reference answer
+    std::vector<Resting> live{};
+    std::uint64_t next_ref{1};
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        if (rng() % 4 < 2 || live.empty())
+        {
+            const Resting order{.ref_num = next_ref++,
+                                .price = 10000 + static_cast<std::uint32_t>(rng() % 4),
+                                .shares = 1 + static_cast<std::uint32_t>(rng() % 500)};
+            book.add(order.ref_num, order.shares, order.price, itch::Side::Buy);
+            live.push_back(order);
+        }
+        else
+        {
+            const auto pick{live.begin() + static_cast<std::ptrdiff_t>(rng() % live.size())};
+            const auto change{book.reduce(pick->ref_num, 1 + static_cast<std::uint32_t>(rng() % 300))};
+            ASSERT_TRUE(change);
+            pick->shares = change->order_shares;
+            if (pick->shares == 0)
+            {
+                live.erase(pick);
+            }
+        }
+
+        if (step % 97 != 0 || live.empty())
+        {
+            continue;
+        }
+        const auto target{live.begin() + static_cast<std::ptrdiff_t>(rng() % live.size())};
+        std::uint32_t orders{0};
+        std::uint64_t shares{0};
+        for (auto it = live.begin(); it != target; ++it)
+        {
+            if (it->price == target->price)
+            {
+                ++orders;
+                shares += it->shares;
+            }
+        }
+
+        const auto position{book.queue_position(target->ref_num)};
+        ASSERT_TRUE(position);
+        EXPECT_EQ(position->orders_ahead, orders);
+        EXPECT_EQ(position->shares_ahead, shares);
+    }
+}
+
+TEST(Book, QueueIndexLivesInTheBooksArena)
+{
+    CountingResource arena{};
+    CountingResource stray{};
+    auto* const previous{std::pmr::set_default_resource(&stray)};
+    {
+        book::BasicBook<book::L3Queues> book{&arena};
+        for (std::uint64_t ref = 1; ref <= 1000; ++ref)
+        {
+            book.add(ref, 100, 10000, itch::Side::Buy);
+        }
+        ASSERT_TRUE(book.queue_position(500));
+    }
+    std::pmr::set_default_resource(previous);
+
+    // a seq and two tree nodes per order, none of it from the default resource
+    EXPECT_GE(arena.bytes, 1000 * (2 * sizeof(std::uint32_t) + sizeof(std::uint64_t)));
+    EXPECT_EQ(stray.bytes, 0);
+}
+
+TEST(Book, QueuePositionNeverRebuildsFromTheBook)
+{
+    CountingResource arena{};
+    book::BasicBook<book::L3Queues> book{&arena};
+    // a deep book around the level being churned
+    std::uint64_t ref{1};
+    for (; ref <= 20000; ++ref)
+    {
+        book.add(ref, 100, 10001 + static_cast<std::uint32_t>(ref % 50), itch::Side::Buy);
+    }
+    const auto first{ref};
+    for (; ref < first + 100; ++ref)
+    {
+        book.add(ref, 100, 10000, itch::Side::Buy);
+    }
+
+    // the level turns over its queue many times, dead slots compact as the orders leave, so a
+    // query is a lookup and the other 20000 orders are never walked
+    std::size_t query_bytes{0};
+    for (std::uint64_t oldest = first; oldest < first + 5000; ++oldest)
+    {
+        book.remove(oldest);
+        book.add(ref++, 100, 10000, itch::Side::Buy);
+
+        const auto before{arena.bytes};
+        const auto position{book.queue_position(ref - 1)};
+        query_bytes += arena.bytes - before;
+        ASSERT_TRUE(position);
+        EXPECT_EQ(position->orders_ahead, 99);
+        EXPECT_EQ(position->shares_ahead, 9900);
+    }
+    EXPECT_EQ(query_bytes, 0);
+
+    // emptied and refilled, the level starts a fresh index as its first order arrives
+    for (auto live{ref - 100}; live < ref; ++live)
+    {
+        book.remove(live);
+    }
+    book.add(ref, 100, 10000, itch::Side::Buy);
+    const auto before{arena.bytes};
+    EXPECT_EQ(book.queue_position(ref)->orders_ahead, 0);
+    EXPECT_EQ(arena.bytes, before);
+}
+
+TEST(Book, DepthFollowsLevels)
+{
+    book::BasicBook<book::L3Queues> book{};
+    std::array<book::Level, 5> out{};
+    EXPECT_EQ(book.depth(itch::Side::Buy, out), 0);
+
+    book.add(1, 100, 10000, itch::Side::Buy);
+    book.add(2, 50, 10100, itch::Side::Buy);
+    book.add(3, 25, 9900, itch::Side::Buy);
+    book.add(4, 10, 10000, itch::Side::Buy);
+    book.add(5, 70, 10200, itch::Side::Sell);
+
+    ASSERT_EQ(book.depth(itch::Side::Buy, out), 3);
+    EXPECT_EQ(out[0], (book::Level{.price = 10100, .orders = 1, .shares = 50}));
+    EXPECT_EQ(out[1], (book::Level{.price = 10000, .orders = 2, .shares = 110}));
+    EXPECT_EQ(out[2], (book::Level{.price = 9900, .orders = 1, .shares = 25}));
+
+    book.remove(2);
+    book.reduce(1, 40);
+    ASSERT_EQ(book.depth(itch::Side::Buy, std::span{out}.first(1)), 1);
+    EXPECT_EQ(out[0], (book::Level{.price = 10000, .orders = 2, .shares = 70}));
+
+    ASSERT_EQ(book.depth(itch::Side::Sell, out), 1);
+    EXPECT_EQ(out[0].price, 10200);
+}
+
+TEST(Book, DepthInsertsAtTheLastSlotOfAFullCache)
+{
+    book::BasicBook<book::L3Queues> book{};
+    std::uint64_t ref{1};
+    for (std::uint32_t i = 0; i < book::max_depth; ++i)
+    {
+        book.add(ref++, 10, 10000 + 2 * i, itch::Side::Buy);
+    }
+
+    // falls between the last two cached levels, the worst one is pushed out
+    book.add(ref++, 10, 10001, itch::Side::Buy);
+
+    std::array<book::Level, book::max_depth> out{};
+    ASSERT_EQ(book.depth(itch::Side::Buy, out), book::max_depth);
+    EXPECT_EQ(out[0].price, 10000 + 2 * (book::max_depth - 1));
+    EXPECT_EQ(out[book::max_depth - 2].price, 10002);
+    EXPECT_EQ(out[book::max_depth - 1], (book::Level{.price = 10001, .orders = 1, .shares = 10}));
+
+    // the pushed out level comes back once a cached one empties
+    book.remove(ref - 1);
+    ASSERT_EQ(book.depth(itch::Side::Buy, out), book::max_depth);
+    EXPECT_EQ(out[book::max_depth - 1].price, 10000);
+}
+
+TEST(Book, DepthMatchesFullLadder)
+{
+    for (const auto side : {itch::Side::Buy, itch::Side::Sell})
+    {
+        book::BasicBook<book::L3Queues> book{};
+        std::mt19937 rng{11};
+        // ref -> (price, shares), the reference ladder is rebuilt from it on every check
+        std::map<std::uint64_t, std::pair<std::uint32_t, std::uint32_t>> live{};
+        std::uint64_t next_ref{1};
+
+        for (int step = 0; step < 10000; ++step)
+        {
+            if (rng() % 2 == 0 || live.empty())
+            {
+                // a narrow band keeps levels filling and emptying around the cached edge
+                const auto price{10000 + static_cast<std::uint32_t>(rng() % 40)};
+                const auto shares{1 + static_cast<std::uint32_t>(rng() % 100)};
+                book.add(next_ref, shares, price, side);
+                live.emplace(next_ref++, std::pair{price, shares});
+            }
+            else
+            {
+                const auto pick{std::next(live.begin(), static_cast<std::ptrdiff_t>(rng() % live.size()))};
+                const auto change{book.reduce(pick->first, 1 + static_cast<std::uint32_t>(rng() % 100))};
+                ASSERT_TRUE(change);
+                pick->second.second = change->order_shares;
+                if (change->order_shares == 0)
+                {
+                    live.erase(pick);
+                }
+            }
+
+            std::map<std::uint32_t, book::Level> ladder{};
+            for (const auto& [ref_num, order] : live)
+            {
+                auto& level{ladder.try_emplace(order.first, book::Level{.price = order.first, .orders = 0, .shares = 0})
+                                .first->second};
+                ++level.orders;
+                level.shares += order.second;
+            }
+            std::vector<book::Level> expected{};
+            for (const auto& [price, level] : ladder)
+            {
+                expected.push_back(level);
+            }
+            if (side == itch::Side::Buy)
+            {
+                std::ranges::reverse(expected);
+            }
+
+            std::array<book::Level, book::max_depth> out{};
+            const auto count{book.depth(side, out)};
+            ASSERT_EQ(count, std::min(expected.size(), book::max_depth));
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                ASSERT_EQ(out[i], expected[i]);
+            }
+        }
+    }
+}
+
+template <typename Policy>
+class PolicyBook : public testing::Test
+{
+};
+
+using Policies = testing::Types<book::Bbo, book::L2, book::L3, book::L3Queues>;
+TYPED_TEST_SUITE(PolicyBook, Policies);
+
+TYPED_TEST(PolicyBook, MatchesFullDepthBook)
+{
+    book::BasicBook<TypeParam> lean{};
+    book::Book full{};
+    std::mt19937 rng{3};
+    std::vector<std::uint64_t> live{};
+    std::uint64_t next_ref{1};
+
+    for (int step = 0; step < 5000; ++step)
+    {
+        if (rng() % 2 == 0 || live.empty())
+        {
+            const auto side{rng() % 2 == 0 ? itch::Side::Buy : itch::Side::Sell};
+            const auto price{(side == itch::Side::Buy ? 9900 : 10100) + static_cast<std::uint32_t>(rng() % 50)};
+            const auto shares{1 + static_cast<std::uint32_t>(rng() % 100)};
+            const auto change{lean.add(next_ref, shares, price, side)};
+            ASSERT_TRUE(change);
+            EXPECT_EQ(change->top, full.add(next_ref, shares, price, side)->top);
+            live.push_back(next_ref++);
+            continue;
+        }
+
+        const auto pick{live.begin() + static_cast<std::ptrdiff_t>(rng() % live.size())};
+        const auto shares{1 + static_cast<std::uint32_t>(rng() % 100)};
+        const auto change{lean.reduce(*pick, shares)};
+        const auto expected{full.reduce(*pick, shares)};
+        ASSERT_TRUE(change);
+        EXPECT_EQ(change->level, expected->level);
+        EXPECT_EQ(change->top, expected->top);
+        if (change->order_shares == 0)
+        {
+            live.erase(pick);
+        }
+        ASSERT_EQ(lean.best_bid(), full.best_bid());
+        ASSERT_EQ(lean.best_ask(), full.best_ask());
+    }
+    EXPECT_EQ(lean.order_count(), full.order_count());
+    EXPECT_EQ(lean.level_count(), full.level_count());
+}
+
+static_assert(sizeof(book::BasicBook<book::Bbo>) < sizeof(book::BasicBook<book::L2>));
+static_assert(sizeof(book::BasicBook<book::L2>) <= sizeof(book::BasicBook<book::L3>));
+static_assert(sizeof(book::BasicBook<book::L3>) < sizeof(book::BasicBook<book::L3Queues>));
+static_assert(sizeof(book::BasicBook<book::L2>::order_type) < sizeof(book::Book::order_type));
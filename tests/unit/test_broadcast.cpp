@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <broadcast/broadcast.h>
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+
+constexpr const char* ring_name{"l3_test_broadcast"};
+
+// one TradeBroken event per call, match numbers counting up from first
+void publish(broadcast::Publisher& ring, std::uint64_t first, std::uint64_t count)
+{
+    for (auto match = first; match < first + count; ++match)
+    {
+        ring.trade_broken({.stock_locate = 7, .tracking_number = 0, .timestamp = match},
+                          {.match_number = match,
+                           .price = 10000,
+                           .shares = 100,
+                           .stock_locate = 7,
+                           .side = itch::Side::Buy,
+                           .kind = book::ExecutionKind::Executed,
+                           .busted = true});
+    }
+}
+
+} // namespace
+
+TEST(Broadcast, ReadersJoinAtTheNewestEvent)
+{
+    auto ring{broadcast::Publisher::create(ring_name, 64)};
+    ASSERT_TRUE(ring);
+    publish(*ring, 0, 5);
+    ring->commit();
+
+    auto early{broadcast::Subscriber::attach(ring_name)};
+    ASSERT_TRUE(early);
+    std::array<journal::Event, 16> buffer{};
+    EXPECT_TRUE(early->poll(buffer).empty());
+    EXPECT_EQ(early->position(), 5);
+
+    publish(*ring, 5, 3);
+    // nothing visible before commit
+    EXPECT_TRUE(early->poll(buffer).empty());
+    ring->commit();
+
+    auto late{broadcast::Subscriber::attach(ring_name)};
+    ASSERT_TRUE(late);
+    publish(*ring, 8, 2);
+    ring->commit();
+
+    const auto events{early->poll(buffer)};
+    ASSERT_EQ(events.size(), 5);
+    EXPECT_EQ(events[0].sequence, 5);
+    EXPECT_EQ(events[0].type, journal::EventType::TradeBroken);
+    EXPECT_EQ(events[0].stock_locate, 7);
+    EXPECT_EQ(events[0].order.match_number, 5);
+    EXPECT_EQ(events[4].order.match_number, 9);
+
+    // each reader has its own cursor
+    const auto late_events{late->poll(std::span{buffer}.first(1))};
+    ASSERT_EQ(late_events.size(), 1);
+    EXPECT_EQ(late_events[0].order.match_number, 8);
+    EXPECT_EQ(late->poll(buffer).size(), 1);
+    EXPECT_EQ(early->lost(), 0);
+    EXPECT_EQ(late->lost(), 0);
+}
+
+TEST(Broadcast, LappedReadersSkipAhead)
+{
+    auto ring{broadcast::Publisher::create(ring_name, 16)};
+    ASSERT_TRUE(ring);
+    auto reader{broadcast::Subscriber::attach(ring_name)};
+    ASSERT_TRUE(reader);
+    std::array<journal::Event, 32> buffer{};
+
+    // more than a ring behind at the next poll, start again from the newest
+    publish(*ring, 0, 40);
+    ring->commit();
+    EXPECT_TRUE(reader->poll(buffer).empty());
+    EXPECT_EQ(reader->lost(), 40);
+    EXPECT_EQ(reader->position(), 40);
+
+    // the writer reusing slots while they are copied: the events it had claimed are dropped
+    publish(*ring, 40, 10);
+    ring->commit();
+    publish(*ring, 50, 10);
+    const auto events{reader->poll(buffer)};
+    ASSERT_EQ(events.size(), 6);
+    EXPECT_EQ(events[0].sequence, 44);
+    EXPECT_EQ(events[5].sequence, 49);
+    EXPECT_EQ(reader->lost(), 44);
+
+    ring->commit();
+    EXPECT_EQ(reader->poll(buffer).size(), 10);
+    EXPECT_EQ(reader->lost(), 44);
+}
+
+TEST(Broadcast, WriterReportsSlowReaders)
+{
+    auto ring{broadcast::Publisher::create(ring_name, 16)};
+    ASSERT_TRUE(ring);
+    EXPECT_TRUE(ring->consumers().empty());
+
+    auto reader{broadcast::Subscriber::attach(ring_name)};
+    ASSERT_TRUE(reader);
+    publish(*ring, 0, 12);
+    ring->commit();
+
+    auto consumers{ring->consumers()};
+    ASSERT_EQ(consumers.size(), 1);
+    EXPECT_EQ(consumers[0].pid, getpid());
+    EXPECT_EQ(consumers[0].behind, 12);
+    EXPECT_TRUE(consumers[0].slow);
+
+    std::array<journal::Event, 16> buffer{};
+    EXPECT_EQ(reader->poll(buffer).size(), 12);
+    consumers = ring->consumers();
+    ASSERT_EQ(consumers.size(), 1);
+    EXPECT_EQ(consumers[0].behind, 0);
+    EXPECT_FALSE(consumers[0].slow);
+
+    // a detached reader gives its cursor back
+    reader.reset();
+    EXPECT_TRUE(ring->consumers().empty());
+}
+
+TEST(Broadcast, MonitorReportsReadersAsTheyFallBehind)
+{
+    auto ring{broadcast::Publisher::create(ring_name, 16)};
+    ASSERT_TRUE(ring);
+    auto reader{broadcast::Subscriber::attach(ring_name)};
+    ASSERT_TRUE(reader);
+
+    std::ostringstream log{};
+    {
+        broadcast::ConsumerMonitor monitor{*ring, log, std::chrono::milliseconds{10}};
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        publish(*ring, 0, 12);
+        ring->commit();
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+        std::array<journal::Event, 16> buffer{};
+        EXPECT_EQ(reader->poll(buffer).size(), 12);
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    }
+
+    // once when it turned slow, once when it caught up, nothing while it stayed either
+    const auto pid{std::to_string(getpid())};
+    EXPECT_EQ(log.str(), "broadcast consumer pid " + pid + ": 12 behind, 0 lost, slow\n" + "broadcast consumer pid " + pid + ": 0 behind, 0 lost\n");
+}
+
+TEST(Broadcast, RejectsBadRings)
+{
+    EXPECT_FALSE(broadcast::Publisher::create(ring_name, 100));
+    EXPECT_FALSE(broadcast::Subscriber::attach("l3_test_broadcast_missing"));
+
+    // every cursor taken by a live process
+    auto ring{broadcast::Publisher::create(ring_name, 16)};
+    ASSERT_TRUE(ring);
+    std::vector<broadcast::Subscriber> readers{};
+    for (std::size_t i = 0; i < broadcast::max_consumers; ++i)
+    {
+        auto reader{broadcast::Subscriber::attach(ring_name)};
+        ASSERT_TRUE(reader);
+        readers.push_back(std::move(*reader));
+    }
+    EXPECT_FALSE(broadcast::Subscriber::attach(ring_name));
+    readers.pop_back();
+    EXPECT_TRUE(broadcast::Subscriber::attach(ring_name));
+}
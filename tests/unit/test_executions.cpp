@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <book/executions.h>
+#include <book/market.h>
+
+namespace
+{
+
+book::Execution make_execution(std::uint64_t match_number, std::uint32_t shares = 100)
+{
+    return {.match_number = match_number,
+            .price = 10000,
+            .shares = shares,
+            .stock_locate = 3,
+            .side = itch::Side::Sell,
+            .kind = book::ExecutionKind::Executed,
+            .busted = false};
+}
+
+} // namespace
+
+TEST(Executions, FindsRecordedMatches)
+{
+    book::ExecutionIndex index{1000};
+    EXPECT_EQ(index.capacity(), 1024);
+    EXPECT_EQ(index.bytes(), 1024 * 16);
+    EXPECT_FALSE(index.find(5));
+
+    index.record(make_execution(5));
+    index.record(make_execution(6, 200));
+    ASSERT_TRUE(index.find(5));
+    EXPECT_EQ(*index.find(5), make_execution(5));
+    EXPECT_EQ(index.find(6)->shares, 200);
+    // same slot, different match
+    EXPECT_FALSE(index.find(5 + 1024));
+}
+
+TEST(Executions, BustMarksOnce)
+{
+    book::ExecutionIndex index{16};
+    index.record(make_execution(40));
+
+    const auto busted{index.bust(40)};
+    ASSERT_TRUE(busted);
+    EXPECT_TRUE(busted->busted);
+    EXPECT_EQ(busted->shares, 100);
+    EXPECT_TRUE(index.find(40)->busted);
+
+    EXPECT_FALSE(index.bust(40));
+    EXPECT_FALSE(index.bust(41));
+}
+
+TEST(Executions, RingForgetsOldMatches)
+{
+    book::ExecutionIndex index{64};
+    for (std::uint64_t match = 1; match <= 1000; ++match)
+    {
+        index.record(make_execution(match, static_cast<std::uint32_t>(match)));
+    }
+
+    // the latest capacity() stay addressable
+    EXPECT_FALSE(index.find(1000 - 64));
+    for (std::uint64_t match = 1000 - 63; match <= 1000; ++match)
+    {
+        ASSERT_TRUE(index.find(match));
+        EXPECT_EQ(index.find(match)->shares, match);
+    }
+    EXPECT_FALSE(index.bust(100));
+}
+
+TEST(Executions, MarketIndexIsOptional)
+{
+    book::Market market{};
+    market.record_execution(0, make_execution(9));
+    EXPECT_EQ(market.executions(), nullptr);
+    EXPECT_FALSE(market.bust(0, 9));
+
+    market.enable_executions(256);
+    market.record_execution(0, make_execution(9));
+    EXPECT_TRUE(market.bust(0, 9));
+    EXPECT_TRUE(market.executions()->find(9)->busted);
+}
+
+TEST(Executions, EachChannelHasItsOwnIndex)
+{
+    book::Market market{};
+    market.enable_executions(256, 2);
+    ASSERT_NE(market.executions(1), nullptr);
+    EXPECT_EQ(market.executions(2), nullptr);
+
+    // adjacent matches from two channels land in separate rings, a bust finds its own channel's
+    market.record_execution(0, make_execution(9));
+    market.record_execution(1, make_execution(10));
+    EXPECT_TRUE(market.executions(0)->find(9));
+    EXPECT_FALSE(market.executions(0)->find(10));
+    EXPECT_FALSE(market.bust(0, 10));
+    EXPECT_TRUE(market.bust(1, 10));
+
+    // a ring is whole cache lines
+    EXPECT_EQ(book::ExecutionIndex{1}.bytes(), 64);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <fd/fd.h>
+
+#include <cerrno>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+
+bool is_open(int fd)
+{
+    return fcntl(fd, F_GETFD) != -1 || errno != EBADF;
+}
+
+}
+
+TEST(FD, ClosesOnDestruction)
+{
+    int fds[2]{};
+    ASSERT_EQ(pipe(fds), 0);
+    {
+        FD read_end{fds[0]};
+        FD write_end{fds[1]};
+        EXPECT_TRUE(is_open(fds[0]));
+        EXPECT_TRUE(is_open(fds[1]));
+    }
+    EXPECT_FALSE(is_open(fds[0]));
+    EXPECT_FALSE(is_open(fds[1]));
+}
+
+TEST(FD, MovedFromGivesUpItsDescriptor)
+{
+    int fds[2]{};
+    ASSERT_EQ(pipe(fds), 0);
+    FD write_end{fds[1]};
+    {
+        FD moved_from{fds[0]};
+        FD owner{std::move(moved_from)};
+        EXPECT_EQ(owner.fd(), fds[0]);
+        EXPECT_EQ(moved_from.fd(), -1);
+    }
+    EXPECT_FALSE(is_open(fds[0]));
+
+    // assigning over an owner closes what it held
+    int other[2]{};
+    ASSERT_EQ(pipe(other), 0);
+    FD replaced{other[0]};
+    replaced = std::move(write_end);
+    EXPECT_FALSE(is_open(other[0]));
+    EXPECT_EQ(replaced.fd(), fds[1]);
+    EXPECT_TRUE(is_open(fds[1]));
+    close(other[1]);
+}
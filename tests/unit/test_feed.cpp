@@ -0,0 +1,404 @@
+#include <gtest/gtest.h>
+#include <book/market.h>
+#include <feed/decoder.h>
+#include <feed/handlers.h>
+#include <feed/pipeline.h>
+#include <replay/itch_file.h>
+#include <replay/replay.h>
+
+#include "file_builder.h"
+
+#include <array>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// MoldUDP64 wraps the same length-prefixed blocks a BinaryFILE holds
+std::vector<std::byte> packet(std::uint64_t sequence, std::uint16_t count, std::span<const std::byte> blocks)
+{
+    std::vector<std::byte> out(10, std::byte{'S'});
+    for (std::size_t i = 8; i-- > 0;)
+    {
+        out.push_back(static_cast<std::byte>(sequence >> (8 * i)));
+    }
+    out.push_back(static_cast<std::byte>(count >> 8));
+    out.push_back(static_cast<std::byte>(count));
+    out.insert(out.end(), blocks.begin(), blocks.end());
+    return out;
+}
+
+// sees what the book stage left behind and every packet hook
+struct Recorder
+{
+    std::vector<std::optional<book::Change>> changes;
+    std::vector<itch::MessageType> types;
+    std::vector<std::size_t> malformed;
+    std::uint64_t sequence{0};
+    int packet_ends{0};
+
+    void on_packet(const feed::MoldUDP64Header& header)
+    {
+        sequence = header.sequence_number;
+    }
+    void on_type(itch::MessageType type)
+    {
+        types.push_back(type);
+    }
+    void on_malformed(const feed::MoldUDP64Header&, std::size_t index)
+    {
+        malformed.push_back(index);
+    }
+    void on_packet_end()
+    {
+        ++packet_ends;
+    }
+    void on(const itch::AddOrderMessage&, const feed::Effects& effects)
+    {
+        changes.push_back(effects.change);
+    }
+    void on(const itch::OrderDeleteMessage&, const feed::Effects& effects)
+    {
+        changes.push_back(effects.change);
+    }
+};
+
+// takes adds only, without effects
+struct AddCounter
+{
+    int adds{0};
+
+    void on(const itch::AddOrderMessage&)
+    {
+        ++adds;
+    }
+};
+
+// takes trades, which the load shedder can skip
+struct TradeCounter
+{
+    int trades{0};
+
+    void on(const itch::TradeMessage&)
+    {
+        ++trades;
+    }
+};
+
+// adds, executes, cancels, deletes and replaces over locates [first, first + locates)
+FileBuilder random_orders(std::uint64_t seed, std::uint16_t first, std::uint16_t locates, int ops)
+{
+    FileBuilder file{};
+    std::uint64_t state{seed};
+    const auto next{[&] {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state >> 33);
+    }};
+    std::vector<std::pair<std::uint16_t, std::uint64_t>> live{};
+    std::uint64_t ref{1};
+    for (int i = 0; i < ops; ++i)
+    {
+        const auto op{next() % 6};
+        if (op < 2 || live.empty())
+        {
+            const auto locate{static_cast<std::uint16_t>(first + next() % locates)};
+            if (op == 0)
+            {
+                file.add(locate, ref, next() % 2 == 0 ? 'B' : 'S', 100 + next() % 400, 10000 + next() % 50);
+            }
+            else
+            {
+                file.add_mpid(locate, ref, next() % 2 == 0 ? 'B' : 'S', 100 + next() % 400, 10000 + next() % 50);
+            }
+            live.emplace_back(locate, ref++);
+            continue;
+        }
+
+        const auto pick{next() % live.size()};
+        const auto [locate, order]{live[pick]};
+        if (op == 2)
+        {
+            file.execute(locate, order, next() % 300);
+        }
+        else if (op == 3)
+        {
+            file.cancel(locate, order, next() % 300);
+        }
+        else if (op == 4)
+        {
+            file.remove(locate, order);
+            live.erase(live.begin() + static_cast<std::ptrdiff_t>(pick));
+        }
+        else
+        {
+            file.replace(locate, order, ref, 100 + next() % 400, 10000 + next() % 50);
+            live[pick].second = ref++;
+        }
+    }
+    return file;
+}
+
+}
+
+static_assert(feed::Handles<AddCounter, itch::AddOrderMessage>);
+static_assert(!feed::Handles<AddCounter, itch::SystemEventMessage>);
+static_assert(!feed::Handles<feed::Pipeline<AddCounter>, itch::OrderDeleteMessage>);
+static_assert(feed::Handles<feed::Pipeline<AddCounter, Recorder>, itch::OrderDeleteMessage>);
+
+TEST(FeedPipeline, StagesSeeTheBookEffects)
+{
+    FileBuilder file{};
+    file.set_time(42);
+    file.add(1, 10, 'B', 100, 5000);
+    file.system_event();
+    file.remove(1, 10);
+    file.remove(1, 11);
+    const auto bytes{packet(7, 4, file.bytes())};
+
+    book::Market market{};
+    feed::BookHandler book_stage{market};
+    Recorder recorder{};
+    feed::Pipeline pipeline{book_stage, recorder};
+
+    const auto exchange_ts{feed::decode_packet(bytes, pipeline)};
+    ASSERT_TRUE(exchange_ts);
+    EXPECT_EQ(*exchange_ts, 42);
+    EXPECT_EQ(recorder.sequence, 7);
+    EXPECT_EQ(recorder.packet_ends, 1);
+    EXPECT_TRUE(recorder.malformed.empty());
+    EXPECT_EQ(recorder.types,
+              (std::vector{itch::MessageType::AddOrder, itch::MessageType::SystemEvent, itch::MessageType::OrderDelete, itch::MessageType::OrderDelete}));
+
+    // the add, the delete, and a delete of an unknown order
+    ASSERT_EQ(recorder.changes.size(), 3);
+    ASSERT_TRUE(recorder.changes[0]);
+    EXPECT_EQ(recorder.changes[0]->level.shares, 100);
+    ASSERT_TRUE(recorder.changes[1]);
+    EXPECT_EQ(recorder.changes[1]->order_shares, 0);
+    EXPECT_FALSE(recorder.changes[2]);
+    EXPECT_EQ(market.get_book(1).order_count(), 0);
+}
+
+TEST(FeedPipeline, OnlyHandledTypesReachTheStage)
+{
+    FileBuilder file{};
+    file.add(1, 1, 'B', 100, 5000);
+    file.execute(1, 1, 50);
+    file.add(2, 2, 'S', 100, 5100);
+    file.system_event();
+    const auto bytes{packet(1, 4, file.bytes())};
+
+    AddCounter counter{};
+    feed::decode_packet(bytes, counter);
+    EXPECT_EQ(counter.adds, 2);
+}
+
+TEST(FeedPipeline, ShortPacketStopsAtTheBadMessage)
+{
+    FileBuilder file{};
+    file.add(1, 1, 'B', 100, 5000);
+    file.add(1, 2, 'B', 100, 5000);
+    file.truncate(4);
+
+    book::Market market{};
+    feed::BookHandler book_stage{market};
+    Recorder recorder{};
+    feed::Pipeline pipeline{book_stage, recorder};
+
+    // the second add runs past the end, and a third is promised but absent
+    feed::decode_packet(packet(1, 3, file.bytes()), pipeline);
+    EXPECT_EQ(recorder.malformed, std::vector<std::size_t>{1});
+    EXPECT_EQ(recorder.changes.size(), 1);
+    EXPECT_EQ(recorder.packet_ends, 1);
+    EXPECT_EQ(market.get_book(1).order_count(), 1);
+}
+
+TEST(FeedPipeline, MessageShorterThanItsTypeIsMalformed)
+{
+    FileBuilder file{};
+    file.add(1, 1, 'B', 100, 5000);
+    file.add(1, 2, 'B', 100, 5000);
+    // the second add framed as 20 bytes, the packet still ends where its length says
+    std::vector<std::byte> blocks(file.bytes().begin(), file.bytes().end());
+    blocks.resize(blocks.size() - 16);
+    blocks[blocks.size() - 21] = std::byte{20};
+
+    book::Market market{};
+    feed::BookHandler book_stage{market};
+    Recorder recorder{};
+    feed::Pipeline pipeline{book_stage, recorder};
+    feed::decode_packet(packet(1, 2, blocks), pipeline);
+    EXPECT_EQ(recorder.malformed, std::vector<std::size_t>{1});
+    EXPECT_EQ(recorder.changes.size(), 1);
+    EXPECT_EQ(market.get_book(1).order_count(), 1);
+
+    // replay's own dispatch leaves it alone as well
+    EXPECT_FALSE(feed::dispatch(itch::MessageType::AddOrder, std::span{blocks}.last(19), pipeline));
+}
+
+TEST(FeedPipeline, ShortFirstMessageCarriesNoTimestamp)
+{
+    Recorder recorder{};
+    // a system event cut to its locate, exactly as long as the datagram
+    const std::array<std::byte, 5> blocks{std::byte{0}, std::byte{3}, std::byte{'S'}, std::byte{0}, std::byte{0}};
+    const auto short_packet{packet(1, 1, blocks)};
+    const std::vector<std::byte> exact(short_packet.begin(), short_packet.end());
+    EXPECT_FALSE(feed::decode_packet(exact, recorder));
+    EXPECT_EQ(recorder.types.size(), 1);
+
+    FileBuilder file{};
+    file.set_time(1234);
+    file.system_event();
+    EXPECT_EQ(feed::decode_packet(packet(2, 1, file.bytes()), recorder), 1234);
+}
+
+TEST(FeedPipeline, MatchesReplayApply)
+{
+    const auto file{random_orders(99, 1, 8, 2000)};
+
+    book::Market replayed{};
+    std::uint16_t count{0};
+    replay::for_each_message(file.bytes(), [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+        replay::apply(replayed, type, body);
+        ++count;
+    });
+
+    book::Market decoded{};
+    feed::BookHandler book_stage{decoded};
+    feed::Pipeline pipeline{book_stage};
+    feed::decode_packet(packet(1, count, file.bytes()), pipeline);
+
+    EXPECT_TRUE(decoded == replayed);
+}
+
+TEST(FeedPipeline, ChannelsShareOneMarket)
+{
+    // a partitioned feed: each channel carries its own locates and has its own receiver
+    const std::array files{random_orders(5, 1, 8, 20'000), random_orders(6, 9, 8, 20'000)};
+    std::vector<std::vector<std::byte>> packets{};
+    book::Market serial{};
+    serial.enable_signals();
+    for (const auto& file : files)
+    {
+        std::uint16_t count{0};
+        replay::for_each_message(file.bytes(), [&](std::uint64_t, itch::MessageType, std::span<const std::byte>) { ++count; });
+        packets.push_back(packet(1, count, file.bytes()));
+
+        feed::BookHandler book_stage{serial};
+        feed::SignalHandler signal_stage{serial};
+        feed::Pipeline pipeline{book_stage, signal_stage};
+        feed::decode_packet(packets.back(), pipeline);
+    }
+
+    book::Market shared{};
+    shared.enable_signals();
+    {
+        std::vector<std::jthread> receivers{};
+        for (const auto& bytes : packets)
+        {
+            receivers.emplace_back([&shared, &bytes] {
+                feed::BookHandler book_stage{shared};
+                feed::SignalHandler signal_stage{shared};
+                feed::Pipeline pipeline{book_stage, signal_stage};
+                feed::decode_packet(bytes, pipeline);
+            });
+        }
+    }
+
+    EXPECT_TRUE(shared == serial);
+    for (std::uint16_t locate = 1; locate <= 16; ++locate)
+    {
+        EXPECT_EQ(shared.bbo().bid_price[locate], serial.bbo().bid_price[locate]);
+        EXPECT_EQ(shared.bbo().ask_price[locate], serial.bbo().ask_price[locate]);
+    }
+}
+
+TEST(FeedPipeline, DegradedShedsOnlyNonBookMessages)
+{
+    FileBuilder file{};
+    file.add(1, 1, 'B', 100, 5000);
+    file.trade(1, 100, 7, 5000);
+    file.noii(1, 500, 100, 5000);
+    file.remove(1, 1);
+    file.add(1, 2, 'S', 100, 5100);
+    const auto bytes{packet(1, 5, file.bytes())};
+
+    metrics::ThreadCounters counters{};
+    std::ostringstream log{};
+    {
+        logging::Logger logger{log};
+        feed::LoadShedder shedder{counters, logger};
+        book::Market market{};
+        feed::BookHandler book_stage{market};
+        Recorder recorder{};
+        TradeCounter trades{};
+        feed::Pipeline pipeline{shedder, book_stage, recorder, trades};
+
+        // a queue past half full has to last before anything is shed
+        for (int i = 1; i < feed::LoadShedder::enter_after; ++i)
+        {
+            EXPECT_FALSE(shedder.sample(600, 1000, 0));
+        }
+        EXPECT_TRUE(shedder.sample(600, 1000, 0));
+        ASSERT_TRUE(shedder.degraded());
+
+        // trades feed busts, vwap and the cross price, only the indication goes
+        feed::decode_packet(bytes, pipeline);
+        EXPECT_EQ(trades.trades, 1);
+        EXPECT_EQ(recorder.types.size(), 5);
+        EXPECT_EQ(recorder.changes.size(), 3);
+        EXPECT_EQ(market.get_book(1).order_count(), 1);
+        EXPECT_EQ(market.auctions().find(1), nullptr);
+        EXPECT_EQ(counters.shed_messages.get(), 1);
+
+        // a queue that is almost drained again, for long enough
+        for (int i = 1; i < feed::LoadShedder::leave_after; ++i)
+        {
+            EXPECT_FALSE(shedder.sample(100, 1000, 0));
+        }
+        EXPECT_TRUE(shedder.sample(100, 1000, 0));
+        EXPECT_FALSE(shedder.degraded());
+
+        feed::decode_packet(bytes, pipeline);
+        EXPECT_EQ(trades.trades, 2);
+        EXPECT_NE(market.auctions().find(1), nullptr);
+        EXPECT_EQ(counters.shed_messages.get(), 1);
+    }
+    EXPECT_NE(log.str().find("skipping non-book messages"), std::string::npos);
+    EXPECT_NE(log.str().find("1 non-book messages were skipped"), std::string::npos);
+}
+
+TEST(FeedPipeline, KernelDropsCountAsOverload)
+{
+    metrics::ThreadCounters counters{};
+    std::ostringstream log{};
+    logging::Logger logger{log};
+    feed::LoadShedder shedder{counters, logger};
+
+    // an empty queue with fresh drops is still overloaded, a quiet sample breaks the streak
+    EXPECT_FALSE(shedder.sample(0, 1000, 3));
+    EXPECT_FALSE(shedder.sample(0, 1000, 5));
+    EXPECT_FALSE(shedder.sample(0, 1000, 5));
+    for (std::uint32_t drops = 6; drops < 6 + feed::LoadShedder::enter_after - 1; ++drops)
+    {
+        EXPECT_FALSE(shedder.sample(0, 1000, drops));
+    }
+    EXPECT_FALSE(shedder.degraded());
+    EXPECT_TRUE(shedder.sample(0, 1000, 0xFFFF'FFF0));
+    EXPECT_TRUE(shedder.degraded());
+
+    // the kernel's count wraps
+    EXPECT_FALSE(shedder.sample(0, 1000, 0x10));
+    EXPECT_EQ(counters.socket_drops.get(), std::uint64_t{0x1'0000'0010});
+
+    EXPECT_FALSE(feed::LoadShedder::auxiliary(itch::MessageType::OrderReplace));
+    EXPECT_FALSE(feed::LoadShedder::auxiliary(itch::MessageType::BrokenTrade));
+    EXPECT_FALSE(feed::LoadShedder::auxiliary(itch::MessageType::StockDirectory));
+    EXPECT_FALSE(feed::LoadShedder::auxiliary(itch::MessageType::Trade));
+    EXPECT_FALSE(feed::LoadShedder::auxiliary(itch::MessageType::CrossTrade));
+    EXPECT_TRUE(feed::LoadShedder::auxiliary(itch::MessageType::NOII));
+    EXPECT_TRUE(feed::LoadShedder::auxiliary(itch::MessageType::RPII));
+    EXPECT_TRUE(feed::LoadShedder::auxiliary(itch::MessageType::MarketParticipantPosition));
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <stats/histogram.h>
+
+TEST(Histogram, BucketsAreExactBelowThirtyTwo)
+{
+    for (std::uint64_t v = 0; v < 32; ++v)
+    {
+        EXPECT_EQ(stats::Histogram::bucket(v), v);
+        EXPECT_EQ(stats::Histogram::bucket_lower(v), v);
+    }
+}
+
+TEST(Histogram, BucketLowerBoundsContainValue)
+{
+    for (std::uint64_t v : {33UL, 100UL, 1'000UL, 123'456UL, 1UL << 40, ~0UL})
+    {
+        const auto index{stats::Histogram::bucket(v)};
+        ASSERT_LT(index, stats::Histogram::bucket_count);
+        EXPECT_LE(stats::Histogram::bucket_lower(index), v);
+        if (index + 1 < stats::Histogram::bucket_count)
+        {
+            EXPECT_GT(stats::Histogram::bucket_lower(index + 1), v);
+        }
+    }
+}
+
+TEST(Histogram, Quantiles)
+{
+    stats::Histogram hist{};
+    for (std::int64_t v = 1; v <= 1000; ++v)
+    {
+        hist.record(v);
+    }
+    hist.record(-5);
+
+    EXPECT_EQ(hist.count(), 1000);
+    EXPECT_EQ(hist.negative(), 1);
+    EXPECT_EQ(hist.max(), 1000);
+    EXPECT_NEAR(static_cast<double>(hist.quantile(0.5)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(hist.quantile(0.99)), 990.0, 990.0 / 16);
+    EXPECT_EQ(hist.quantile(1.0), 1000);
+}
@@ -29,6 +29,19 @@ std::vector<std::byte> make_msg(std::initializer_list<unsigned char> payload)
 
 } // namespace
 
+TEST(ItchParser, MessageHeader)
+{
+    // clang-format off
+    auto header = itch::parse_message_header(make_msg({
+        'O'
+    }));
+    // clang-format on
+
+    EXPECT_EQ(header.stock_locate, 1);
+    EXPECT_EQ(header.tracking_number, 2);
+    EXPECT_EQ(header.timestamp, 3);
+}
+
 TEST(ItchParser, SystemEventMessage)
 {
     // clang-format off
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <journal/journal.h>
+
+#include <filesystem>
+#include <string>
+
+namespace
+{
+
+itch::MessageHeader make_header(std::uint64_t timestamp)
+{
+    return {.stock_locate = 7, .tracking_number = 0, .timestamp = timestamp};
+}
+
+} // namespace
+
+TEST(Journal, ReaderTailsCommittedEvents)
+{
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_journal").string()};
+    auto journal{journal::Journal::create(path, 64 * 1024)};
+    ASSERT_TRUE(journal);
+    auto reader{journal::Reader::open(path)};
+    ASSERT_TRUE(reader);
+
+    book::Book book{};
+    const auto added{book.add(1, 100, 10000, itch::Side::Buy)};
+    journal->order_added(make_header(5), 1, *added, book);
+
+    // nothing visible before commit
+    EXPECT_TRUE(reader->poll().empty());
+    journal->commit();
+
+    auto events{reader->poll()};
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].type, journal::EventType::OrderAdded);
+    EXPECT_EQ(events[0].stock_locate, 7);
+    EXPECT_EQ(events[0].timestamp, 5);
+    EXPECT_EQ(events[0].order.ref_num, 1);
+    EXPECT_EQ(events[0].order.shares, 100);
+    EXPECT_EQ(events[1].type, journal::EventType::LevelChanged);
+    EXPECT_EQ(events[1].level.shares, 100);
+    EXPECT_EQ(events[2].type, journal::EventType::BBOChanged);
+    EXPECT_EQ(events[2].bbo.bid_price, 10000);
+    EXPECT_EQ(events[2].bbo.ask_price, 0);
+
+    const auto executed{book.reduce(1, 40)};
+    journal->order_executed(make_header(6), 1, 99, *executed, book);
+    journal->commit();
+
+    events = reader->poll();
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].sequence, 3);
+    EXPECT_EQ(events[0].type, journal::EventType::OrderExecuted);
+    EXPECT_EQ(events[0].order.match_number, 99);
+    EXPECT_EQ(events[0].order.shares, 40);
+    EXPECT_EQ(events[0].order.remaining, 60);
+
+    journal->trade_broken(make_header(7),
+                          {.match_number = 99,
+                           .price = 10000,
+                           .shares = 40,
+                           .stock_locate = 7,
+                           .side = itch::Side::Buy,
+                           .kind = book::ExecutionKind::Executed,
+                           .busted = true});
+    journal->commit();
+
+    events = reader->poll();
+    ASSERT_EQ(events.size(), 1);
+    EXPECT_EQ(events[0].type, journal::EventType::TradeBroken);
+    EXPECT_EQ(events[0].order.match_number, 99);
+    EXPECT_EQ(events[0].order.price, 10000);
+    EXPECT_EQ(events[0].order.shares, 40);
+
+    std::filesystem::remove(path);
+}
+
+TEST(Journal, DropsWhenFull)
+{
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_journal_full").string()};
+    auto journal{journal::Journal::create(path, sizeof(journal::Header) + 2 * sizeof(journal::Event))};
+    ASSERT_TRUE(journal);
+
+    book::Book book{};
+    const auto added{book.add(1, 100, 10000, itch::Side::Buy)};
+    journal->order_added(make_header(1), 1, *added, book);
+
+    EXPECT_EQ(journal->written(), 2);
+    EXPECT_EQ(journal->dropped(), 1);
+
+    std::filesystem::remove(path);
+}
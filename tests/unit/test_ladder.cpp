@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include <book/book.h>
+#include <book/ladder.h>
+#include <book/market.h>
+
+#include <array>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+using Bids = book::Ladder<std::greater<>>;
+using Asks = book::Ladder<std::less<>>;
+
+constexpr book::LadderProfile small_ladder{.tick = 100, .ticks = 64};
+
+// what the ladder must agree with: a tree and nothing else
+template <typename Better>
+struct Reference
+{
+    book::Level add(std::uint32_t price, std::uint32_t shares, bool& top)
+    {
+        auto& level{levels.try_emplace(price, book::Level{.price = price, .orders = 0, .shares = 0}).first->second};
+        ++level.orders;
+        level.shares += shares;
+        top = levels.begin()->first == price;
+        return level;
+    }
+
+    book::Level take(std::uint32_t price, std::uint32_t shares, bool& top)
+    {
+        const auto it{levels.find(price)};
+        top = it == levels.begin();
+        it->second.shares -= shares;
+        --it->second.orders;
+        const auto level{it->second};
+        if (level.orders == 0)
+        {
+            levels.erase(it);
+        }
+        return level;
+    }
+
+    std::map<std::uint32_t, book::Level, Better> levels;
+};
+
+template <typename Better>
+void check_against_tree(std::uint64_t seed)
+{
+    book::Ladder<Better> ladder{};
+    ladder.set_profile(small_ladder);
+    Reference<Better> reference{};
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> live{};
+    std::mt19937_64 rng{seed};
+    // a touch that wanders well past the array, quotes around it, some off the penny grid
+    std::int64_t touch{5'000'000};
+
+    for (int i = 0; i < 100'000; ++i)
+    {
+        touch = std::max<std::int64_t>(10'000, touch + static_cast<std::int64_t>(rng() % 201) - 100);
+        const auto roll{rng() % 100};
+        if (roll < 52 || live.empty())
+        {
+            const auto away{static_cast<std::int64_t>(rng() % 100 < 95 ? rng() % 4000 : rng() % 400'000)};
+            const auto price{static_cast<std::uint32_t>(std::max<std::int64_t>(100, touch + (rng() % 2 == 0 ? away : -away)) / 100 * 100 +
+                                                        (rng() % 50 == 0 ? 37 : 0))};
+            const auto shares{static_cast<std::uint32_t>(1 + rng() % 500)};
+            bool top{false};
+            bool expected_top{false};
+            ASSERT_EQ(ladder.add(price, shares, top), reference.add(price, shares, expected_top));
+            ASSERT_EQ(top, expected_top);
+            live.emplace_back(price, shares);
+        }
+        else
+        {
+            const auto pick{rng() % live.size()};
+            const auto [price, shares]{live[pick]};
+            live[pick] = live.back();
+            live.pop_back();
+            bool top{false};
+            bool expected_top{false};
+            ASSERT_EQ(ladder.take(price, shares, true, top), reference.take(price, shares, expected_top));
+            ASSERT_EQ(top, expected_top);
+        }
+
+        ASSERT_EQ(ladder.size(), reference.levels.size());
+        if (reference.levels.empty())
+        {
+            ASSERT_FALSE(ladder.best());
+            continue;
+        }
+        ASSERT_EQ(ladder.best(), reference.levels.begin()->second);
+        // walking down from the best meets every level the tree has, in order
+        if (i % 1000 == 0)
+        {
+            auto level{ladder.best()};
+            for (const auto& [price, expected] : reference.levels)
+            {
+                ASSERT_TRUE(level);
+                ASSERT_EQ(*level, expected);
+                ASSERT_EQ(*ladder.find(price), expected);
+                level = ladder.next_worse(price);
+            }
+            ASSERT_FALSE(level);
+        }
+    }
+    EXPECT_GT(ladder.dense_size(), 0);
+}
+
+} // namespace
+
+TEST(Ladder, SparseByDefault)
+{
+    Bids bids{};
+    bool top{false};
+    bids.add(1'000'000, 100, top);
+    EXPECT_TRUE(top);
+    EXPECT_EQ(bids.profile(), (book::LadderProfile{.tick = 0, .ticks = 0}));
+    EXPECT_EQ(bids.dense_size(), 0);
+    EXPECT_EQ(bids.size(), 1);
+}
+
+TEST(Ladder, LevelsNearTheTouchAreDense)
+{
+    Asks asks{};
+    asks.set_profile(small_ladder);
+    bool top{false};
+    asks.add(1'000'000, 100, top);
+    asks.add(1'000'100, 200, top);
+    EXPECT_FALSE(top);
+    // off the penny grid and far away stay in the tree
+    asks.add(1'000'150, 300, top);
+    asks.add(9'000'000, 400, top);
+    EXPECT_EQ(asks.dense_size(), 2);
+    EXPECT_EQ(asks.size(), 4);
+
+    EXPECT_EQ(asks.best()->price, 1'000'000);
+    EXPECT_EQ(asks.next_worse(1'000'000)->price, 1'000'100);
+    EXPECT_EQ(asks.next_worse(1'000'100)->price, 1'000'150);
+    EXPECT_EQ(asks.next_worse(1'000'150)->price, 9'000'000);
+    EXPECT_FALSE(asks.next_worse(9'000'000));
+    EXPECT_EQ(asks.find(1'000'100)->shares, 200);
+    EXPECT_EQ(asks.find(1'000'200), nullptr);
+
+    const auto level{asks.take(1'000'000, 100, true, top)};
+    EXPECT_TRUE(top);
+    EXPECT_EQ(level.orders, 0);
+    EXPECT_EQ(asks.best()->price, 1'000'100);
+}
+
+TEST(Ladder, RecentresWhenTheTouchLeavesTheArray)
+{
+    Bids bids{};
+    bids.set_profile(small_ladder);
+    bool top{false};
+    bids.add(1'000'000, 100, top);
+    bids.add(999'900, 100, top);
+    EXPECT_EQ(bids.dense_size(), 2);
+
+    // 20 cents above a 64 tick array centred on $100.00 still fits, a dollar does not
+    bids.add(1'002'000, 100, top);
+    EXPECT_TRUE(top);
+    EXPECT_EQ(bids.dense_size(), 3);
+    bids.add(1'010'000, 100, top);
+    EXPECT_TRUE(top);
+    EXPECT_EQ(bids.best()->price, 1'010'000);
+    // the array moved up to the new touch, the old levels fell behind it
+    EXPECT_EQ(bids.dense_size(), 1);
+    EXPECT_EQ(bids.size(), 4);
+    EXPECT_EQ(bids.next_worse(1'002'000)->price, 1'000'000);
+
+    // the touch going back brings the array with it
+    bids.take(1'010'000, 100, true, top);
+    bids.take(1'002'000, 100, true, top);
+    EXPECT_EQ(bids.best()->price, 1'000'000);
+    EXPECT_EQ(bids.dense_size(), 2);
+    EXPECT_EQ(bids.size(), 2);
+}
+
+TEST(Ladder, ProfileChangesKeepTheLevels)
+{
+    Asks asks{};
+    bool top{false};
+    for (std::uint32_t price = 500'000; price < 502'000; price += 100)
+    {
+        asks.add(price, price / 100, top);
+    }
+    const auto sparse{asks};
+    asks.set_profile(small_ladder);
+    EXPECT_EQ(asks.dense_size(), asks.size());
+    EXPECT_EQ(asks, sparse);
+    asks.set_profile({});
+    EXPECT_EQ(asks.dense_size(), 0);
+    EXPECT_EQ(asks, sparse);
+}
+
+TEST(Ladder, BidsMatchATree)
+{
+    check_against_tree<std::greater<>>(3);
+}
+
+TEST(Ladder, AsksMatchATree)
+{
+    check_against_tree<std::less<>>(4);
+}
+
+TEST(Ladder, DenseBookMatchesSparseBook)
+{
+    book::BasicBook<book::L3Queues> sparse{};
+    book::BasicBook<book::L3Queues> dense{};
+    dense.set_ladder(small_ladder);
+    std::mt19937_64 rng{11};
+    std::vector<std::uint64_t> live{};
+    std::uint64_t next_ref{1};
+    std::uint32_t touch{2'000'000};
+
+    for (int i = 0; i < 50'000; ++i)
+    {
+        touch = touch + 100 * static_cast<std::uint32_t>(rng() % 3) - 100;
+        if (rng() % 100 < 55 || live.empty())
+        {
+            const auto side{rng() % 2 == 0 ? itch::Side::Buy : itch::Side::Sell};
+            const auto away{100 * static_cast<std::uint32_t>(rng() % 30)};
+            const auto price{side == itch::Side::Buy ? touch - 100 - away : touch + away};
+            const auto dense_change{dense.add(next_ref, 100, price, side)};
+            const auto sparse_change{sparse.add(next_ref, 100, price, side)};
+            ASSERT_EQ(dense_change->level, sparse_change->level);
+            ASSERT_EQ(dense_change->top, sparse_change->top);
+            live.push_back(next_ref++);
+            continue;
+        }
+        const auto pick{rng() % live.size()};
+        const auto ref{live[pick]};
+        live[pick] = live.back();
+        live.pop_back();
+        const auto dense_change{dense.remove(ref)};
+        const auto sparse_change{sparse.remove(ref)};
+        ASSERT_EQ(dense_change->level, sparse_change->level);
+        ASSERT_EQ(dense_change->top, sparse_change->top);
+        ASSERT_EQ(dense.best_bid(), sparse.best_bid());
+        ASSERT_EQ(dense.best_ask(), sparse.best_ask());
+    }
+
+    EXPECT_EQ(dense, sparse);
+    std::array<book::Level, book::max_depth> dense_depth{};
+    std::array<book::Level, book::max_depth> sparse_depth{};
+    for (const auto side : {itch::Side::Buy, itch::Side::Sell})
+    {
+        ASSERT_EQ(dense.depth(side, dense_depth), sparse.depth(side, sparse_depth));
+        EXPECT_EQ(dense_depth, sparse_depth);
+    }
+    if (!live.empty())
+    {
+        const auto dense_position{dense.queue_position(live.front())};
+        const auto sparse_position{sparse.queue_position(live.front())};
+        EXPECT_EQ(dense_position->level, sparse_position->level);
+        EXPECT_EQ(dense_position->shares_ahead, sparse_position->shares_ahead);
+    }
+}
+
+TEST(Ladder, StockDirectorySelectsTheProfile)
+{
+    book::Market market{};
+    market.select_ladder(itch::to_symbol("AAPL"), book::liquid_ladder);
+    itch::StockDirectoryMessage directory{};
+    directory.header.stock_locate = 7;
+    directory.symbol = itch::to_symbol("AAPL");
+    market.on_stock_directory(directory);
+    directory.header.stock_locate = 8;
+    directory.symbol = itch::to_symbol("ZZZZ");
+    market.on_stock_directory(directory);
+
+    EXPECT_EQ(market.get_book(7).ladder(), book::liquid_ladder);
+    EXPECT_EQ(market.get_book(8).ladder().ticks, 0);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+TEST(Metrics, SnapshotSumsTheReceivers)
+{
+    auto registry{std::make_unique<metrics::Registry>()};
+    auto* first{registry->add_thread()};
+    auto* second{registry->add_thread()};
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+
+    first->packets.add(3);
+    second->packets.add(4);
+    first->messages['A'].add(5);
+    second->messages['A'].add(1);
+    second->messages['D'].add(2);
+    first->orders_added.add(6);
+    second->orders_removed.add(2);
+    first->books_activated.add(1);
+    second->socket_drops.add(9);
+    registry->observe_levels(42, 7);
+    registry->observe_levels(42, 3);
+
+    const auto text{registry->snapshot()};
+    EXPECT_TRUE(text.starts_with("packets 7\n")) << text;
+    for (const auto* line : {"messages{type=\"AddOrder\",code=\"A\"} 6\n",
+                             "messages{type=\"OrderDelete\",code=\"D\"} 2\n",
+                             "socket_drops 9\n",
+                             "live_orders 4\n",
+                             "active_books 1\n",
+                             "receiver_packets{receiver=\"0\"} 3\n",
+                             "receiver_messages{receiver=\"1\"} 3\n",
+                             "receiver_socket_drops{receiver=\"1\"} 9\n",
+                             "peak_levels{locate=\"42\"} 7\n"})
+    {
+        EXPECT_NE(text.find(line), std::string::npos) << line;
+    }
+    // only the types and locates seen
+    EXPECT_EQ(text.find("code=\"E\""), std::string::npos);
+    EXPECT_EQ(text.find("locate=\"41\""), std::string::npos);
+}
+
+TEST(Metrics, RemovesNeverOutrunAdds)
+{
+    auto registry{std::make_unique<metrics::Registry>()};
+    auto* counters{registry->add_thread()};
+    counters->orders_removed.add(2);
+    EXPECT_NE(registry->snapshot().find("live_orders 0\n"), std::string::npos);
+}
+
+TEST(Metrics, StalledScraperDoesNotHoldUpShutdown)
+{
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_metrics.sock").string()};
+    auto registry{std::make_unique<metrics::Registry>()};
+    // far more text than a unix socket buffers
+    for (std::uint16_t locate = 1; locate != 0; ++locate)
+    {
+        registry->observe_levels(locate, 1);
+    }
+
+    auto server{metrics::Server::create(*registry, path)};
+    ASSERT_TRUE(server);
+
+    sockaddr_un addr{.sun_family = AF_UNIX, .sun_path = {}};
+    path.copy(addr.sun_path, path.size());
+    FD client{socket(AF_UNIX, SOCK_STREAM, 0)};
+    ASSERT_EQ(connect(client.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    // never read
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    const auto start{std::chrono::steady_clock::now()};
+    server.reset();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{2});
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <cli/options.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+std::optional<cli::Options> parse(std::vector<std::string> args)
+{
+    std::string program{"level-3-orderbook"};
+    std::vector<char*> argv{program.data()};
+    for (auto& arg : args)
+    {
+        argv.push_back(arg.data());
+    }
+    return cli::parse_options(static_cast<int>(argv.size()), argv.data());
+}
+
+} // namespace
+
+TEST(Options, OneChannelFromTheCommandLine)
+{
+    const auto options{parse({"--rx-cpu=3", "233.54.12.111", "26477"})};
+    ASSERT_TRUE(options);
+    ASSERT_EQ(options->channels.size(), 1);
+    EXPECT_EQ(options->channels[0].mcast_group, "233.54.12.111");
+    EXPECT_EQ(options->channels[0].port, 26477);
+    EXPECT_EQ(options->channels[0].cpu, 3);
+
+    EXPECT_FALSE(parse({"233.54.12.111", "0"}));
+    EXPECT_FALSE(parse({"233.54.12.111"}));
+}
+
+TEST(Options, ChannelsFromAFile)
+{
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_channels").string()};
+    {
+        std::ofstream out{path};
+        out << "# group port cpu\n"
+               "233.54.12.111 26477 2\n"
+               "\n"
+               "233.54.12.112 26478   # no cpu, follows --rx-cpu\n"
+               "233.54.12.113 26479\n";
+    }
+
+    const auto options{parse({"--rx-cpu=4", "--channels=" + path})};
+    ASSERT_TRUE(options);
+    ASSERT_EQ(options->channels.size(), 3);
+    EXPECT_EQ(options->channels[0].cpu, 2);
+    EXPECT_EQ(options->channels[1].mcast_group, "233.54.12.112");
+    EXPECT_EQ(options->channels[1].port, 26478);
+    EXPECT_EQ(options->channels[1].cpu, 5);
+    EXPECT_EQ(options->channels[2].cpu, 6);
+
+    // positional channels don't mix with a file, and a snapshot is of one session
+    EXPECT_FALSE(parse({"--channels=" + path, "233.54.12.111", "26477"}));
+    EXPECT_FALSE(parse({"--channels=" + path, "--snapshot=/tmp/snapshot"}));
+
+    // each channel journals and broadcasts on its own
+    EXPECT_TRUE(parse({"--channels=" + path, "--journal=/tmp/journal", "--broadcast=l3book"}));
+    EXPECT_EQ(cli::channel_path("/tmp/journal", 2, 3), "/tmp/journal.2");
+    EXPECT_EQ(cli::channel_path("/tmp/journal", 0, 1), "/tmp/journal");
+
+    {
+        std::ofstream out{path};
+        out << "233.54.12.111 notaport\n";
+    }
+    EXPECT_FALSE(parse({"--channels=" + path}));
+    std::filesystem::remove(path);
+    EXPECT_FALSE(parse({"--channels=" + path}));
+}
+
+TEST(Options, ArenaTakesAPositiveSize)
+{
+    const auto options{parse({"--hugepages=off", "--arena-mib=64", "233.54.12.111", "26477"})};
+    ASSERT_TRUE(options);
+    EXPECT_EQ(options->arena_bytes, 64UL * 1024 * 1024);
+
+    EXPECT_FALSE(parse({"--hugepages=off", "--arena-mib=0", "233.54.12.111", "26477"}));
+    EXPECT_FALSE(parse({"--arena-mib=lots", "233.54.12.111", "26477"}));
+}
+
+TEST(Options, ExecutionIndexIsOptIn)
+{
+    const auto options{parse({"233.54.12.111", "26477"})};
+    ASSERT_TRUE(options);
+    EXPECT_EQ(options->match_capacity, 0);
+    EXPECT_EQ(parse({"--match-capacity=4096", "233.54.12.111", "26477"})->match_capacity, 4096);
+}
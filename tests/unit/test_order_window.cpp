@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <book/book.h>
+#include <book/order_window.h>
+
+#include <random>
+#include <unordered_map>
+
+namespace
+{
+
+using Window = book::OrderWindow<book::Order>;
+
+book::Order make_order(std::uint32_t shares)
+{
+    return {.shares = shares, .price_side = book::pack_price(10000, itch::Side::Buy)};
+}
+
+} // namespace
+
+TEST(OrderWindow, InsertFindErase)
+{
+    Window window{};
+    EXPECT_EQ(window.find(7), nullptr);
+
+    EXPECT_TRUE(window.insert(7, make_order(100)));
+    EXPECT_FALSE(window.insert(7, make_order(200)));
+    EXPECT_TRUE(window.insert(9, make_order(300)));
+    ASSERT_NE(window.find(7), nullptr);
+    EXPECT_EQ(window.find(7)->shares, 100);
+    EXPECT_EQ(window.find(8), nullptr);
+    EXPECT_EQ(window.size(), 2);
+
+    window.find(9)->shares = 50;
+    EXPECT_EQ(window.find(9)->shares, 50);
+
+    window.erase(7);
+    EXPECT_EQ(window.find(7), nullptr);
+    EXPECT_EQ(window.size(), 1);
+    EXPECT_EQ(window.capacity(), Window::min_capacity);
+}
+
+TEST(OrderWindow, LongLivedOrdersSpillBehindTheWindow)
+{
+    Window window{};
+    ASSERT_TRUE(window.insert(1, make_order(100)));
+    // sparse refs never crowd the window, so it slides rather than grows
+    for (std::uint64_t ref = 1000; ref < 100'000; ref += 1000)
+    {
+        ASSERT_TRUE(window.insert(ref, make_order(1)));
+    }
+    EXPECT_EQ(window.capacity(), Window::min_capacity);
+    EXPECT_EQ(window.overflow(), 99);
+    ASSERT_NE(window.find(1), nullptr);
+    EXPECT_EQ(window.find(1)->shares, 100);
+    EXPECT_FALSE(window.insert(1, make_order(1)));
+
+    window.erase(1);
+    EXPECT_EQ(window.find(1), nullptr);
+    EXPECT_EQ(window.size(), 99);
+    // a ref behind the window that was never seen
+    EXPECT_TRUE(window.insert(2, make_order(5)));
+    EXPECT_EQ(window.find(2)->shares, 5);
+}
+
+TEST(OrderWindow, DrainedSlotsLetTheWindowSlideWithoutSpilling)
+{
+    Window window{};
+    for (std::uint64_t ref = 1; ref < 10'000; ++ref)
+    {
+        ASSERT_TRUE(window.insert(ref, make_order(1)));
+        if (ref > 8)
+        {
+            window.erase(ref - 8);
+        }
+    }
+    EXPECT_EQ(window.capacity(), Window::min_capacity);
+    EXPECT_EQ(window.overflow(), 0);
+    EXPECT_EQ(window.size(), 8);
+}
+
+TEST(OrderWindow, DenseRefsGrowTheWindow)
+{
+    Window window{};
+    for (std::uint64_t ref = 100; ref < 20'100; ++ref)
+    {
+        ASSERT_TRUE(window.insert(ref, make_order(static_cast<std::uint32_t>(ref))));
+    }
+    EXPECT_GE(window.capacity(), 20'000);
+    EXPECT_EQ(window.overflow(), 0);
+    for (std::uint64_t ref = 100; ref < 20'100; ++ref)
+    {
+        ASSERT_NE(window.find(ref), nullptr);
+        ASSERT_EQ(window.find(ref)->shares, ref);
+    }
+}
+
+TEST(OrderWindow, MatchesHashMap)
+{
+    Window window{};
+    std::unordered_map<std::uint64_t, book::Order> reference{};
+    std::vector<std::uint64_t> live{};
+    std::mt19937_64 rng{7};
+    std::uint64_t next_ref{1};
+
+    for (int i = 0; i < 200'000; ++i)
+    {
+        const auto roll{rng() % 100};
+        if (roll < 50 || live.empty())
+        {
+            // this book's refs are interleaved with everyone else's
+            next_ref += 1 + rng() % 40;
+            const auto ref{roll < 2 && next_ref > 500 ? next_ref - 1 - rng() % 500 : next_ref};
+            const auto order{make_order(static_cast<std::uint32_t>(rng()))};
+            const bool inserted{reference.try_emplace(ref, order).second};
+            ASSERT_EQ(window.insert(ref, order), inserted);
+            if (inserted)
+            {
+                live.push_back(ref);
+            }
+            continue;
+        }
+
+        // mostly young orders die, a few old ones
+        const auto pick{roll < 90 ? live.size() - 1 - rng() % std::min<std::size_t>(live.size(), 16) : rng() % live.size()};
+        const auto ref{live[pick]};
+        live[pick] = live.back();
+        live.pop_back();
+        reference.erase(ref);
+        window.erase(ref);
+        ASSERT_EQ(window.find(ref), nullptr);
+    }
+
+    ASSERT_EQ(window.size(), reference.size());
+    for (const auto& [ref, order] : reference)
+    {
+        ASSERT_NE(window.find(ref), nullptr);
+        ASSERT_EQ(*window.find(ref), order);
+    }
+    std::size_t visited{0};
+    window.for_each([&](std::uint64_t ref, const book::Order& order) {
+        ++visited;
+        EXPECT_EQ(reference.at(ref), order);
+    });
+    EXPECT_EQ(visited, reference.size());
+}
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include <book/market.h>
+#include <fd/fd.h>
+#include <feed/decoder.h>
+#include <feed/handlers.h>
+#include <feed/pipeline.h>
+#include <recovery/late_join.h>
+#include <recovery/snapshot.h>
+#include <replay/itch_file.h>
+#include <util/binary_io.h>
+
+#include "file_builder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace
+{
+
+const feed::Session session{'S', 'E', 'S', 'S', 'I', 'O', 'N', '0', '0', '1'};
+
+// adds across three locates with some of them taken off again, one message per op
+FileBuilder orders(int ops)
+{
+    FileBuilder file{};
+    std::vector<std::uint64_t> live{};
+    std::uint64_t ref{1};
+    for (int i = 0; i < ops; ++i)
+    {
+        const auto locate{static_cast<std::uint16_t>(1 + i % 3)};
+        if (i % 4 == 3)
+        {
+            const auto order{live[static_cast<std::size_t>(i) % live.size()]};
+            file.execute(static_cast<std::uint16_t>(1 + (order - 1) % 3), order, 50);
+            continue;
+        }
+        if (i % 7 == 6)
+        {
+            file.remove(static_cast<std::uint16_t>(1 + (live.front() - 1) % 3), live.front());
+            live.erase(live.begin());
+            continue;
+        }
+        // ref r always rests on locate 1 + (r - 1) % 3
+        while (static_cast<std::uint16_t>(1 + (ref - 1) % 3) != locate)
+        {
+            ++ref;
+        }
+        file.add(locate, ref, i % 2 == 0 ? 'B' : 'S', 100 + static_cast<std::uint32_t>(i), 10000 + static_cast<std::uint32_t>(i % 20) * 100);
+        live.push_back(ref++);
+    }
+    return file;
+}
+
+// every message as its length-prefixed block
+std::vector<std::span<const std::byte>> blocks(const FileBuilder& file)
+{
+    std::vector<std::span<const std::byte>> out{};
+    replay::for_each_message(file.bytes(), [&](std::uint64_t offset, itch::MessageType, std::span<const std::byte> body) {
+        out.push_back(file.bytes().subspan(offset, 3 + body.size()));
+    });
+    return out;
+}
+
+// MoldUDP64 packets of per_packet messages, sequences from 1
+std::vector<std::vector<std::byte>> packets(std::span<const std::span<const std::byte>> messages, std::size_t per_packet)
+{
+    std::vector<std::vector<std::byte>> out{};
+    for (std::size_t first = 0; first < messages.size(); first += per_packet)
+    {
+        const auto count{std::min(per_packet, messages.size() - first)};
+        std::vector<std::byte> packet{std::as_bytes(std::span{session}).begin(), std::as_bytes(std::span{session}).end()};
+        const auto sequence{first + 1};
+        for (std::size_t i = 8; i-- > 0;)
+        {
+            packet.push_back(static_cast<std::byte>(sequence >> (8 * i)));
+        }
+        packet.push_back(static_cast<std::byte>(count >> 8));
+        packet.push_back(static_cast<std::byte>(count));
+        for (const auto& message : messages.subspan(first, count))
+        {
+            packet.insert(packet.end(), message.begin(), message.end());
+        }
+        out.push_back(std::move(packet));
+    }
+    return out;
+}
+
+void apply_packet(book::Market& market, std::span<const std::byte> packet)
+{
+    feed::BookHandler book_stage{market};
+    feed::Pipeline pipeline{book_stage};
+    feed::decode_packet(packet, pipeline);
+}
+
+// the market as of sequence, written where a late join can read it
+std::string snapshot_of(std::span<const std::span<const std::byte>> messages, std::uint64_t sequence)
+{
+    book::Market market{};
+    apply_packet(market, packets(messages.first(sequence - 1), messages.size()).front());
+    const auto path{(std::filesystem::temp_directory_path() / "l3_test_snapshot").string()};
+    EXPECT_TRUE(recovery::write_snapshot(recovery::encode_snapshot(market, session, sequence), path));
+    return path;
+}
+
+// the book's refs, oldest first
+std::vector<std::uint64_t> by_priority(const book::Book& book)
+{
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> resting{};
+    book.for_each_order([&](std::uint64_t ref_num, const book::QueuedOrder& order) { resting.emplace_back(order.seq, ref_num); });
+    std::ranges::sort(resting);
+    std::vector<std::uint64_t> refs{};
+    for (const auto& [seq, ref_num] : resting)
+    {
+        refs.push_back(ref_num);
+    }
+    return refs;
+}
+
+// holds packets [first, last) until the snapshot is in, the rest arrive live
+void late_join(recovery::LateJoin& join, book::Market& market, std::span<const std::vector<std::byte>> stream, std::size_t first, std::size_t last)
+{
+    feed::BookHandler book_stage{market};
+    feed::Pipeline pipeline{book_stage};
+    for (std::size_t i = first; i < last; ++i)
+    {
+        ASSERT_TRUE(join.hold(stream[i]));
+    }
+    while (!join.live())
+    {
+        ASSERT_TRUE(join.catch_up([&](std::span<const std::byte> held) { feed::decode_packet(held, pipeline); }));
+        std::this_thread::yield();
+    }
+    for (std::size_t i = last; i < stream.size(); ++i)
+    {
+        feed::decode_packet(join.admit(stream[i]), pipeline);
+    }
+}
+
+} // namespace
+
+TEST(Recovery, SnapshotRebuildsTheBooks)
+{
+    const auto file{orders(400)};
+    book::Market market{};
+    apply_packet(market, packets(blocks(file), 1000).front());
+
+    const auto snapshot{recovery::encode_snapshot(market, session, 401)};
+    book::Market loaded{};
+    const auto info{recovery::load_snapshot(snapshot, loaded)};
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->sequence, 401);
+    EXPECT_EQ(info->session, session);
+    EXPECT_EQ(info->locates, 3);
+    EXPECT_EQ(info->orders, market.get_book(1).order_count() + market.get_book(2).order_count() + market.get_book(3).order_count());
+    EXPECT_TRUE(loaded == market);
+    EXPECT_EQ(loaded.bbo().bid_price[1], market.bbo().bid_price[1]);
+
+    // orders come back in time priority
+    EXPECT_EQ(by_priority(loaded.get_book(2)), by_priority(market.get_book(2)));
+
+    // fields back to back and big-endian, the same bytes from any host
+    EXPECT_EQ(snapshot.size(), recovery::snapshot_header_size + info->locates * recovery::locate_orders_size + info->orders * recovery::saved_order_size);
+    std::size_t pos{recovery::snapshot_magic.size()};
+    EXPECT_EQ(util::extract_be<std::uint64_t>(snapshot, pos), 401);
+
+    book::Market truncated{};
+    EXPECT_FALSE(recovery::load_snapshot(std::span{snapshot}.first(snapshot.size() - 1), truncated));
+}
+
+TEST(Recovery, SnapshotCarriesSymbolsAndLadders)
+{
+    FileBuilder file{};
+    file.stock_directory(7, 0x4141504c20202020);
+    file.stock_directory(8, 0x4d53465420202020);
+    file.add(7, 1, 'B', 100, 10010);
+    book::Market market{};
+    market.select_ladder(itch::to_symbol("AAPL"), book::liquid_ladder);
+    apply_packet(market, packets(blocks(file), 1000).front());
+
+    // no --dense-ladder on the joining side, the snapshot brings the server's
+    book::Market loaded{};
+    const auto info{recovery::load_snapshot(recovery::encode_snapshot(market, session, 4), loaded)};
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->locates, 2);
+    EXPECT_EQ(loaded.symbol(7), itch::to_symbol("AAPL"));
+    EXPECT_EQ(loaded.symbol(8), itch::to_symbol("MSFT"));
+    EXPECT_FALSE(loaded.symbol(9));
+    EXPECT_EQ(loaded.get_book(7).ladder(), book::liquid_ladder);
+    EXPECT_EQ(loaded.get_book(8).ladder(), book::LadderProfile{});
+    EXPECT_TRUE(loaded == market);
+
+    // a directory message replayed after the load keeps the dense ladder
+    itch::StockDirectoryMessage directory{};
+    directory.header.stock_locate = 7;
+    directory.symbol = itch::to_symbol("AAPL");
+    loaded.on_stock_directory(directory);
+    EXPECT_EQ(loaded.get_book(7).ladder(), book::liquid_ladder);
+}
+
+TEST(Recovery, SnapshotFromAServer)
+{
+    const auto file{orders(100)};
+    book::Market market{};
+    apply_packet(market, packets(blocks(file), 1000).front());
+    const auto snapshot{recovery::encode_snapshot(market, session, 101)};
+
+    // stand-in server: one snapshot per connection, then close
+    FD listener{socket(AF_INET, SOCK_STREAM, 0)};
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t length{sizeof(addr)};
+    ASSERT_EQ(getsockname(listener.fd(), reinterpret_cast<sockaddr*>(&addr), &length), 0);
+    ASSERT_EQ(listen(listener.fd(), 1), 0);
+    std::jthread server{[&] {
+        FD client{accept(listener.fd(), nullptr, nullptr)};
+        for (std::size_t sent = 0; sent < snapshot.size();)
+        {
+            const auto n{write(client.fd(), snapshot.data() + sent, snapshot.size() - sent)};
+            if (n <= 0)
+            {
+                return;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+    }};
+
+    const auto fetched{recovery::fetch_snapshot("tcp://127.0.0.1:" + std::to_string(static_cast<unsigned>(ntohs(addr.sin_port))))};
+    ASSERT_TRUE(fetched);
+    EXPECT_EQ(*fetched, snapshot);
+
+    EXPECT_FALSE(recovery::fetch_snapshot("tcp://127.0.0.1"));
+    EXPECT_FALSE(recovery::fetch_snapshot("tcp://localhost:1"));
+}
+
+TEST(Recovery, SnapshotFetchStopsOnASilentServer)
+{
+    // accepts through the backlog and never sends a byte
+    FD listener{socket(AF_INET, SOCK_STREAM, 0)};
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener.fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t length{sizeof(addr)};
+    ASSERT_EQ(getsockname(listener.fd(), reinterpret_cast<sockaddr*>(&addr), &length), 0);
+    ASSERT_EQ(listen(listener.fd(), 1), 0);
+
+    std::stop_source stop{};
+    std::jthread stopper{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+        stop.request_stop();
+    }};
+    const auto start{std::chrono::steady_clock::now()};
+    EXPECT_FALSE(recovery::fetch_snapshot("tcp://127.0.0.1:" + std::to_string(static_cast<unsigned>(ntohs(addr.sin_port))), stop.get_token()));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{2});
+}
+
+TEST(Recovery, LateJoinReplaysFromTheSnapshot)
+{
+    const auto file{orders(400)};
+    const auto messages{blocks(file)};
+    const auto stream{packets(messages, 5)};
+    book::Market full{};
+    for (const auto& packet : stream)
+    {
+        apply_packet(full, packet);
+    }
+
+    // the snapshot lands mid-packet, the held packets start well before it
+    const auto path{snapshot_of(messages, 203)};
+    book::Market market{};
+    recovery::LateJoin join{path, market, 1024 * 1024};
+    late_join(join, market, stream, 20, 60);
+
+    EXPECT_TRUE(market == full);
+    const auto report{join.report()};
+    EXPECT_EQ(report.snapshot.sequence, 203);
+    EXPECT_EQ(report.held_packets, 40);
+    EXPECT_EQ(report.missed_messages, 0);
+    EXPECT_GE(report.live, report.loaded);
+    std::filesystem::remove(path);
+}
+
+TEST(Recovery, LateJoinReportsWhatItMissed)
+{
+    const auto file{orders(400)};
+    const auto messages{blocks(file)};
+    const auto stream{packets(messages, 5)};
+
+    // the feed is already past the snapshot when the first packet is held
+    const auto path{snapshot_of(messages, 203)};
+    book::Market market{};
+    recovery::LateJoin join{path, market, 1024 * 1024};
+    late_join(join, market, stream, 42, 60);
+    EXPECT_EQ(join.report().missed_messages, 8);
+
+    // the buffer bounds what is held, no snapshot fails the join
+    book::Market small{};
+    recovery::LateJoin full_buffer{path, small, stream[0].size()};
+    EXPECT_FALSE(full_buffer.hold(stream[0]));
+
+    book::Market nothing{};
+    recovery::LateJoin missing{path + ".missing", nothing, 1024};
+    while (missing.catch_up([](std::span<const std::byte>) {}))
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(missing.live());
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <itch/parser.h>
+#include <replay/checkpoint.h>
+#include <replay/index.h>
+#include <replay/itch_file.h>
+#include <replay/replay.h>
+
+#include "file_builder.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+// deterministic mix over many locates with skewed activity
+FileBuilder make_day()
+{
+    FileBuilder file{};
+    std::uint64_t state{12345};
+    const auto next{[&] {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state >> 33);
+    }};
+
+    std::vector<std::pair<std::uint16_t, std::uint64_t>> live{};
+    std::uint64_t ref{1};
+    file.system_event();
+    for (int i = 0; i < 20000; ++i)
+    {
+        file.set_time(1000 + static_cast<std::uint64_t>(i / 3) * 10);
+        const auto op{next() % 10};
+        if (op < 4 || live.empty())
+        {
+            const auto locate{static_cast<std::uint16_t>(next() % 3 == 0 ? 1 : 1 + next() % 200)};
+            file.add(locate, ref, next() % 2 == 0 ? 'B' : 'S', 100 + next() % 400, 10000 + next() % 50);
+            live.emplace_back(locate, ref++);
+            continue;
+        }
+
+        const auto pick{next() % live.size()};
+        const auto [locate, order]{live[pick]};
+        switch (op)
+        {
+        case 4:
+        case 5:
+            file.execute(locate, order, next() % 300);
+            break;
+        case 6:
+            file.cancel(locate, order, next() % 300);
+            break;
+        case 7:
+            file.remove(locate, order);
+            live.erase(live.begin() + static_cast<std::ptrdiff_t>(pick));
+            break;
+        default:
+            file.replace(locate, order, ref, 100 + next() % 400, 10000 + next() % 50);
+            live[pick].second = ref++;
+            break;
+        }
+    }
+    return file;
+}
+
+std::string write_archive(std::span<const std::byte> bytes, const std::string& name)
+{
+    const auto path{(std::filesystem::temp_directory_path() / name).string()};
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return path;
+}
+
+} // namespace
+
+TEST(Replay, PartitionCoversEveryLocateOnce)
+{
+    auto file{make_day()};
+    file.truncate(5);
+
+    std::size_t book_messages{0};
+    std::size_t messages{0};
+    replay::for_each_message(file.bytes(), [&](std::uint64_t, itch::MessageType type, std::span<const std::byte>) {
+        ++messages;
+        book_messages += type != itch::MessageType::SystemEvent ? 1 : 0;
+    });
+    EXPECT_EQ(messages, 20000);
+
+    const auto shards{replay::partition(file.bytes(), 4)};
+    ASSERT_EQ(shards.size(), 4);
+
+    std::set<std::uint16_t> seen{};
+    std::size_t offsets{0};
+    for (const auto& shard : shards)
+    {
+        EXPECT_FALSE(shard.locates.empty());
+        for (const auto locate : shard.locates)
+        {
+            EXPECT_TRUE(seen.insert(locate).second);
+        }
+        offsets += shard.offsets.size();
+    }
+    EXPECT_EQ(offsets, book_messages);
+}
+
+TEST(Replay, ParallelMatchesSequential)
+{
+    const auto file{make_day()};
+
+    auto sequential{std::make_unique<book::Market>()};
+    replay::rebuild(file.bytes(), replay::partition(file.bytes(), 1), *sequential);
+
+    auto parallel{std::make_unique<book::Market>()};
+    const auto summary{replay::run(file.bytes(), 4, *parallel)};
+
+    EXPECT_EQ(summary.locates, 200);
+    EXPECT_GT(sequential->get_book(1).order_count(), 0);
+    EXPECT_TRUE(*sequential == *parallel);
+}
+
+TEST(Replay, AppliesTheDirectoryAndAuctionsLikeTheFeed)
+{
+    FileBuilder file{};
+    file.system_event();
+    file.stock_directory(7, 0x4141504c20202020);
+    file.stock_directory(8, 0x4d53465420202020);
+    file.noii(7, 5000, 1200, 10025);
+    file.add(7, 1, 'B', 100, 10010);
+    file.add(8, 2, 'S', 100, 20010);
+    file.trade(7, 300, 42, 10020);
+
+    auto market{std::make_unique<book::Market>()};
+    market->select_ladder(itch::to_symbol("AAPL"), book::liquid_ladder);
+    replay::run(file.bytes(), 4, *market);
+
+    EXPECT_EQ(market->get_book(7).ladder(), book::liquid_ladder);
+    const auto* auction{market->auctions().find(7)};
+    ASSERT_NE(auction, nullptr);
+    EXPECT_EQ(auction->imbalance_shares, 1200);
+    EXPECT_EQ(market->get_book(7).best_bid()->price, 10010);
+    EXPECT_EQ(market->get_book(8).ladder(), book::LadderProfile{});
+    EXPECT_EQ(market->get_book(8).best_ask()->price, 20010);
+}
+
+TEST(Replay, SkipsRecordsTooShortForAHeader)
+{
+    FileBuilder file{};
+    file.add(3, 1, 'B', 100, 10000);
+    std::vector<std::byte> bytes(file.bytes().begin(), file.bytes().end());
+    // an add cut to one byte of its locate
+    bytes.insert(bytes.end(), {std::byte{0}, std::byte{2}, std::byte{'A'}, std::byte{0}});
+    bytes.shrink_to_fit();
+
+    const auto shards{replay::partition(bytes, 2)};
+    std::size_t offsets{0};
+    for (const auto& shard : shards)
+    {
+        offsets += shard.offsets.size();
+    }
+    EXPECT_EQ(offsets, 1);
+
+    book::Market market{};
+    replay::rebuild(bytes, shards, market);
+    EXPECT_EQ(market.get_book(3).order_count(), 1);
+}
+
+TEST(ReplayIndex, RangeMatchesFullScan)
+{
+    const auto file{make_day()};
+    const auto path{write_archive(file.bytes(), "l3_test_index.itch")};
+    const auto summary{replay::build_index(file.bytes(), replay::index_path(path), 16)};
+    ASSERT_TRUE(summary);
+    EXPECT_EQ(summary->messages, 20001);
+
+    const auto index{replay::Index::open(path)};
+    ASSERT_TRUE(index);
+
+    for (const auto locate : std::array<std::uint16_t, 5>{0, 1, 7, 200, 201})
+    {
+        for (const auto& [from, to] : {std::pair{0UL, 100000UL}, {20000UL, 20500UL}, {20005UL, 20005UL}, {40000UL, 30000UL}})
+        {
+            std::vector<std::uint64_t> expected{};
+            replay::for_each_message(file.bytes(), [&](std::uint64_t offset, itch::MessageType, std::span<const std::byte> body) {
+                const auto header{itch::parse_message_header(body)};
+                if (header.stock_locate == locate && header.timestamp >= from && header.timestamp <= to)
+                {
+                    expected.push_back(offset);
+                }
+            });
+
+            const auto found{index->range(locate, from, to)};
+            EXPECT_TRUE(std::ranges::equal(found, expected)) << locate << " " << from << "-" << to;
+        }
+    }
+
+    std::size_t visited{0};
+    index->for_each(1, 20000, 20500, [&](itch::MessageType, std::span<const std::byte> body) {
+        EXPECT_EQ(itch::parse_message_header(body).stock_locate, 1);
+        ++visited;
+    });
+    EXPECT_EQ(visited, index->range(1, 20000, 20500).size());
+    EXPECT_GT(visited, 0);
+
+    std::filesystem::remove(replay::index_path(path));
+    std::filesystem::remove(path);
+}
+
+TEST(ReplayIndex, RejectsStaleSidecar)
+{
+    auto file{make_day()};
+    const auto path{write_archive(file.bytes(), "l3_test_stale.itch")};
+    ASSERT_TRUE(replay::build_index(file.bytes(), replay::index_path(path)));
+
+    file.truncate(100);
+    write_archive(file.bytes(), "l3_test_stale.itch");
+    EXPECT_FALSE(replay::Index::open(path));
+
+    std::filesystem::remove(replay::index_path(path));
+    std::filesystem::remove(path);
+}
+
+TEST(ReplayCheckpoint, BookAtMatchesFullReplay)
+{
+    const auto file{make_day()};
+    const auto path{write_archive(file.bytes(), "l3_test_checkpoint.itch")};
+    ASSERT_TRUE(replay::build_index(file.bytes(), replay::index_path(path), 16));
+    const auto index{replay::Index::open(path)};
+    ASSERT_TRUE(index);
+
+    const auto summary{replay::build_checkpoints(*index, replay::checkpoint_path(path), 5000, 3)};
+    ASSERT_TRUE(summary);
+    EXPECT_GT(summary->checkpoints, 0);
+    const auto checkpoints{replay::Checkpoints::open(*index, path)};
+    ASSERT_TRUE(checkpoints);
+
+    for (const auto locate : std::array<std::uint16_t, 3>{1, 42, 300})
+    {
+        for (const auto at : std::array<std::uint64_t, 5>{0, 4999, 5000, 23456, 100000})
+        {
+            book::Book expected{};
+            replay::for_each_message(file.bytes(), [&](std::uint64_t, itch::MessageType type, std::span<const std::byte> body) {
+                const auto header{itch::parse_message_header(body)};
+                if (header.stock_locate == locate && header.timestamp <= at)
+                {
+                    replay::apply(expected, type, body);
+                }
+            });
+
+            EXPECT_TRUE(replay::book_at(*index, *checkpoints, locate, at) == expected) << locate << " at " << at;
+        }
+    }
+
+    std::filesystem::remove(replay::checkpoint_path(path));
+    std::filesystem::remove(replay::index_path(path));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <book/market.h>
+#include <signals/signals.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+void add(book::Market& market, std::uint16_t locate, std::uint64_t ref_num, std::uint32_t shares, std::uint32_t price, itch::Side side)
+{
+    market.get_book(locate).add(ref_num, shares, price, side);
+    market.refresh_signals(locate);
+}
+
+// registered alongside a built-in to show the set is just a type list
+struct TradeCount
+{
+    static constexpr std::string_view name{"trade_count"};
+    std::uint64_t trades{0};
+
+    void on_trade(std::uint32_t, std::uint32_t) noexcept
+    {
+        ++trades;
+    }
+    [[nodiscard]]
+    double value() const noexcept
+    {
+        return static_cast<double>(trades);
+    }
+};
+
+} // namespace
+
+TEST(Signals, OffUntilEnabled)
+{
+    book::Market market{};
+    EXPECT_EQ(market.signals(), nullptr);
+    add(market, 1, 1, 100, 10000, itch::Side::Buy);
+    market.record_trade(1, 10000, 100);
+
+    market.enable_signals();
+    ASSERT_NE(market.signals(), nullptr);
+    EXPECT_TRUE(std::isnan(market.signals()->value<signals::Spread>(1)));
+}
+
+TEST(Signals, TopSignalsFollowTheBook)
+{
+    book::Market market{};
+    market.enable_signals();
+    const auto& stage{*market.signals()};
+
+    add(market, 7, 1, 300, 10000, itch::Side::Buy);
+    EXPECT_TRUE(std::isnan(stage.value<signals::Imbalance>(7)));
+    EXPECT_DOUBLE_EQ(stage.value<signals::BidDepthRatio>(7), 1.0);
+
+    add(market, 7, 2, 100, 10100, itch::Side::Sell);
+    EXPECT_DOUBLE_EQ(stage.value<signals::Spread>(7), 100.0);
+    EXPECT_DOUBLE_EQ(stage.value<signals::Imbalance>(7), 0.5);
+    // leans toward the ask, the thinner side
+    EXPECT_DOUBLE_EQ(stage.value<signals::Microprice>(7), (10000.0 * 100 + 10100.0 * 300) / 400);
+
+    add(market, 7, 3, 100, 9900, itch::Side::Buy);
+    add(market, 7, 4, 200, 9800, itch::Side::Buy);
+    EXPECT_DOUBLE_EQ(stage.value<signals::BidDepthRatio>(7), 300.0 / 600);
+
+    // beyond the fifth level does not count
+    for (std::uint32_t level = 0; level < 4; ++level)
+    {
+        add(market, 7, 10 + level, 1000, 10200 + level * 100, itch::Side::Sell);
+    }
+    EXPECT_DOUBLE_EQ(stage.value<signals::AskDepthRatio>(7), 100.0 / 4100);
+    add(market, 7, 20, 1000, 10700, itch::Side::Sell);
+    EXPECT_DOUBLE_EQ(stage.value<signals::AskDepthRatio>(7), 100.0 / 4100);
+
+    market.get_book(7).remove(2);
+    market.refresh_signals(7);
+    EXPECT_DOUBLE_EQ(stage.value<signals::Spread>(7), 200.0);
+    EXPECT_DOUBLE_EQ(stage.value<signals::AskDepthRatio>(7), 1000.0 / 5000);
+
+    // other locates untouched
+    EXPECT_TRUE(std::isnan(stage.value<signals::Spread>(8)));
+}
+
+TEST(Signals, TradeVwapAccumulatesPrints)
+{
+    book::Market market{};
+    market.enable_signals();
+    market.record_trade(3, 10000, 100);
+    market.record_trade(3, 10400, 300);
+
+    const auto values{market.signals()->values(3)};
+    const auto vwap{std::ranges::find(signals::Stage::names, "trade_vwap") - signals::Stage::names.begin()};
+    EXPECT_DOUBLE_EQ(values[static_cast<std::size_t>(vwap)], 10300.0);
+}
+
+TEST(Signals, RegistryTakesUserSignals)
+{
+    signals::Registry<signals::Spread, TradeCount> registry{};
+    static_assert(decltype(registry)::names[1] == "trade_count");
+
+    book::Book book{};
+    book.add(1, 10, 500, itch::Side::Buy);
+    book.add(2, 10, 600, itch::Side::Sell);
+    registry.on_book(2, book);
+    registry.on_trade(2, 600, 10);
+    registry.on_trade(2, 600, 5);
+
+    EXPECT_DOUBLE_EQ(registry.value<signals::Spread>(2), 100.0);
+    EXPECT_DOUBLE_EQ(registry.value<TradeCount>(2), 2.0);
+    EXPECT_DOUBLE_EQ(registry.value<TradeCount>(3), 0.0);
+}
+
+TEST(Signals, BboBookFeedsTouchSignals)
+{
+    book::BasicMarket<book::Bbo> market{};
+    market.enable_signals();
+    market.get_book(2).add(1, 100, 10000, itch::Side::Buy);
+    market.get_book(2).add(2, 300, 10050, itch::Side::Sell);
+    market.refresh_signals(2);
+
+    EXPECT_DOUBLE_EQ(market.signals()->value<signals::Spread>(2), 50.0);
+    EXPECT_DOUBLE_EQ(market.signals()->value<signals::Imbalance>(2), -0.5);
+    // one level is all a bbo book shows
+    EXPECT_DOUBLE_EQ(market.signals()->value<signals::BidDepthRatio>(2), 1.0);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <util/spsc_ring.h>
+
+#include <cstdint>
+#include <thread>
+
+TEST(SpscRing, PushPopInOrder)
+{
+    util::SpscRing<int, 4> ring{};
+    int out{};
+
+    EXPECT_FALSE(ring.try_pop(out));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(ring.try_push(i));
+    }
+    EXPECT_FALSE(ring.try_push(4));
+    EXPECT_EQ(ring.size(), 4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(ring.try_pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_FALSE(ring.try_pop(out));
+}
+
+TEST(SpscRing, CrossThread)
+{
+    util::SpscRing<std::uint64_t, 64> ring{};
+    constexpr std::uint64_t count{10'000};
+
+    std::jthread producer{[&ring] {
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            while (!ring.try_push(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    std::uint64_t expected{0};
+    std::uint64_t out{};
+    while (expected < count)
+    {
+        if (ring.try_pop(out))
+        {
+            ASSERT_EQ(out, expected);
+            ++expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}